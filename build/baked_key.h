@@ -0,0 +1,67 @@
+/* Generated by bake_key from private.pem: do not edit.
+   2048-bit modulus, e = 65537 in a chain of 18 steps, window 1. */
+#ifndef __BAKED_KEY__
+#define __BAKED_KEY__
+
+#include "rsa.h"
+
+#if WORD_SIZE != 2
+  #error baked_key was baked for WORD_SIZE 2
+#endif
+#if BN_MAX_BITS < 4096
+  #error baked_key needs BN_MAX_BITS of 4096
+#endif
+#if BN_CHAIN_MAX_WINDOW < 1
+  #error baked_key needs BN_CHAIN_MAX_WINDOW of 1
+#endif
+
+static const DTYPE baked_key_n[128] = {
+  0xb4b1, 0x89ad, 0xe0a3, 0xd8fd, 0xd327, 0x0a0f, 0x3689, 0x1856,
+  0xfe4f, 0x0aa3, 0xc8ec, 0x621a, 0x7784, 0x7b87, 0xfa90, 0x21ff,
+  0xb1c7, 0x9b01, 0x2314, 0x9a31, 0xdc90, 0xb7f6, 0x47c6, 0x762a,
+  0xb592, 0x8866, 0xaba6, 0x904d, 0xb311, 0x14b8, 0xfd07, 0x3f93,
+  0xb9f3, 0xf966, 0x5d6a, 0xf7d6, 0x6f82, 0x1827, 0x435b, 0x71eb,
+  0x7d5f, 0x1745, 0xe8de, 0x9dee, 0x9085, 0x0329, 0x23a9, 0x2021,
+  0xa00c, 0x8c75, 0xcdd1, 0x8bc7, 0xb7ca, 0xdfb9, 0xe648, 0xe242,
+  0xf960, 0x03ad, 0x24ac, 0x1a33, 0xfcaf, 0x0661, 0x6134, 0xa9f5,
+  0xda89, 0x7995, 0x7f91, 0xcfc3, 0x7020, 0x50d7, 0x126f, 0x3c9f,
+  0x36f8, 0x7d27, 0x34a0, 0xa35a, 0x7be3, 0x5194, 0x4536, 0x2b0c,
+  0xff85, 0x234f, 0x644c, 0x28ad, 0x7010, 0x8677, 0x4928, 0x9449,
+  0x5770, 0x730b, 0xbfd5, 0x185b, 0xbf7a, 0x4614, 0x53db, 0xa244,
+  0x6aca, 0x68be, 0xf659, 0xcca5, 0xbefe, 0xd38a, 0xa0d7, 0xe488,
+  0x768a, 0xa73e, 0xbea5, 0x0287, 0x0b66, 0xb2d1, 0x9599, 0xde26,
+  0x2643, 0xe451, 0x5986, 0x3a37, 0x8265, 0xe129, 0x0d77, 0x56b7,
+  0xa462, 0x17ef, 0x35b8, 0xc1ff, 0x2f90, 0xc182, 0xfac0, 0xf4f8
+};
+static const DTYPE baked_key_rr[128] = {
+  0xe092, 0xe2f5, 0xbf2d, 0xbdbc, 0x5dc9, 0x111b, 0x4297, 0x500a,
+  0x9dae, 0x42bc, 0x53ff, 0x4c85, 0xf412, 0x1a60, 0x6163, 0x6ec9,
+  0x86d7, 0x8bb1, 0xaf09, 0x7861, 0x6a0f, 0xa115, 0x5ca5, 0x475c,
+  0xf3f9, 0xe89e, 0x3b21, 0xe4ff, 0x1250, 0x2777, 0x71ee, 0x533e,
+  0x81c5, 0x59dc, 0xd4ba, 0xf03d, 0x6ca5, 0x55f3, 0xda42, 0x1e3e,
+  0x290e, 0x2c57, 0xd232, 0x8df3, 0x92d6, 0x962c, 0x604e, 0xf269,
+  0xde40, 0xecfd, 0x2833, 0x9a3a, 0xb513, 0x712a, 0x34bc, 0xbbfc,
+  0xd657, 0xb7a4, 0x8058, 0x37cc, 0xb96a, 0xde4d, 0xf9ee, 0x0817,
+  0xd477, 0x359e, 0x3d69, 0xd95a, 0x83bb, 0x339f, 0x2938, 0x3f19,
+  0x9b03, 0x8e9d, 0x5f7f, 0xdffa, 0x465c, 0x2152, 0xe5cc, 0x3061,
+  0x769c, 0xcde2, 0x5b46, 0xf27f, 0xdfc2, 0xf906, 0xe58f, 0xe699,
+  0xbb94, 0x4854, 0x5e5a, 0x1137, 0x7a2c, 0x11cd, 0x52c6, 0x6519,
+  0x1c20, 0x4f9d, 0xf5ff, 0xd76b, 0x66c4, 0x525c, 0xf907, 0xac82,
+  0x5f79, 0x18ed, 0x2f62, 0xa052, 0x94f1, 0x09f6, 0x9805, 0x0221,
+  0x36ad, 0x38ef, 0x2f13, 0xd6ce, 0xec2d, 0x1228, 0x1e58, 0x1c54,
+  0xa974, 0xc4db, 0x666b, 0x0a6b, 0xa0c9, 0xdafd, 0xb148, 0xd8ba
+};
+static const unsigned char baked_key_chain[19] = {
+  1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 1
+};
+
+static const struct rsa_pub baked_key = {
+  .mont = { .n = baked_key_n, .rr = baked_key_rr, .len = 128, .n0 = 0xebaf },
+  .nlen = 256,
+  .e = 65537,
+  .chain = baked_key_chain,
+  .chain_len = sizeof baked_key_chain
+};
+
+#endif
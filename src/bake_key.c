@@ -0,0 +1,172 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bn.h"
+#include "pem.h"
+#include "rsa.h"
+#include "util.h"
+
+/*  Host tool: turns a key file into a header of const key contexts for a
+    target build, so that the target never converts or reduces its key.
+
+      bake_key [-w WORD_SIZE] [-c WINDOW] KEYFILE [NAME] > NAME.h
+
+    The limbs are written as integer literals of the target's WORD_SIZE, so
+    the target's compiler lays them out in its own byte order. */
+
+#define MAX_CHAIN 256
+
+/* Sliding-window chain for e (see bignum_mont_exp_chain); its length */
+static uint16_t chain_build(uint32_t e, unsigned w, unsigned char* chain)
+{
+  uint16_t len = 1;
+  int32_t i = 31, j, k;
+  bool loaded = false;
+
+  chain[0] = (unsigned char)w;
+  while (i >= 0 && !((e >> i) & 1)) --i;
+  while (i >= 0) {
+    if (!((e >> i) & 1)) {
+      chain[len++] = 0;
+      --i;
+      continue;
+    }
+    /*  the longest window of at most w bits ending in a one */
+    for (j = i - (int32_t)w + 1 < 0 ? 0 : i - (int32_t)w + 1; !((e >> j) & 1); ++j);
+    if (loaded)
+      for (k = j; k <= i; ++k) chain[len++] = 0;
+    chain[len++] = (unsigned char)((e >> j) & ((2u << (i - j)) - 1));
+    loaded = true;
+    i = j - 1;
+  }
+  return len;
+}
+
+/* Montgomery products to run the chain, the odd powers included */
+static uint32_t chain_cost(const unsigned char* chain, uint16_t len)
+{
+  uint32_t cost = chain[0] > 1 ? 1u << (chain[0] - 1) : 0;
+  uint16_t i;
+  for (i = 2; i < len; ++i) ++cost;
+  return cost;
+}
+
+/* The nbytes big-endian bytes as s limbs of ws bytes, least significant first */
+static void print_limbs(const char* name, const char* what, const unsigned char* bytes, uint32_t nbytes,
+                        unsigned ws, uint32_t s)
+{
+  uint32_t i, j;
+
+  printf("static const DTYPE %s_%s[%u] = {", name, what, s);
+  for (i = 0; i < s; ++i) {
+    uint32_t w = 0;
+    for (j = 0; j < ws; ++j)
+      if (i * ws + j < nbytes) w |= (uint32_t)bytes[nbytes - 1 - (i * ws + j)] << (8 * j);
+    printf("%s0x%0*x%s", i % 8 ? " " : "\n  ", 2 * ws, w, i + 1 < s ? "," : "\n");
+  }
+  printf("};\n");
+}
+
+#ifdef BAKE_KEY_MAIN
+int main(int argc, char** argv)
+{
+  static unsigned char rr[BN_MAX_BITS / 16], chain[MAX_CHAIN], best[MAX_CHAIN];
+  static char guard[64];
+  const char *path = NULL, *name = "baked_key";
+  unsigned ws = WORD_SIZE, window = BN_CHAIN_MAX_WINDOW, w;
+  uint32_t e = 0, s, i, n0, inv, bits;
+  uint16_t len, best_len = 0;
+  struct key_file f;
+  struct rsa_key_view v;
+  struct rsa_pub pub;
+  struct bn *two, *c;
+  DTYPE rbits[2];
+  int a;
+
+  for (a = 1; a < argc; ++a) {
+    if (!strcmp(argv[a], "-w") && a + 1 < argc) ws = (unsigned)atoi(argv[++a]);
+    else if (!strcmp(argv[a], "-c") && a + 1 < argc) window = (unsigned)atoi(argv[++a]);
+    else if (!path) path = argv[a];
+    else name = argv[a];
+  }
+  if (!path || (ws != 1 && ws != 2 && ws != 4) || window < 1 || window > 7) {
+    fprintf(stderr, "usage: %s [-w 1|2|4] [-c WINDOW] KEYFILE [NAME]\n", argv[0]);
+    return 2;
+  }
+
+  for (i = 0; name[i] && i + 1 < sizeof guard; ++i)
+    guard[i] = name[i] >= 'a' && name[i] <= 'z' ? (char)(name[i] - 'a' + 'A') : name[i];
+
+  if (!key_file_open(&f, path) || key_file_next(&f, &v) != 1) {
+    fprintf(stderr, "%s: no key\n", path);
+    return 1;
+  }
+  if (!arena_init(NULL, RSA_PUB_BYTES(BN_MAX_BITS / 2, WORD_SIZE) + RSA_POOL_BYTES(BN_MAX_BITS / 2, WORD_SIZE)))
+    return 1;
+  bignum_pool_init(RSA_POOL_COUNT(BN_MAX_BITS / 2, WORD_SIZE));
+  if (!rsa_pub_from_view(&pub, &v) || pub.e < 3) {
+    fprintf(stderr, "%s: unusable key (even modulus, too large, or e < 3)\n", path);
+    return 1;
+  }
+  e = pub.e;
+  s = (v.n.len + ws - 1) / ws;
+  bits = 8 * v.n.len;
+
+  /*  R^2 mod n for the target's R = 2^(8 ws s): a power of two, which the
+      host works out in its own Montgomery form */
+  two = bignum_tmp_get();
+  c = bignum_tmp_get();
+  bignum_from_int(two, 2);
+  for (i = 0; i < 2; ++i) rbits[i] = (DTYPE)(8 * WORD_SIZE * i < 32 ? (16 * ws * s) >> (8 * WORD_SIZE * i) : 0);
+  bignum_mont_exp(&pub.mont, two, rbits, sizeof rbits / sizeof *rbits, c);
+  bignum_to_bytes(c, rr, v.n.len);
+
+  /*  where the target's R is the host's, rsa_pub_init worked out the same */
+  if (ws * s == WORD_SIZE * pub.mont.len) {
+    bignum_from_limbs(c, pub.mont.rr, pub.mont.len);
+    bignum_to_bytes(c, (unsigned char*)two->array, v.n.len);
+    if (memcmp(two->array, rr, v.n.len)) {
+      fprintf(stderr, "%s: R^2 mod n disagrees with rsa_pub_init\n", path);
+      return 1;
+    }
+  }
+
+  /*  -1/n mod 2^(8 ws) by Newton's iteration, each step doubling the bits */
+  n0 = v.n.p[v.n.len - 1] | (v.n.len > 1 ? v.n.p[v.n.len - 2] << 8 : 0) |
+       (v.n.len > 2 ? (uint32_t)v.n.p[v.n.len - 3] << 16 : 0) | (v.n.len > 3 ? (uint32_t)v.n.p[v.n.len - 4] << 24 : 0);
+  for (inv = n0, i = 0; i < 4; ++i) inv *= 2 - n0 * inv;
+  n0 = (0u - inv) & (uint32_t)((1ull << (8 * ws)) - 1);
+
+  /*  the cheapest window the target's stack allows */
+  for (w = 1; w <= window; ++w) {
+    len = chain_build(e, w, chain);
+    if (!best_len || chain_cost(chain, len) < chain_cost(best, best_len)) {
+      memcpy(best, chain, len);
+      best_len = len;
+    }
+  }
+
+  printf("/* Generated by bake_key from %s: do not edit.\n", path);
+  printf("   %u-bit modulus, e = %u in a chain of %u steps, window %u. */\n", bits, e, best_len - 1, best[0]);
+  printf("#ifndef __%s__\n#define __%s__\n\n#include \"rsa.h\"\n\n", guard, guard);
+  printf("#if WORD_SIZE != %u\n  #error %s was baked for WORD_SIZE %u\n#endif\n", ws, name, ws);
+  printf("#if BN_MAX_BITS < %u\n  #error %s needs BN_MAX_BITS of %u\n#endif\n", 2 * bits, name, 2 * bits);
+  printf("#if BN_CHAIN_MAX_WINDOW < %u\n  #error %s needs BN_CHAIN_MAX_WINDOW of %u\n#endif\n\n", best[0], name, best[0]);
+  print_limbs(name, "n", v.n.p, v.n.len, ws, s);
+  print_limbs(name, "rr", rr, v.n.len, ws, s);
+  printf("static const unsigned char %s_chain[%u] = {", name, best_len);
+  for (i = 0; i < best_len; ++i) printf("%s%u%s", i % 16 ? " " : "\n  ", best[i], i + 1 < best_len ? "," : "\n");
+  printf("};\n\n");
+  printf("static const struct rsa_pub %s = {\n", name);
+  printf("  .mont = { .n = %s_n, .rr = %s_rr, .len = %u, .n0 = 0x%0*x },\n", name, name, s, 2 * ws, n0);
+  printf("  .nlen = %u,\n  .e = %u,\n", v.n.len, e);
+  printf("  .chain = %s_chain,\n  .chain_len = sizeof %s_chain\n};\n\n#endif\n", name, name);
+
+  bignum_tmp_put(c);
+  bignum_tmp_put(two);
+  arena_release();
+  key_file_close(&f);
+  return ferror(stdout) != 0;
+}
+#endif
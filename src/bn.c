@@ -1,905 +1,1476 @@
-
-#include <stdbool.h>
-#include <stdint.h>
-#include <stdlib.h>
-
-#include "bn.h"
-#include "sha1.h"
-#include "util.h"
-
-
-
-struct karatsuba_ctx karatsuba_ctx;
-
-
-/* Functions for shifting number in-place. */
-static void _lshift_one_bit(struct bn* a);
-static void _rshift_one_bit(struct bn* a);
-static void _lshift_word(struct bn* a, int nwords);
-static void _rshift_word(struct bn* a, int nwords);
-#ifdef IMPLEMENT_ALL
-static void bignum_dec_unsigned(struct bn* a);
-static void bignum_inc_unsigned(struct bn* a);
-#endif
-void print_arr(const struct bn*);
-
-/* Public / Exported functions. */
-void bignum_init(struct bn* n)
-{
-    require(n, "n is null");
-
-    n->len = 0;
-}
-
-void bignum_from_int(struct bn* n, DTYPE_TMP i)
-{
-    require(n, "n is null");
-
-    bignum_init(n);
-
-    /* Endianness issue if machine is not little-endian? */
-#ifdef WORD_SIZE
-#if (WORD_SIZE == 1)
-    n->array[0] = (i & 0x000000ff);
-    n->array[1] = (i & 0x0000ff00) >> 8;
-    n->array[2] = (i & 0x00ff0000) >> 16;
-    n->array[3] = (i & 0xff000000) >> 24;
-#elif (WORD_SIZE == 2)
-    n->array[0] = (i & 0x0000ffff);
-    if (n->array[0]) n->len = 1;
-    n->array[1] = (i & 0xffff0000) >> 16;
-    if (n->array[1]) n->len = 2;
-#elif (WORD_SIZE == 4)
-    n->array[0] = i;
-    DTYPE_TMP num_32 = 32;
-    DTYPE_TMP tmp = i >> num_32; /* bit-shift with U64 operands to force 64-bit results */
-    n->array[1] = tmp;
-#endif
-#endif
-}
-
-
-#ifdef IMPLEMENT_ALL
-uint32_t bignum_to_int(struct bn* n)
-{
-    require(n, "n is null");
-    require (!n->negative, "not implemented");
-
-    if (n->len == 0)
-        return 0;
-
-    uint32_t ret = 0;
-    /* Endianness issue if machine is not little-endian? */
-#if (WORD_SIZE == 1)
-    ret += n->array[0];
-    ret += n->array[1] << 8;
-    ret += n->array[2] << 16;
-    ret += n->array[3] << 24;  
-#elif (WORD_SIZE == 2)
-    ret += n->array[0];
-    if (n->len > 1)
-        ret += ((int32_t)n->array[1]) << 16;
-#elif (WORD_SIZE == 4)
-    ret += n->array[0];
-#endif
-
-    return ret;
-}
-
-
-void bignum_from_string(struct bn* n, char* str, int nbytes)
-{
-    require(n, "n is null");
-    require(str, "str is null");
-    require(nbytes > 0, "nbytes must be positive");
-    require((nbytes & 1) == 0, "string format must be in hex -> equal number of bytes");
-
-    bignum_init(n);
-
-    DTYPE tmp;                        /* DTYPE is defined in bn.h - uint{8,16,32,64}_t */
-    int i = nbytes - (2 * WORD_SIZE); /* index into string */
-    int j = 0;                        /* index into array */
-
-    /* reading last hex-byte "MSB" from string first -> big endian */
-    /* MSB ~= most significant byte / block ? :) */
-    while (i >= 0)
-    {
-        tmp = 0;
-        sscanf(&str[i], SSCANF_FORMAT_STR, &tmp);
-        n->array[j] = tmp;
-        i -= (2 * WORD_SIZE); /* step WORD_SIZE hex-byte(s) back in the string. */
-        j += 1;               /* step one element forward in the array. */
-    }
-    for (n->len = j; n->len > 0 && n->array[n->len-1] == 0; --n->len);
-}
-
-
-void bignum_to_string(struct bn* n, char* str, int nbytes)
-{
-    require(n, "n is null");
-    require(str, "str is null");
-    require(nbytes > 0, "nbytes must be positive");
-    require((nbytes & 1) == 0, "string format must be in hex -> equal number of bytes");
-    require (!n->negative, "only unsigned numbers can be converted to string");
-
-    if (n->len == 0)
-    {
-        memset(str, 0, nbytes);
-        *str = '0';
-        return;
-    }
-
-    int j = n->len - 1;
-    int i = 0;
-
-    while ((j >= 0) && (nbytes > (i + 1)))
-    {
-        sprintf(&str[i], SPRINTF_FORMAT_STR, n->array[j]);
-        i += (2 * WORD_SIZE);
-        j -= 1;
-    }
-    /* Count leading zeros: */
-    j = 0;
-    while (str[j] == '0')
-    {
-        j += 1;
-    }
-
-    /* Move string j places ahead, effectively skipping leading zeros */ 
-    for (i = 0; i < (nbytes - j); ++i)
-    {
-        str[i] = str[i + j];
-    }
-
-    /* Zero-terminate string */
-    str[i] = 0;
-}
-#endif
-
-#if !defined(BIG_ENDIAN) || !defined(__H8_2329F__)
-void bignum_to_bytes(const struct bn* n, unsigned char* bytes, uint32_t nbytes)
-{
-    require(n, "n is null");
-    require(bytes, "str is null");
-    require(nbytes > 0, "nbytes must be positive");
-
-    memset(bytes, 0, nbytes);
-    
-    /*
-    uint32_t i;
-    for ( i = BN_ARRAY_SIZE; i-- && n->array[i] == 0;);
-    */
-    uint32_t i = n->len;
-    uint32_t internal_len = i*WORD_SIZE;
-    unsigned char* internal = heap_get(internal_len);
-    uint32_t j = 0;
-    for (; i--; ++j) {
-        DTYPE d;
-        i2osp(&d, n->array+i, WORD_SIZE);
-        memcpy(internal+j*WORD_SIZE, &d, WORD_SIZE);
-    }
-
-    //require (nbytes <= internal_len, "not enough space");
-    if (nbytes < internal_len)
-        memcpy(bytes, internal + internal_len - nbytes, nbytes);
-    else
-        memcpy(bytes, internal, internal_len);
-        
-    heap_free(internal_len);
-}
-#endif
-
-void bignum_from_bytes(struct bn* n, const unsigned char* bytes, uint32_t nbytes)
-{
-    require(n, "n is null");
-    require(bytes, "bytes is null");
-    require(nbytes > 0, "nbytes null");
-
-    bignum_init(n);
-    uint32_t i = 0;
-    uint32_t j = nbytes;
-    /* printf("bignum_from_bytes start: \n"); */
-    while (j)
-    {
-        uint32_t p = j >= WORD_SIZE ? j - WORD_SIZE : 0;
-        DTYPE d = 0;
-        uint32_t k;
-        for (k = p; k < j; ++k)
-        {
-            /* printf("bignum_from_bytes: reading byte %d\n", bytes[k]); */
-            d += bytes[k];
-            if (k+1 < j)
-                d <<= 8;
-        }
-        /* printf("bignum_from_bytes: read word: %d\n", d); */
-        j = p;
-        n->array[i++] = d;
-    }
-    n->len = i;
-}
-
-#ifdef IMPLEMENT_ALL
-static void bignum_inc_unsigned(struct bn* n)
-{
-    require(n, "n is null");
-
-    if (bignum_is_zero(n))
-    {
-        n->array[0] = 1;
-        n->negative = false;
-        n->len = 1;
-        return;
-    }
-
-    DTYPE res;
-    DTYPE_TMP tmp; /* copy of n */
-    int i;
-    for (i = 0; i <= n->len; ++i)
-    {
-        tmp = n->array[i];
-        res = tmp + 1;
-        n->array[i] = res;
-
-        if (res > tmp)
-        {
-            break;
-        }
-    }
-    if (i == n->len+1 && n->array[n->len])
-        ++n->len;
-}
-
-static void bignum_dec_unsigned(struct bn* n)
-{
-    require(n, "n is null");
-
-    if (bignum_is_zero(n))
-    {
-        n->array[0] = 1;
-        n->negative = true;
-        n->len = 1;
-        return;
-    }
-
-    DTYPE tmp; /* copy of n */
-    DTYPE res;
-
-    int i;
-    for (i = 0; i < n->len; ++i)
-    {
-        tmp = n->array[i];
-        res = tmp - 1;
-        n->array[i] = res;
-
-        if (!(res > tmp))
-        {
-            break;
-        }
-    }
-    if (i == n->len-1)
-    {
-        for (; i >= 0 && n->array[i] == 0; --i);
-        n->len = i+1;
-    }
-}
-
-void bignum_inc(struct bn* n)
-{
-    require (n, "n is null");
-
-    if (n->negative)
-    {
-        bignum_dec_unsigned(n);
-        if (bignum_is_zero(n))
-            n->negative = false;
-    }
-    else
-    {
-        bignum_inc_unsigned(n);
-    }
-}
-
-void bignum_dec(struct bn* n)
-{
-    require (n, "n is null");
-    
-    if (n->negative)
-        bignum_inc_unsigned(n);
-    else
-        bignum_dec_unsigned(n);
-}
-
-#endif
-
-void bignum_add(struct bn* a, struct bn* b, struct bn* c)
-{
-    require(a, "a is null");
-    require(b, "b is null");
-    require(c, "c is null");
-
-    DTYPE_TMP tmp;
-    int carry = 0;
-    uint16_t maxlen = (a->len > b->len) ? a->len : b->len;
-    if (a->len < maxlen)
-        memset(a->array+a->len, 0, WORD_SIZE*(maxlen - a->len));
-    else if (b->len < maxlen)
-        memset(b->array+b->len, 0, WORD_SIZE*(maxlen - b->len));
-    for (uint16_t i = 0; i < maxlen; ++i)
-    {
-        tmp = ((DTYPE_TMP)a->array[i]) + b->array[i] + carry;
-        carry = (tmp > MAX_VAL);
-        c->array[i] = (tmp & MAX_VAL);
-    }
-    c->array[maxlen] = carry;
-    c->len = maxlen + (carry != 0);
-
-}
-
-
-void bignum_sub(struct bn* a, struct bn* b, struct bn* c)
-{
-    require(a, "a is null");
-    require(b, "b is null");
-    require(c, "c is null");
-
-    if (a->len < 1)
-    {
-        bignum_init(c);
-        return;
-    }
-    memset(b->array+b->len, 0, WORD_SIZE*(a->len-b->len));
-    DTYPE_TMP res;
-    DTYPE_TMP tmp1;
-    DTYPE_TMP tmp2;
-    int borrow = 0;
-    int i;
-    for (i = 0; i < a->len; ++i)
-    {
-        tmp1 = (DTYPE_TMP)a->array[i] + (MAX_VAL + 1); /* + number_base */
-        tmp2 = (DTYPE_TMP)b->array[i] + borrow;
-        res = (tmp1 - tmp2);
-        c->array[i] = (DTYPE)(res & MAX_VAL); /* "modulo number_base" == "% (number_base - 1)" if number_base is 2^N */
-        borrow = (res <= MAX_VAL);
-    }
-    uint16_t j = a->len;
-    while (j > 0)
-    {
-        --j;
-        if (c->array[j] != 0)
-            break;
-    }
-    if (c->array[j] != 0)
-        c->len = j+1;
-}
-
-
-
-void bignum_mul_naive(struct bn* a, struct bn* b, struct bn* c) {
-    require(a, "a is null");
-    require(b, "b is null");
-    require(c, "c is null");
-    
-
-    struct bn row;
-    struct bn tmp;
-    int i, j;
-
-    bignum_init(c);
-
-    for (i = 0; i < a->len; ++i)
-    {
-        bignum_init(&row);
-
-        for (j = 0; j < b->len; ++j)
-        {
-            bignum_init(&tmp);
-            DTYPE_TMP intermediate = ((DTYPE_TMP)a->array[i] * (DTYPE_TMP)b->array[j]);
-            bignum_from_int(&tmp, intermediate);
-            _lshift_word(&tmp, i + j);
-            bignum_add(&tmp, &row, &row);
-        }
-        bignum_add(c, &row, c);
-    }
-}
-
-static void bignum_split_at(const struct bn* a,
-                            uint16_t k,
-                            struct bn* lo,
-                            struct bn* hi)
-{
-    uint16_t alen = a->len;
-    uint16_t lo_len = (alen < k) ? alen : k;
-    uint16_t i;
-    for (i = 0; i < lo_len; ++i)
-        lo->array[i] = a->array[i];
-    lo->len = lo_len;
-
-    for (; i < alen; ++i)
-        hi->array[i-lo_len] = a->array[i];
-    hi->len = alen - lo_len;
-}
-
-void bignum_mul_karatsuba(struct bn* a, struct bn* b, struct bn* c) {
-    uint16_t alen = a->len, blen = b->len;
-    if (alen < 10 || blen < 10) {
-        bignum_mul_naive(a, b, c);
-        return;
-    }
-
-    uint16_t m = (alen > blen) ? alen : blen;
-    uint16_t m2 = (m/2) + (m%2);
-	
-    struct bn *pool = karatsuba_ctx.pool + karatsuba_ctx.idx;
-    karatsuba_ctx.idx += 9;
-
-    struct bn   *x1 = pool,
-                *x0 = pool+1,
-                *y1 = pool+2,
-                *y0 = pool+3,
-                *z0 = pool+4,
-                *z1 = pool+5,
-                *z2 = pool+6,
-                *t1 = pool+7,
-                *t2 = pool+8;
-
-	
-    for (uint8_t i = 0; i < 9; ++i)
-        bignum_init(pool+i);
-        
-    // printf("a = "); print_arr(a);
-    bignum_split_at(a, m2, x1, x0);
-
-    bignum_split_at(b, m2 ,y1, y0); // b = y1* 2^(M2) + y0, = y1, y
-
-
-    bignum_add(x1, x0, t1); // t1 = x0 + x1
-
-    bignum_add(y1, y0, t2); // t2 = y0 + y1
-
-
-    bignum_mul_karatsuba(x1, y1, z0);
-    bignum_mul_karatsuba(t1, t2, z1);
-    bignum_mul_karatsuba(x0, y0, z2);
-
-    bignum_add(z0, z2, t1);
-    require (bignum_cmp(z1, t1) != SMALLER, "632: exception");
-    bignum_sub(z1, t1, t2);
-
-    bignum_lshift(z2, z1, 2*m2*WORD_SIZE*8);
-    bignum_lshift(t2, t1, m2*WORD_SIZE*8);
-    bignum_add(z0, t1, z0);
-    bignum_add(z0, z1, z0);
-    bignum_assign(c, z0);
-
-    karatsuba_ctx.idx -= 9;
-}
-
-void bignum_div(struct bn* a, struct bn* b, struct bn* c)
-{
-    require(a, "a is null");
-    require(b, "b is null");
-    require(c, "c is null");
-    require (b->len > 0, "division by zero");
-    
-    struct bn *pool = heap_get(3 * sizeof(struct bn));
-    struct bn *current = pool;
-    struct bn *denom = pool+1;
-    struct bn *tmp = pool+2;
-    
-    bignum_from_int(current, 1);               /*  int current = 1; */
-    bignum_assign(denom, b);                   /*  denom = b */
-    bignum_assign(tmp, a);                     /*  tmp   = a */
-    
-    while (bignum_cmp(denom, a) != LARGER)     /*  while (denom <= a) { */
-    {
-        require (!(denom->len == BN_ARRAY_SIZE && denom->array[BN_ARRAY_SIZE - 1] >= 1 + (DTYPE_TMP)(MAX_VAL / 2)), "division overflow");
-
-        _lshift_one_bit(current);                /*    current <<= 1; */
-        _lshift_one_bit(denom);                  /*    denom <<= 1; */
-    }
-    _rshift_one_bit(denom);                  
-    _rshift_one_bit(current);                
-
-    bignum_init(c);                             /*  int answer = 0; */
-
-    while (!bignum_is_zero(current))           /*  while (current != 0) */
-    {
-        if (bignum_cmp(tmp, denom) != SMALLER)  /*    if (dividend >= denom) */
-        {
-            bignum_sub(tmp, denom, tmp);         /*      dividend -= denom; */
-            bignum_or(c, current, c);              /*      answer |= current; */
-        }
-        _rshift_one_bit(current);
-        _rshift_one_bit(denom);
-    }                                            /*  return answer; */
-    int16_t i;
-    for (i = c->len-1; i >= 0 && c->array[i] == 0; --i);
-    c->len = i+1;
-    
-    heap_free(3 * sizeof(struct bn));
-}
-
-void bignum_lshift(struct bn* a, struct bn* b, int nbits)
-{
-    require(a, "a is null");
-    require(b, "b is null");
-    require(nbits >= 0, "no negative shifts");
-
-    if (bignum_is_zero(a))
-    {
-        bignum_init(b);
-        return;
-    }
-
-
-    /* Handle shift in multiples of word-size */
-    const int nbits_pr_word = (WORD_SIZE * 8);
-    int nwords = nbits / nbits_pr_word;
-    if (nwords != 0)
-    {
-        _lshift_word(a, nwords);
-        nbits -= (nwords * nbits_pr_word);
-    }
-
-    if (nbits != 0)
-    {
-        a->array[a->len] = 0;
-        for (int16_t i = a->len; i > 0; --i)
-            a->array[i] = (a->array[i] << nbits) | (a->array[i - 1] >> ((8 * WORD_SIZE) - nbits));
-        a->array[0] <<= nbits;
-        if (a->array[a->len] > 0)
-            ++a->len;
-    }
-    bignum_assign(b, a);
-}
-
-void bignum_rshift(struct bn* a, struct bn* b, int nbits)
-{
-    require(a, "a is null");
-    require(b, "b is null");
-    require(nbits >= 0, "no negative shifts");
-
-    struct bn ba;
-    bignum_assign(&ba, a);
-    a = &ba;
-    
-    if (a->len == 0)
-    {
-        bignum_init(b);
-        return;
-    }
-
-    /* Handle shift in multiples of word-size */
-    const int nbits_pr_word = (WORD_SIZE * 8);
-    int nwords = nbits / nbits_pr_word;
-    if (nwords != 0)
-    {
-        _rshift_word(a, nwords);
-        nbits -= (nwords * nbits_pr_word);
-    }
-
-    if (nbits != 0)
-    {
-        int i;
-        for (i = 0; i < a->len - 1; ++i)
-        {
-            a->array[i] = (a->array[i] >> nbits) | (a->array[i + 1] << ((8 * WORD_SIZE) - nbits));
-        }
-        a->array[i] >>= nbits;
-        if (a->array[a->len-1] == 0)
-            --a->len;
-    }
-    bignum_assign(b, a);
-}
-
-
-void bignum_mod(struct bn* a, struct bn* b, struct bn* c)
-{
-    require(a, "a is null");
-    require(b, "b is null");
-    require(c, "c is null");
-
-    struct bn *tmp = heap_get(sizeof *tmp);
-
-    /* c = (a / b) */
-    bignum_div(a, b, c);
-
-    /* tmp = (c * b) */
-    bignum_mul(c, b, tmp);
-    /* c = a - tmp */
-    bignum_sub(a, tmp, c);
-
-    heap_free(sizeof *tmp);
-}
-
-
-#ifdef IMPLEMENT_ALL
-void bignum_and(struct bn* a, struct bn* b, struct bn* c)
-{
-    require(a, "a is null");
-    require(b, "b is null");
-    require(c, "c is null");
-    require (!(a->negative && b->negative), "not implemented");
-
-    struct bn *max, *min;
-    if (a->len > b->len)
-    {
-        max = a;
-        min = b;
-    }
-    else
-    {
-        max = b;
-        min = a;
-    }
-    if (max->len == 0)
-    {
-        bignum_init(c);
-        return;
-    }
-    for (int i = 0; i < min->len; ++i)
-        c->array[i] = (max->array[i] & min->array[i]);
-    if (min->len < max->len)
-        memset(c+min->len, 0, (max->len-min->len)*WORD_SIZE);
-    int16_t i;
-    for (i = min->len-1; i >= 0 && c->array[i] == 0; --i);
-    c->len = i+1;
-
-    // printf("bignum_and: c = "); print_arr(c);
-}
-
-#endif
-
-void bignum_or(struct bn* a, struct bn* b, struct bn* c)
-{
-    require(a, "a is null");
-    require(b, "b is null");
-    require(c, "c is null");
-
-    struct bn *max, *min;
-    if (a->len > b->len)
-    {
-        max = a;
-        min = b;
-    }
-    else
-    {
-        max = b;
-        min = a;
-    }
-    if (max->len == 0)
-    {
-        bignum_init(c);
-        return;
-    }
-    for (int i = 0; i < min->len; ++i)
-        c->array[i] = (max->array[i] | min->array[i]);
-    for (int i = min->len; i < max->len; ++i)
-        c->array[i] = max->array[i];
-    c->len = max->len;
-}
-
-#ifdef IMPLEMENT_ALL
-void bignum_xor(struct bn* a, struct bn* b, struct bn* c)
-{
-    require(a, "a is null");
-    require(b, "b is null");
-    require(c, "c is null");
-    require (!(a->negative && b->negative), "not implemented");
-
-    struct bn *max, *min;
-    if (a->len > b->len)
-    {
-        max = a;
-        min = b;
-    }
-    else
-    {
-        max = b;
-        min = a;
-    }
-    if (max->len == 0)
-    {
-        bignum_init(c);
-        return;
-    }
-
-    for (int16_t i = 0; i < min->len; ++i)
-        c->array[i] = (max->array[i] ^ min->array[i]);
-    
-    if (min->len < max->len)
-    {
-        for (int16_t i = min->len; i < max->len; ++i)
-            c->array[i] = max->array[i];
-    }
-    int16_t i;
-    for (i = max->len-1; i >= 0 && c->array[i] == 0; --i);
-    c->len = i+1;
-}
-
-#endif
-
-int bignum_cmp(struct bn* a, struct bn* b)
-{
-    require(a, "a is null");
-    require(b, "b is null");
-
-    if (a->len > b->len) return LARGER;
-    if (a->len < b->len) return SMALLER;
-    if (bignum_is_zero(a)) return EQUAL;
-    for (uint16_t i = a->len; i--;)
-    {
-      if (a->array[i] > b->array[i]) return LARGER;
-      if (a->array[i] < b->array[i]) return SMALLER;
-    }
-    return EQUAL;
-}
-
-
-/*
-inline int bignum_is_zero(struct bn* n)
-{
-    require(n, "n is null");
-
-    return (n->len == 0);
-}
-*/
-
-#ifdef IMPLEMENT_ALL
-void bignum_pow(struct bn* a, struct bn* b, struct bn* c)
-{
-    require(a, "a is null");
-    require(b, "b is null");
-    require(c, "c is null");
-    require (!(a->negative && b->negative), "not implemented");
-    
-    struct bn tmp;
-
-    /*
-    printf("bignum_pow:\n");
-    printf("a: "); print_arr(a);
-    printf("b: "); print_arr(b);
-    */
-
-    bignum_init(c);
-
-    if (bignum_cmp(b, c) == EQUAL)
-    {
-        /* Return 1 when exponent is 0 -- n^0 = 1 */
-        bignum_inc(c);
-    }
-    else
-    {
-        /* Copy a -> tmp */
-        bignum_assign(&tmp, a);
-
-        // printf("b before dec "); print_arr(b);
-        bignum_dec(b);
-        // printf("b after dec "); print_arr(b);
-
-        /* Begin summing products: */
-        while (!bignum_is_zero(b))
-        {
-            /* c = tmp * tmp */
-            bignum_mul(&tmp, a, c);
-            /* Decrement b by one */
-            bignum_dec(b);
-
-            bignum_assign(&tmp, c);
-        }
-
-        /* c = tmp */
-        bignum_assign(c, &tmp);
-    }
-}
-#endif
-
-void bignum_assign(struct bn* dst, const struct bn* src)
-{
-    require(dst, "dst is null");
-    require(src, "src is null");
-
-    memcpy(dst, src, sizeof *dst);
-}
-
-
-/* Private / Static functions. */
-static void _rshift_word(struct bn* a, int nwords)
-{
-    /* Naive method: */
-    require(a, "a is null");
-    require(nwords >= 0, "no negative shifts");
-
-    
-    
-    uint16_t effective_nwords = a->len > nwords ? nwords : a->len;
-    for (uint16_t i = 0; i < effective_nwords; ++i)
-        a->array[i] = a->array[i+nwords];
-    
-    for (a->len = effective_nwords; a->len > 0 && a->array[a->len-1] == 0; --a->len);
-
-}
-
-static void _lshift_word(struct bn* a, int nwords)
-{
-    require(a, "a is null");
-    require(nwords >= 0, "no negative shifts");
-
-    /*
-    if (a->len > 0 && nwords > 0) {
-    printf("_lshift_word:\n");
-    printf("a: ");
-    print_arr(a);
-    printf("nwords = %d\n", nwords);
-    }
-    */
-
-    if (a->len == 0 || nwords == 0)
-    {
-        // printf("no shifting.\n");
-        return;
-    }
-
-    int32_t i;
-    require (a->len-1 + nwords < BN_ARRAY_SIZE, "1094: overflow");
-    for ( i = a->len-1; i >= 0; --i)
-        a->array[i+nwords] = a->array[i];
-    memset(a->array, 0, WORD_SIZE*nwords);
-    for (a->len += nwords; a->len > 0 && a->array[a->len-1] == 0; --a->len);
-
-    // printf("result: "); print_arr(a);
-
-}
-
-
-static void _lshift_one_bit(struct bn* a)
-{
-    require(a, "a is null");
-
-    if (bignum_is_zero(a)) return;
-    
-    
-    DTYPE f = a->array[a->len-1];
-    require (!(a->len == 256 && ((MAX_VAL >> 1) < f)), "this shouldn't not happen");
-
-    for (int i = (int)a->len-1; i > 0; --i)
-        a->array[i] = (a->array[i] << 1) | (a->array[i - 1] >> ((8 * WORD_SIZE) - 1));
-
-    a->array[0] <<= 1;
-    
-    if (a->len < BN_ARRAY_SIZE) {
-        a->array[a->len] = (f >> ((8 * WORD_SIZE) - 1));
-        if (a->array[a->len] > 0)
-            ++a->len;
-    }
-}
-
-
-static void _rshift_one_bit(struct bn* a)
-{
-    require(a, "a is null");
-
-    if (bignum_is_zero(a)) return;
-
-    int i;
-    for (i = 0; i+1 < a->len; ++i)
-    {
-        a->array[i] = (a->array[i] >> 1) | (a->array[i + 1] << ((8 * WORD_SIZE) - 1));
-    }
-    a->array[a->len - 1] >>= 1;
-    if (a->array[a->len - 1] == 0)
-        --a->len;
-}
-
-#if defined(USE_IO) || !defined(__H8_2329F__)
-void print_arr(const struct bn* a)
-{
-    if (a->len == 0) {
-        printf("%4x ", 0);
-    } else {
-    for (int i = 0; i < a->len; ++i)
-        printf("%.4x ", a->array[i]);
-    }
-    printf("len = %d\n", a->len);
-}
-#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "bn.h"
+#include "sha1.h"
+#include "util.h"
+
+
+
+/* Head of the free list of pooled temporaries, linked through their array. */
+static ARENA_THREAD struct bn* pool_free;
+
+
+/* Functions for shifting number in-place. */
+static void _lshift_one_bit(struct bn* a);
+static void _rshift_one_bit(struct bn* a);
+static void _lshift_word(struct bn* a, int nwords);
+static void _rshift_word(struct bn* a, int nwords);
+#ifdef IMPLEMENT_ALL
+static void bignum_dec_unsigned(struct bn* a);
+static void bignum_inc_unsigned(struct bn* a);
+#endif
+void print_arr(const struct bn*);
+
+/* Public / Exported functions. */
+void bignum_init(struct bn* n)
+{
+    require(n, "n is null");
+    BN_CALL(init);
+
+    n->len = 0;
+}
+
+void bignum_from_int(struct bn* n, DTYPE_TMP i)
+{
+    require(n, "n is null");
+    BN_CALL(from_int);
+
+    bignum_init(n);
+
+    /* Endianness issue if machine is not little-endian? */
+#ifdef WORD_SIZE
+#if (WORD_SIZE == 1)
+    n->array[0] = (i & 0x000000ff);
+    n->array[1] = (i & 0x0000ff00) >> 8;
+    n->array[2] = (i & 0x00ff0000) >> 16;
+    n->array[3] = (i & 0xff000000) >> 24;
+    n->len = 4;
+#elif (WORD_SIZE == 2)
+    n->array[0] = (i & 0x0000ffff);
+    n->array[1] = (i & 0xffff0000) >> 16;
+    n->len = 2;
+#elif (WORD_SIZE == 4)
+    n->array[0] = i;
+    DTYPE_TMP num_32 = 32;
+    DTYPE_TMP tmp = i >> num_32; /* bit-shift with U64 operands to force 64-bit results */
+    n->array[1] = tmp;
+    n->len = 2;
+#endif
+#endif
+    while (n->len > 0 && n->array[n->len - 1] == 0)
+        --n->len;
+}
+
+#ifdef IMPLEMENT_ALL
+uint32_t bignum_to_int(struct bn* n)
+{
+    require(n, "n is null");
+    require (!n->negative, "not implemented");
+
+    if (n->len == 0)
+        return 0;
+
+    uint32_t ret = 0;
+    /* Endianness issue if machine is not little-endian? */
+#if (WORD_SIZE == 1)
+    ret += n->array[0];
+    ret += n->array[1] << 8;
+    ret += n->array[2] << 16;
+    ret += n->array[3] << 24;  
+#elif (WORD_SIZE == 2)
+    ret += n->array[0];
+    if (n->len > 1)
+        ret += ((int32_t)n->array[1]) << 16;
+#elif (WORD_SIZE == 4)
+    ret += n->array[0];
+#endif
+
+    return ret;
+}
+
+
+void bignum_from_string(struct bn* n, char* str, int nbytes)
+{
+    require(n, "n is null");
+    require(str, "str is null");
+    require(nbytes > 0, "nbytes must be positive");
+    require((nbytes & 1) == 0, "string format must be in hex -> equal number of bytes");
+
+    bignum_init(n);
+
+    DTYPE tmp;                        /* DTYPE is defined in bn.h - uint{8,16,32,64}_t */
+    int i = nbytes - (2 * WORD_SIZE); /* index into string */
+    int j = 0;                        /* index into array */
+
+    /* reading last hex-byte "MSB" from string first -> big endian */
+    /* MSB ~= most significant byte / block ? :) */
+    while (i >= 0)
+    {
+        tmp = 0;
+        sscanf(&str[i], SSCANF_FORMAT_STR, &tmp);
+        n->array[j] = tmp;
+        i -= (2 * WORD_SIZE); /* step WORD_SIZE hex-byte(s) back in the string. */
+        j += 1;               /* step one element forward in the array. */
+    }
+    for (n->len = j; n->len > 0 && n->array[n->len-1] == 0; --n->len);
+}
+
+
+void bignum_to_string(struct bn* n, char* str, int nbytes)
+{
+    require(n, "n is null");
+    require(str, "str is null");
+    require(nbytes > 0, "nbytes must be positive");
+    require((nbytes & 1) == 0, "string format must be in hex -> equal number of bytes");
+    require (!n->negative, "only unsigned numbers can be converted to string");
+
+    if (n->len == 0)
+    {
+        memset(str, 0, nbytes);
+        *str = '0';
+        return;
+    }
+
+    int j = n->len - 1;
+    int i = 0;
+
+    while ((j >= 0) && (nbytes > (i + 1)))
+    {
+        sprintf(&str[i], SPRINTF_FORMAT_STR, n->array[j]);
+        i += (2 * WORD_SIZE);
+        j -= 1;
+    }
+    /* Count leading zeros: */
+    j = 0;
+    while (str[j] == '0')
+    {
+        j += 1;
+    }
+
+    /* Move string j places ahead, effectively skipping leading zeros */ 
+    for (i = 0; i < (nbytes - j); ++i)
+    {
+        str[i] = str[i + j];
+    }
+
+    /* Zero-terminate string */
+    str[i] = 0;
+}
+#endif
+
+/* On little-endian hosts the limb array, read as bytes, is the number in
+   little-endian order: both conversions are a single byte reversal. */
+void bignum_to_bytes(const struct bn* n, unsigned char* bytes, uint32_t nbytes)
+{
+    require(n, "n is null");
+    require(bytes, "str is null");
+    require(nbytes > 0, "nbytes must be positive");
+    BN_CALL(to_bytes);
+    BN_COUNT(bytes_moved, nbytes);
+
+    /* Only the nbytes low-order bytes are kept when the number is longer */
+    uint32_t len = n->len * WORD_SIZE;
+    if (len > nbytes)
+        len = nbytes;
+    memset(bytes, 0, nbytes - len);
+    bytes += nbytes - len;
+
+#if defined(BIG_ENDIAN)
+    for (uint32_t i = 0; i < len; ++i)
+        bytes[len - 1 - i] = (unsigned char)(n->array[i / WORD_SIZE] >> (8 * (i % WORD_SIZE)));
+#else
+    memrev(bytes, n->array, len);
+#endif
+}
+
+void bignum_from_bytes(struct bn* n, const unsigned char* bytes, uint32_t nbytes)
+{
+    require(n, "n is null");
+    require(bytes, "bytes is null");
+    require(nbytes > 0, "nbytes null");
+    require(nbytes <= BN_ARRAY_SIZE * WORD_SIZE, "number too large");
+    BN_CALL(from_bytes);
+    BN_COUNT(bytes_moved, nbytes);
+
+    uint16_t len = (nbytes + WORD_SIZE - 1) / WORD_SIZE;
+    n->array[len - 1] = 0;
+#if defined(BIG_ENDIAN)
+    for (uint32_t i = 0; i < nbytes; ++i)
+    {
+        if (i % WORD_SIZE == 0)
+            n->array[i / WORD_SIZE] = 0;
+        n->array[i / WORD_SIZE] |= (DTYPE)bytes[nbytes - 1 - i] << (8 * (i % WORD_SIZE));
+    }
+#else
+    memrev(n->array, bytes, nbytes);
+#endif
+    for (; len > 0 && n->array[len - 1] == 0; --len);
+    n->len = len;
+}
+
+/* EM-style input already sitting in the limb storage: reordered in place */
+void bignum_from_bytes_in_place(struct bn* n, uint32_t nbytes)
+{
+    require(n, "n is null");
+    require(nbytes > 0, "nbytes null");
+    require(nbytes <= BN_ARRAY_SIZE * WORD_SIZE, "number too large");
+    BN_CALL(from_bytes);
+    BN_COUNT(bytes_moved, nbytes);
+
+    uint16_t len = (nbytes + WORD_SIZE - 1) / WORD_SIZE;
+#if defined(BIG_ENDIAN)
+    /* big-endian words are already in place, only their order flips */
+    require(nbytes % WORD_SIZE == 0, "nbytes must be whole words");
+    for (uint16_t i = 0; i < len / 2; ++i)
+    {
+        DTYPE w = n->array[i];
+        n->array[i] = n->array[len - 1 - i];
+        n->array[len - 1 - i] = w;
+    }
+#else
+    memrev(n->array, n->array, nbytes);
+    memset((unsigned char*)n->array + nbytes, 0, len * WORD_SIZE - nbytes);
+#endif
+    for (; len > 0 && n->array[len - 1] == 0; --len);
+    n->len = len;
+}
+
+#ifdef IMPLEMENT_ALL
+static void bignum_inc_unsigned(struct bn* n)
+{
+    require(n, "n is null");
+
+    if (bignum_is_zero(n))
+    {
+        n->array[0] = 1;
+        n->negative = false;
+        n->len = 1;
+        return;
+    }
+
+    DTYPE res;
+    DTYPE_TMP tmp; /* copy of n */
+    int i;
+    for (i = 0; i <= n->len; ++i)
+    {
+        tmp = n->array[i];
+        res = tmp + 1;
+        n->array[i] = res;
+
+        if (res > tmp)
+        {
+            break;
+        }
+    }
+    if (i == n->len+1 && n->array[n->len])
+        ++n->len;
+}
+
+static void bignum_dec_unsigned(struct bn* n)
+{
+    require(n, "n is null");
+
+    if (bignum_is_zero(n))
+    {
+        n->array[0] = 1;
+        n->negative = true;
+        n->len = 1;
+        return;
+    }
+
+    DTYPE tmp; /* copy of n */
+    DTYPE res;
+
+    int i;
+    for (i = 0; i < n->len; ++i)
+    {
+        tmp = n->array[i];
+        res = tmp - 1;
+        n->array[i] = res;
+
+        if (!(res > tmp))
+        {
+            break;
+        }
+    }
+    if (i == n->len-1)
+    {
+        for (; i >= 0 && n->array[i] == 0; --i);
+        n->len = i+1;
+    }
+}
+
+void bignum_inc(struct bn* n)
+{
+    require (n, "n is null");
+
+    if (n->negative)
+    {
+        bignum_dec_unsigned(n);
+        if (bignum_is_zero(n))
+            n->negative = false;
+    }
+    else
+    {
+        bignum_inc_unsigned(n);
+    }
+}
+
+void bignum_dec(struct bn* n)
+{
+    require (n, "n is null");
+    
+    if (n->negative)
+        bignum_inc_unsigned(n);
+    else
+        bignum_dec_unsigned(n);
+}
+
+#endif
+
+void bignum_add(struct bn* a, struct bn* b, struct bn* c)
+{
+    require(a, "a is null");
+    require(b, "b is null");
+    require(c, "c is null");
+    BN_CALL(add);
+
+    DTYPE_TMP tmp;
+    int carry = 0;
+    uint16_t maxlen = (a->len > b->len) ? a->len : b->len;
+    BN_COUNT(limb_add, maxlen);
+    if (a->len < maxlen)
+        memset(a->array+a->len, 0, WORD_SIZE*(maxlen - a->len));
+    else if (b->len < maxlen)
+        memset(b->array+b->len, 0, WORD_SIZE*(maxlen - b->len));
+    for (uint16_t i = 0; i < maxlen; ++i)
+    {
+        tmp = ((DTYPE_TMP)a->array[i]) + b->array[i] + carry;
+        carry = (tmp > MAX_VAL);
+        c->array[i] = (tmp & MAX_VAL);
+    }
+    if (maxlen < BN_ARRAY_SIZE)
+        c->array[maxlen] = carry;
+    else
+        require(!carry, "sum overflows BN_MAX_BITS");
+    c->len = maxlen + (carry != 0);
+
+}
+
+
+void bignum_sub(struct bn* a, struct bn* b, struct bn* c)
+{
+    require(a, "a is null");
+    require(b, "b is null");
+    require(c, "c is null");
+    BN_CALL(sub);
+    BN_COUNT(limb_add, a->len);
+
+    if (a->len < 1)
+    {
+        bignum_init(c);
+        return;
+    }
+    memset(b->array+b->len, 0, WORD_SIZE*(a->len-b->len));
+    DTYPE_TMP res;
+    DTYPE_TMP tmp1;
+    DTYPE_TMP tmp2;
+    int borrow = 0;
+    int i;
+    for (i = 0; i < a->len; ++i)
+    {
+        tmp1 = (DTYPE_TMP)a->array[i] + (MAX_VAL + 1); /* + number_base */
+        tmp2 = (DTYPE_TMP)b->array[i] + borrow;
+        res = (tmp1 - tmp2);
+        c->array[i] = (DTYPE)(res & MAX_VAL); /* "modulo number_base" == "% (number_base - 1)" if number_base is 2^N */
+        borrow = (res <= MAX_VAL);
+    }
+    uint16_t j = a->len;
+    while (j > 0)
+    {
+        --j;
+        if (c->array[j] != 0)
+            break;
+    }
+    c->len = c->array[j] != 0 ? j+1 : 0;
+}
+
+
+
+void bignum_mul_naive(struct bn* a, struct bn* b, struct bn* c) {
+    require(a, "a is null");
+    require(b, "b is null");
+    require(c, "c is null");
+    BN_CALL(mul_naive);
+    BN_COUNT(limb_mul, (uint32_t)a->len * b->len);
+    
+
+    struct bn row;
+    struct bn tmp;
+    int i, j;
+
+    bignum_init(c);
+
+    for (i = 0; i < a->len; ++i)
+    {
+        bignum_init(&row);
+
+        for (j = 0; j < b->len; ++j)
+        {
+            bignum_init(&tmp);
+            DTYPE_TMP intermediate = ((DTYPE_TMP)a->array[i] * (DTYPE_TMP)b->array[j]);
+            bignum_from_int(&tmp, intermediate);
+            _lshift_word(&tmp, i + j);
+            bignum_add(&tmp, &row, &row);
+        }
+        bignum_add(c, &row, c);
+    }
+}
+
+static void bignum_split_at(const struct bn* a,
+                            uint16_t k,
+                            struct bn* lo,
+                            struct bn* hi)
+{
+    uint16_t alen = a->len;
+    uint16_t lo_len = (alen < k) ? alen : k;
+    uint16_t i;
+    for (i = 0; i < lo_len; ++i)
+        lo->array[i] = a->array[i];
+    lo->len = lo_len;
+
+    for (; i < alen; ++i)
+        hi->array[i-lo_len] = a->array[i];
+    hi->len = alen - lo_len;
+}
+
+void bignum_mul_karatsuba(struct bn* a, struct bn* b, struct bn* c) {
+    uint16_t alen = a->len, blen = b->len;
+    BN_CALL(mul_karatsuba);
+    if (alen < BN_KARATSUBA_CUTOFF || blen < BN_KARATSUBA_CUTOFF) {
+        bignum_mul_naive(a, b, c);
+        return;
+    }
+#ifdef BN_COUNTERS
+    if (++bn_counters.karatsuba_depth > bn_counters.karatsuba_max_depth)
+        bn_counters.karatsuba_max_depth = bn_counters.karatsuba_depth;
+#endif
+
+    uint16_t m = (alen > blen) ? alen : blen;
+    uint16_t m2 = (m/2) + (m%2);
+	
+    struct bn   *x1 = bignum_tmp_get(),
+                *x0 = bignum_tmp_get(),
+                *y1 = bignum_tmp_get(),
+                *y0 = bignum_tmp_get(),
+                *z0 = bignum_tmp_get(),
+                *z1 = bignum_tmp_get(),
+                *z2 = bignum_tmp_get(),
+                *t1 = bignum_tmp_get(),
+                *t2 = bignum_tmp_get();
+
+    bignum_init(z0);
+    bignum_init(z1);
+    bignum_init(z2);
+        
+    // printf("a = "); print_arr(a);
+    bignum_split_at(a, m2, x1, x0);
+
+    bignum_split_at(b, m2 ,y1, y0); // b = y1* 2^(M2) + y0, = y1, y
+
+
+    bignum_add(x1, x0, t1); // t1 = x0 + x1
+
+    bignum_add(y1, y0, t2); // t2 = y0 + y1
+
+
+    bignum_mul_karatsuba(x1, y1, z0);
+    bignum_mul_karatsuba(t1, t2, z1);
+    bignum_mul_karatsuba(x0, y0, z2);
+
+    bignum_add(z0, z2, t1);
+    require (bignum_cmp(z1, t1) != SMALLER, "632: exception");
+    bignum_sub(z1, t1, t2);
+
+    bignum_lshift(z2, z1, 2*m2*WORD_SIZE*8);
+    bignum_lshift(t2, t1, m2*WORD_SIZE*8);
+    bignum_add(z0, t1, z0);
+    bignum_add(z0, z1, z0);
+    bignum_assign(c, z0);
+
+    bignum_tmp_put(t2);
+    bignum_tmp_put(t1);
+    bignum_tmp_put(z2);
+    bignum_tmp_put(z1);
+    bignum_tmp_put(z0);
+    bignum_tmp_put(y0);
+    bignum_tmp_put(y1);
+    bignum_tmp_put(x0);
+    bignum_tmp_put(x1);
+#ifdef BN_COUNTERS
+    --bn_counters.karatsuba_depth;
+#endif
+}
+
+void bignum_div(struct bn* a, struct bn* b, struct bn* c)
+{
+    require(a, "a is null");
+    require(b, "b is null");
+    require(c, "c is null");
+    BN_CALL(div);
+    require (b->len > 0, "division by zero");
+    
+    struct bn *current = bignum_tmp_get();
+    struct bn *denom = bignum_tmp_get();
+    struct bn *tmp = bignum_tmp_get();
+    
+    bignum_from_int(current, 1);               /*  int current = 1; */
+    bignum_assign(denom, b);                   /*  denom = b */
+    bignum_assign(tmp, a);                     /*  tmp   = a */
+    
+    while (bignum_cmp(denom, a) != LARGER)     /*  while (denom <= a) { */
+    {
+        require (!(denom->len == BN_ARRAY_SIZE && denom->array[BN_ARRAY_SIZE - 1] >= 1 + (DTYPE_TMP)(MAX_VAL / 2)), "division overflow");
+
+        _lshift_one_bit(current);                /*    current <<= 1; */
+        _lshift_one_bit(denom);                  /*    denom <<= 1; */
+    }
+    _rshift_one_bit(denom);                  
+    _rshift_one_bit(current);                
+
+    bignum_init(c);                             /*  int answer = 0; */
+
+    while (!bignum_is_zero(current))           /*  while (current != 0) */
+    {
+        if (bignum_cmp(tmp, denom) != SMALLER)  /*    if (dividend >= denom) */
+        {
+            bignum_sub(tmp, denom, tmp);         /*      dividend -= denom; */
+            bignum_or(c, current, c);              /*      answer |= current; */
+        }
+        _rshift_one_bit(current);
+        _rshift_one_bit(denom);
+    }                                            /*  return answer; */
+    int16_t i;
+    for (i = c->len-1; i >= 0 && c->array[i] == 0; --i);
+    c->len = i+1;
+    
+    bignum_tmp_put(tmp);
+    bignum_tmp_put(denom);
+    bignum_tmp_put(current);
+}
+
+void bignum_lshift(struct bn* a, struct bn* b, int nbits)
+{
+    require(a, "a is null");
+    require(b, "b is null");
+    require(nbits >= 0, "no negative shifts");
+    BN_CALL(lshift);
+
+    if (bignum_is_zero(a))
+    {
+        bignum_init(b);
+        return;
+    }
+
+
+    /* Handle shift in multiples of word-size */
+    const int nbits_pr_word = (WORD_SIZE * 8);
+    int nwords = nbits / nbits_pr_word;
+    if (nwords != 0)
+    {
+        _lshift_word(a, nwords);
+        nbits -= (nwords * nbits_pr_word);
+    }
+
+    if (nbits != 0)
+    {
+        BN_COUNT(limb_shift, a->len);
+        a->array[a->len] = 0;
+        for (int16_t i = a->len; i > 0; --i)
+            a->array[i] = (a->array[i] << nbits) | (a->array[i - 1] >> ((8 * WORD_SIZE) - nbits));
+        a->array[0] <<= nbits;
+        if (a->array[a->len] > 0)
+            ++a->len;
+    }
+    bignum_assign(b, a);
+}
+
+void bignum_rshift(struct bn* a, struct bn* b, int nbits)
+{
+    require(a, "a is null");
+    require(b, "b is null");
+    require(nbits >= 0, "no negative shifts");
+    BN_CALL(rshift);
+
+    struct bn ba;
+    bignum_assign(&ba, a);
+    a = &ba;
+    
+    if (a->len == 0)
+    {
+        bignum_init(b);
+        return;
+    }
+
+    /* Handle shift in multiples of word-size */
+    const int nbits_pr_word = (WORD_SIZE * 8);
+    int nwords = nbits / nbits_pr_word;
+    if (nwords != 0)
+    {
+        _rshift_word(a, nwords);
+        nbits -= (nwords * nbits_pr_word);
+    }
+
+    if (nbits != 0 && a->len != 0)
+    {
+        BN_COUNT(limb_shift, a->len);
+        int i;
+        for (i = 0; i < a->len - 1; ++i)
+        {
+            a->array[i] = (a->array[i] >> nbits) | (a->array[i + 1] << ((8 * WORD_SIZE) - nbits));
+        }
+        a->array[i] >>= nbits;
+        if (a->array[a->len-1] == 0)
+            --a->len;
+    }
+    bignum_assign(b, a);
+}
+
+
+void bignum_mod(struct bn* a, struct bn* b, struct bn* c)
+{
+    require(a, "a is null");
+    require(b, "b is null");
+    require(c, "c is null");
+    BN_CALL(mod);
+
+    struct bn *tmp = bignum_tmp_get();
+
+    /* c = (a / b) */
+    bignum_div(a, b, c);
+
+    /* tmp = (c * b) */
+    bignum_mul(c, b, tmp);
+    /* c = a - tmp */
+    bignum_sub(a, tmp, c);
+
+    bignum_tmp_put(tmp);
+}
+
+
+/* Montgomery arithmetic. Numbers are kept as raw limb arrays of the
+   modulus' length s while they are worked on; R = 2^(8 * WORD_SIZE * s). */
+#define MONT_MAX_LEN (BN_ARRAY_SIZE / 2)
+#define W_BITS (8 * WORD_SIZE)
+
+/* r -= n over s words; returns the borrow out */
+static DTYPE _mont_sub(DTYPE* r, const DTYPE* n, uint16_t s)
+{
+    DTYPE borrow = 0;
+    for (uint16_t j = 0; j < s; ++j)
+    {
+        DTYPE_TMP d = (DTYPE_TMP)r[j] - n[j] - borrow;
+        r[j] = (DTYPE)d;
+        borrow = (DTYPE)((d >> W_BITS) & 1);
+    }
+    return borrow;
+}
+
+/* r += n over s words; returns the carry out */
+static DTYPE _mont_add(DTYPE* r, const DTYPE* n, uint16_t s)
+{
+    DTYPE_TMP C = 0;
+    for (uint16_t j = 0; j < s; ++j)
+    {
+        C += (DTYPE_TMP)r[j] + n[j];
+        r[j] = (DTYPE)C;
+        C >>= W_BITS;
+    }
+    return (DTYPE)C;
+}
+
+static bool _mont_geq(const DTYPE* r, const DTYPE* n, uint16_t s)
+{
+    while (s--)
+        if (r[s] != n[s])
+            return r[s] > n[s];
+    return true;
+}
+
+/* The s low words of a, zero-extended */
+static void _mont_load(DTYPE* r, const struct bn* a, uint16_t s)
+{
+    require(a->len <= s, "operand longer than the modulus");
+    BN_COUNT(bytes_moved, s * WORD_SIZE);
+    memcpy(r, a->array, a->len * WORD_SIZE);
+    memset(r + a->len, 0, (s - a->len) * WORD_SIZE);
+}
+
+/* Coarsely integrated operand scanning: one row of a * b[i] and one row of
+   the reduction per word of b, in a single (s + 2)-word accumulator.
+   t = a * b / R, below 2n in its s + 1 low words. */
+static void _mont_rows(const struct bn_mont* m, const DTYPE* a, const DTYPE* b, DTYPE* t)
+{
+    const DTYPE* n = m->n;
+    const uint16_t s = m->len;
+    uint16_t i, j;
+
+    /* per word of b: a row of s products, q, and s more for q * n, each
+       product with two additions; then the final subtraction */
+    BN_CALL(mont_mul);
+    BN_COUNT(limb_mul, (uint32_t)s * (2 * s + 1));
+    BN_COUNT(limb_add, (uint32_t)s * 4 * s + s);
+    memset(t, 0, (s + 2) * WORD_SIZE);
+    for (i = 0; i < s; ++i)
+    {
+        const DTYPE bi = b[i];
+        DTYPE_TMP C = 0;
+        for (j = 0; j < s; ++j)
+        {
+            C += (DTYPE_TMP)a[j] * bi + t[j];
+            t[j] = (DTYPE)C;
+            C >>= W_BITS;
+        }
+        C += t[s];
+        t[s] = (DTYPE)C;
+        t[s + 1] = (DTYPE)(C >> W_BITS);
+
+        /* add q * n, with q chosen so the low word cancels, and drop it */
+        const DTYPE q = (DTYPE)((DTYPE_TMP)t[0] * m->n0);
+        C = ((DTYPE_TMP)q * n[0] + t[0]) >> W_BITS;
+        for (j = 1; j < s; ++j)
+        {
+            C += (DTYPE_TMP)q * n[j] + t[j];
+            t[j - 1] = (DTYPE)C;
+            C >>= W_BITS;
+        }
+        C += t[s];
+        t[s - 1] = (DTYPE)C;
+        t[s] = (DTYPE)(t[s + 1] + (C >> W_BITS));
+    }
+}
+
+/* out = a * b / R mod n; out may alias a or b */
+static void _mont_mul(const struct bn_mont* m, const DTYPE* a, const DTYPE* b, DTYPE* out)
+{
+    const uint16_t s = m->len;
+    DTYPE t[MONT_MAX_LEN + 2];
+
+    _mont_rows(m, a, b, t);
+    if (t[s] || _mont_geq(t, m->n, s))
+        _mont_sub(t, m->n, s);
+    memcpy(out, t, s * WORD_SIZE);
+}
+
+/* The same with no branch on the operands: n is always subtracted, and t
+   or t - n kept through a mask */
+static void _mont_mul_ct(const struct bn_mont* m, const DTYPE* a, const DTYPE* b, DTYPE* out)
+{
+    const uint16_t s = m->len;
+    DTYPE t[MONT_MAX_LEN + 2], u[MONT_MAX_LEN];
+    DTYPE keep;
+
+    _mont_rows(m, a, b, t);
+    memcpy(u, t, s * WORD_SIZE);
+    /* t stays when it is below n: a borrow out of s words with t[s] clear */
+    keep = (DTYPE)0 - (_mont_sub(u, m->n, s) & (t[s] ^ 1));
+    for (uint16_t j = 0; j < s; ++j)
+        out[j] = (t[j] & keep) | (u[j] & ~keep);
+}
+
+static void _mont_store(struct bn* c, const DTYPE* t, uint16_t s)
+{
+    BN_COUNT(bytes_moved, s * WORD_SIZE);
+    memcpy(c->array, t, s * WORD_SIZE);
+    for (; s > 0 && t[s - 1] == 0; --s);
+    c->len = s;
+}
+
+void bignum_from_limbs(struct bn* n, const DTYPE* limbs, uint16_t len)
+{
+    require(n, "n is null");
+    require(len <= BN_ARRAY_SIZE, "number too large");
+
+    _mont_store(n, limbs, len);
+}
+
+void bignum_mont_init(struct bn_mont* m, const DTYPE* n, uint16_t s, DTYPE* rr)
+{
+    require(m, "m is null");
+    require(n, "n is null");
+    require(rr, "rr is null");
+    require(s > 0 && (n[0] & 1) && n[s - 1], "modulus must be odd and s words long");
+    require(s <= MONT_MAX_LEN, "modulus too large");
+    BN_CALL(mont_init);
+
+    m->n = n;
+    m->rr = rr;
+    m->len = s;
+
+    /* Newton's iteration doubles the correct low bits of 1/n, from 3 */
+    DTYPE_TMP x = n[0];
+    for (int i = 0; i < 5; ++i)
+        x *= 2 - (DTYPE_TMP)n[0] * x;
+    m->n0 = (DTYPE)(0 - x);
+
+    /* R mod n: the top bit of n doubled up to R, reduced as it goes */
+    int top = W_BITS - 1;
+    while (!((n[s - 1] >> top) & 1))
+        --top;
+    memset(rr, 0, s * WORD_SIZE);
+    rr[s - 1] = (DTYPE)((DTYPE_TMP)1 << top);
+    uint32_t doublings = W_BITS - top;
+
+    /* then 2^j R, with j = 8 * WORD_SIZE * s / 2^t, squared t times over
+       Montgomery products (x R)^2 / R = x^2 R gives 2^(8 * WORD_SIZE * s) R */
+    uint32_t j = W_BITS * s, t = 0;
+    while (!(j & 1) && t < 6)
+    {
+        j >>= 1;
+        ++t;
+    }
+    for (doublings += j; doublings > 0; --doublings)
+    {
+        DTYPE hi = rr[s - 1] >> (W_BITS - 1);
+        for (uint16_t k = s - 1; k > 0; --k)
+            rr[k] = (DTYPE)(rr[k] << 1 | rr[k - 1] >> (W_BITS - 1));
+        rr[0] = (DTYPE)(rr[0] << 1);
+        if (hi || _mont_geq(rr, n, s))
+            _mont_sub(rr, n, s);
+    }
+    while (t--)
+        _mont_mul(m, rr, rr, rr);
+}
+
+void bignum_mont_mul(const struct bn_mont* m, const struct bn* a, const struct bn* b, struct bn* c)
+{
+    require(m, "m is null");
+    require(a, "a is null");
+    require(b, "b is null");
+    require(c, "c is null");
+
+    DTYPE x[MONT_MAX_LEN], y[MONT_MAX_LEN];
+    _mont_load(x, a, m->len);
+    _mont_load(y, b, m->len);
+    _mont_mul(m, x, y, x);
+    _mont_store(c, x, m->len);
+}
+
+void bignum_mont_mod(const struct bn_mont* m, const struct bn* a, struct bn* c)
+{
+    require(m, "m is null");
+    require(a, "a is null");
+    require(c, "c is null");
+    require(a->len <= 2 * m->len, "operand too long");
+
+    const uint16_t s = m->len;
+    DTYPE t[2 * MONT_MAX_LEN + 1];
+    uint16_t i, j;
+
+    memcpy(t, a->array, a->len * WORD_SIZE);
+    memset(t + a->len, 0, (2 * s + 1 - a->len) * WORD_SIZE);
+
+    /* REDC: clear the low word s times, adding multiples of n */
+    for (i = 0; i < s; ++i)
+    {
+        const DTYPE q = (DTYPE)((DTYPE_TMP)t[i] * m->n0);
+        DTYPE_TMP C = 0;
+        for (j = 0; j < s; ++j)
+        {
+            C += (DTYPE_TMP)q * m->n[j] + t[i + j];
+            t[i + j] = (DTYPE)C;
+            C >>= W_BITS;
+        }
+        for (j = i + s; C && j <= 2 * s; ++j)
+        {
+            C += t[j];
+            t[j] = (DTYPE)C;
+            C >>= W_BITS;
+        }
+    }
+
+    /* (a + qn) / R < a / R + n, below 2n when a < nR; times R^2 / R puts R back */
+    if (t[2 * s] || _mont_geq(t + s, m->n, s))
+        _mont_sub(t + s, m->n, s);
+    _mont_mul(m, t + s, m->rr, t + s);
+    _mont_store(c, t + s, s);
+}
+
+void bignum_mont_mul_limbs(const struct bn_mont* m, const DTYPE* a, const DTYPE* b, DTYPE* c)
+{
+    require(m, "m is null");
+    require(a, "a is null");
+    require(b, "b is null");
+    require(c, "c is null");
+
+    _mont_mul(m, a, b, c);
+}
+
+void bignum_mont_exp_limbs(const struct bn_mont* m, const DTYPE* a, const DTYPE* e, uint16_t elen, DTYPE* c)
+{
+    require(m, "m is null");
+    require(a, "a is null");
+    require(c, "c is null");
+    BN_CALL(mont_exp);
+
+    const uint16_t s = m->len;
+    DTYPE x[MONT_MAX_LEN], acc[MONT_MAX_LEN];
+    int32_t bit;
+
+    for (; elen > 0 && e[elen - 1] == 0; --elen);
+    if (!elen)
+    {
+        memset(c, 0, s * WORD_SIZE);
+        c[0] = s > 1 || m->n[0] != 1;  /* 1 mod n */
+        return;
+    }
+    bit = elen * W_BITS - 1;
+    while (!((e[bit / W_BITS] >> (bit % W_BITS)) & 1))
+        --bit;
+
+    /* left to right over the bits of e, in Montgomery form throughout */
+    _mont_mul(m, a, m->rr, x);
+    memcpy(acc, x, s * WORD_SIZE);
+    while (bit--)
+    {
+        _mont_mul(m, acc, acc, acc);
+        if ((e[bit / W_BITS] >> (bit % W_BITS)) & 1)
+            _mont_mul(m, acc, x, acc);
+    }
+
+    /* out of Montgomery form: times 1, over R */
+    memset(x, 0, s * WORD_SIZE);
+    x[0] = 1;
+    _mont_mul(m, acc, x, c);
+}
+
+void bignum_mont_exp_ct(const struct bn_mont* m, const struct bn* a, const DTYPE* e, uint16_t elen, struct bn* c)
+{
+    require(m, "m is null");
+    require(a, "a is null");
+    require(e, "e is null");
+    require(c, "c is null");
+    require(W_BITS % BN_CT_WINDOW == 0, "window must divide a word");
+    BN_CALL(mont_exp);
+
+    const uint16_t s = m->len;
+    const uint32_t entries = 1u << BN_CT_WINDOW;
+    DTYPE x[1 << BN_CT_WINDOW][MONT_MAX_LEN], acc[MONT_MAX_LEN], y[MONT_MAX_LEN];
+    uint32_t i, k;
+    int32_t bit;
+
+    /* 1, a, a^2, ..., a^(2^w - 1) in Montgomery form; 1 is R^2 / R */
+    memset(acc, 0, s * WORD_SIZE);
+    acc[0] = 1;
+    _mont_mul_ct(m, acc, m->rr, x[0]);
+    _mont_load(y, a, s);
+    _mont_mul_ct(m, y, m->rr, x[1]);
+    for (i = 2; i < entries; ++i)
+        _mont_mul_ct(m, x[i - 1], x[1], x[i]);
+
+    /* every window of every word of e, leading zeros too: the same squarings
+       and multiplications whatever the exponent, and each window's power
+       picked by reading the whole table through a mask */
+    memcpy(acc, x[0], s * WORD_SIZE);
+    for (bit = elen * W_BITS - BN_CT_WINDOW; bit >= 0; bit -= BN_CT_WINDOW)
+    {
+        const uint32_t w = (uint32_t)(e[bit / W_BITS] >> (bit % W_BITS)) & (entries - 1);
+        for (i = 0; i < BN_CT_WINDOW; ++i)
+            _mont_mul_ct(m, acc, acc, acc);
+        BN_COUNT(bytes_moved, entries * s * WORD_SIZE);
+        memset(y, 0, s * WORD_SIZE);
+        for (i = 0; i < entries; ++i)
+        {
+            /* all ones when i == w: (i ^ w) - 1 only borrows from zero */
+            const DTYPE pick = (DTYPE)0 - (DTYPE)(((i ^ w) - 1) >> 31);
+            for (k = 0; k < s; ++k)
+                y[k] |= x[i][k] & pick;
+        }
+        _mont_mul_ct(m, acc, y, acc);
+    }
+
+    memset(y, 0, s * WORD_SIZE);
+    y[0] = 1;
+    _mont_mul_ct(m, acc, y, acc);
+    _mont_store(c, acc, s);
+}
+
+/* x / 2 mod n for x < n: an odd x is made even by adding n first, the carry
+   shifted back in at the top */
+static void _mont_half(DTYPE* x, const DTYPE* n, uint16_t s)
+{
+    const DTYPE carry = (x[0] & 1) ? _mont_add(x, n, s) : 0;
+    uint16_t j;
+
+    for (j = 0; j + 1 < s; ++j)
+        x[j] = (DTYPE)(x[j] >> 1 | x[j + 1] << (W_BITS - 1));
+    x[s - 1] = (DTYPE)(x[s - 1] >> 1 | carry << (W_BITS - 1));
+}
+
+static bool _mont_is_one(const DTYPE* x, uint16_t s)
+{
+    while (--s)
+        if (x[s])
+            return false;
+    return x[0] == 1;
+}
+
+bool bignum_mont_inv(const struct bn_mont* m, const struct bn* a, struct bn* c)
+{
+    require(m, "m is null");
+    require(a, "a is null");
+    require(c, "c is null");
+
+    const uint16_t s = m->len;
+    DTYPE u[MONT_MAX_LEN], v[MONT_MAX_LEN], x1[MONT_MAX_LEN], x2[MONT_MAX_LEN];
+
+    /* binary extended Euclid, keeping u = x1 a and v = x2 a mod n */
+    _mont_load(u, a, s);
+    memcpy(v, m->n, s * WORD_SIZE);
+    memset(x1, 0, s * WORD_SIZE);
+    memset(x2, 0, s * WORD_SIZE);
+    x1[0] = 1;
+    while (!_mont_is_one(u, s) && !_mont_is_one(v, s))
+    {
+        uint16_t j;
+        for (j = 0; j < s && !u[j]; ++j);
+        if (j == s)
+            return false;  /* v is a common factor */
+        for (; !(u[0] & 1); _mont_half(x1, m->n, s))
+            for (j = 0; j < s; ++j)
+                u[j] = (DTYPE)(u[j] >> 1 | (j + 1 < s ? u[j + 1] << (W_BITS - 1) : 0));
+        for (; !(v[0] & 1); _mont_half(x2, m->n, s))
+            for (j = 0; j < s; ++j)
+                v[j] = (DTYPE)(v[j] >> 1 | (j + 1 < s ? v[j + 1] << (W_BITS - 1) : 0));
+        if (_mont_geq(u, v, s))
+        {
+            _mont_sub(u, v, s);
+            if (_mont_sub(x1, x2, s))
+                _mont_add(x1, m->n, s);
+        }
+        else
+        {
+            _mont_sub(v, u, s);
+            if (_mont_sub(x2, x1, s))
+                _mont_add(x2, m->n, s);
+        }
+    }
+    _mont_store(c, _mont_is_one(u, s) ? x1 : x2, s);
+    return true;
+}
+
+void bignum_mont_exp(const struct bn_mont* m, const struct bn* a, const DTYPE* e, uint16_t elen, struct bn* c)
+{
+    require(m, "m is null");
+    require(a, "a is null");
+    require(c, "c is null");
+
+    DTYPE x[MONT_MAX_LEN];
+    _mont_load(x, a, m->len);
+    bignum_mont_exp_limbs(m, x, e, elen, x);
+    _mont_store(c, x, m->len);
+}
+
+void bignum_mont_exp_chain(const struct bn_mont* m, const struct bn* a, const unsigned char* chain, uint16_t len, struct bn* c)
+{
+    require(m, "m is null");
+    require(a, "a is null");
+    require(chain, "chain is null");
+    require(c, "c is null");
+    require(len > 1 && chain[0] >= 1 && chain[0] <= BN_CHAIN_MAX_WINDOW, "chain window too wide for this build");
+    BN_CALL(mont_exp);
+
+    const uint16_t s = m->len;
+    const uint16_t powers = 1 << (chain[0] - 1);
+    DTYPE x[1 << (BN_CHAIN_MAX_WINDOW - 1)][MONT_MAX_LEN], acc[MONT_MAX_LEN];
+    bool loaded = false;
+    uint16_t i;
+
+    /* a, a^3, ..., a^(2^w - 1) in Montgomery form */
+    _mont_load(x[0], a, s);
+    _mont_mul(m, x[0], m->rr, x[0]);
+    if (powers > 1)
+        _mont_mul(m, x[0], x[0], acc);
+    for (i = 1; i < powers; ++i)
+        _mont_mul(m, x[i - 1], acc, x[i]);
+
+    for (i = 1; i < len; ++i)
+    {
+        const unsigned char k = chain[i];
+        if (!k)
+        {
+            require(loaded, "chain squares before it loads");
+            _mont_mul(m, acc, acc, acc);
+            continue;
+        }
+        require((k & 1) && (k >> 1) < powers, "chain step out of the window");
+        if (loaded)
+            _mont_mul(m, acc, x[k >> 1], acc);
+        else
+            memcpy(acc, x[k >> 1], s * WORD_SIZE);
+        loaded = true;
+    }
+    require(loaded, "chain without a multiply");
+
+    memset(x[0], 0, s * WORD_SIZE);
+    x[0][0] = 1;
+    _mont_mul(m, acc, x[0], acc);
+    _mont_store(c, acc, s);
+}
+
+
+#ifdef IMPLEMENT_ALL
+void bignum_and(struct bn* a, struct bn* b, struct bn* c)
+{
+    require(a, "a is null");
+    require(b, "b is null");
+    require(c, "c is null");
+    require (!(a->negative && b->negative), "not implemented");
+
+    struct bn *max, *min;
+    if (a->len > b->len)
+    {
+        max = a;
+        min = b;
+    }
+    else
+    {
+        max = b;
+        min = a;
+    }
+    if (max->len == 0)
+    {
+        bignum_init(c);
+        return;
+    }
+    for (int i = 0; i < min->len; ++i)
+        c->array[i] = (max->array[i] & min->array[i]);
+    if (min->len < max->len)
+        memset(c+min->len, 0, (max->len-min->len)*WORD_SIZE);
+    int16_t i;
+    for (i = min->len-1; i >= 0 && c->array[i] == 0; --i);
+    c->len = i+1;
+
+    // printf("bignum_and: c = "); print_arr(c);
+}
+
+#endif
+
+void bignum_or(struct bn* a, struct bn* b, struct bn* c)
+{
+    require(a, "a is null");
+    require(b, "b is null");
+    require(c, "c is null");
+
+    struct bn *max, *min;
+    if (a->len > b->len)
+    {
+        max = a;
+        min = b;
+    }
+    else
+    {
+        max = b;
+        min = a;
+    }
+    if (max->len == 0)
+    {
+        bignum_init(c);
+        return;
+    }
+    for (int i = 0; i < min->len; ++i)
+        c->array[i] = (max->array[i] | min->array[i]);
+    for (int i = min->len; i < max->len; ++i)
+        c->array[i] = max->array[i];
+    c->len = max->len;
+}
+
+#ifdef IMPLEMENT_ALL
+void bignum_xor(struct bn* a, struct bn* b, struct bn* c)
+{
+    require(a, "a is null");
+    require(b, "b is null");
+    require(c, "c is null");
+    require (!(a->negative && b->negative), "not implemented");
+
+    struct bn *max, *min;
+    if (a->len > b->len)
+    {
+        max = a;
+        min = b;
+    }
+    else
+    {
+        max = b;
+        min = a;
+    }
+    if (max->len == 0)
+    {
+        bignum_init(c);
+        return;
+    }
+
+    for (int16_t i = 0; i < min->len; ++i)
+        c->array[i] = (max->array[i] ^ min->array[i]);
+    
+    if (min->len < max->len)
+    {
+        for (int16_t i = min->len; i < max->len; ++i)
+            c->array[i] = max->array[i];
+    }
+    int16_t i;
+    for (i = max->len-1; i >= 0 && c->array[i] == 0; --i);
+    c->len = i+1;
+}
+
+#endif
+
+int bignum_cmp(struct bn* a, struct bn* b)
+{
+    require(a, "a is null");
+    require(b, "b is null");
+    BN_CALL(cmp);
+
+    if (a->len > b->len) return LARGER;
+    if (a->len < b->len) return SMALLER;
+    if (bignum_is_zero(a)) return EQUAL;
+    for (uint16_t i = a->len; i--;)
+    {
+      BN_COUNT(limb_add, 1);
+      if (a->array[i] > b->array[i]) return LARGER;
+      if (a->array[i] < b->array[i]) return SMALLER;
+    }
+    return EQUAL;
+}
+
+
+/*
+inline int bignum_is_zero(struct bn* n)
+{
+    require(n, "n is null");
+
+    return (n->len == 0);
+}
+*/
+
+#ifdef IMPLEMENT_ALL
+void bignum_pow(struct bn* a, struct bn* b, struct bn* c)
+{
+    require(a, "a is null");
+    require(b, "b is null");
+    require(c, "c is null");
+    require (!(a->negative && b->negative), "not implemented");
+    
+    struct bn tmp;
+
+    /*
+    printf("bignum_pow:\n");
+    printf("a: "); print_arr(a);
+    printf("b: "); print_arr(b);
+    */
+
+    bignum_init(c);
+
+    if (bignum_cmp(b, c) == EQUAL)
+    {
+        /* Return 1 when exponent is 0 -- n^0 = 1 */
+        bignum_inc(c);
+    }
+    else
+    {
+        /* Copy a -> tmp */
+        bignum_assign(&tmp, a);
+
+        // printf("b before dec "); print_arr(b);
+        bignum_dec(b);
+        // printf("b after dec "); print_arr(b);
+
+        /* Begin summing products: */
+        while (!bignum_is_zero(b))
+        {
+            /* c = tmp * tmp */
+            bignum_mul(&tmp, a, c);
+            /* Decrement b by one */
+            bignum_dec(b);
+
+            bignum_assign(&tmp, c);
+        }
+
+        /* c = tmp */
+        bignum_assign(c, &tmp);
+    }
+}
+#endif
+
+void bignum_assign(struct bn* dst, const struct bn* src)
+{
+    require(dst, "dst is null");
+    require(src, "src is null");
+    BN_CALL(assign);
+    BN_COUNT(bytes_moved, sizeof *dst);
+
+    memcpy(dst, src, sizeof *dst);
+}
+
+
+#ifdef BN_COUNTERS
+struct bn_counters bn_counters;
+
+#define BN_FN_NAME_(f) #f,
+const char* const bn_fn_names[BN_FN_COUNT] = { BN_COUNTED(BN_FN_NAME_) };
+
+void bn_counters_reset(void)
+{
+    memset(&bn_counters, 0, sizeof bn_counters);
+}
+#endif
+
+
+void bignum_pool_init(uint16_t count)
+{
+    /* Each temporary starts on its own ARENA_ALIGN boundary */
+    const uint32_t stride = (sizeof(struct bn) + ARENA_ALIGN - 1) & ~(uint32_t)(ARENA_ALIGN - 1);
+    char* slab = arena_get(count * stride);
+
+    pool_free = NULL;
+    while (count--)
+    {
+        struct bn* n = (struct bn*)(slab + count * stride);
+        memcpy(n->array, &pool_free, sizeof pool_free);
+        pool_free = n;
+    }
+}
+
+struct bn* bignum_tmp_get(void)
+{
+    BN_CALL(tmp_get);
+    struct bn* n = pool_free;
+    require(n, "bn pool exhausted");
+
+    memcpy(&pool_free, n->array, sizeof pool_free);
+#ifdef ARENA_PROFILE
+    arena_profile_pool(1);
+#endif
+    return n;
+}
+
+void bignum_tmp_put(struct bn* n)
+{
+    require(n, "n is null");
+
+    memcpy(n->array, &pool_free, sizeof pool_free);
+    pool_free = n;
+#ifdef ARENA_PROFILE
+    arena_profile_pool(-1);
+#endif
+}
+
+
+/* Private / Static functions. */
+static void _rshift_word(struct bn* a, int nwords)
+{
+    /* Naive method: */
+    require(a, "a is null");
+    require(nwords >= 0, "no negative shifts");
+
+    
+    
+    /* the words left once the low nwords are dropped */
+    uint16_t remaining = a->len > nwords ? a->len - nwords : 0;
+    BN_COUNT(bytes_moved, a->len * WORD_SIZE);
+    for (uint16_t i = 0; i < remaining; ++i)
+        a->array[i] = a->array[i+nwords];
+    
+    for (a->len = remaining; a->len > 0 && a->array[a->len-1] == 0; --a->len);
+
+}
+
+static void _lshift_word(struct bn* a, int nwords)
+{
+    require(a, "a is null");
+    require(nwords >= 0, "no negative shifts");
+
+    /*
+    if (a->len > 0 && nwords > 0) {
+    printf("_lshift_word:\n");
+    printf("a: ");
+    print_arr(a);
+    printf("nwords = %d\n", nwords);
+    }
+    */
+
+    if (a->len == 0 || nwords == 0)
+    {
+        // printf("no shifting.\n");
+        return;
+    }
+
+    int32_t i;
+    require (a->len-1 + nwords < BN_ARRAY_SIZE, "1094: overflow");
+    BN_COUNT(bytes_moved, (a->len + nwords) * WORD_SIZE);
+    for ( i = a->len-1; i >= 0; --i)
+        a->array[i+nwords] = a->array[i];
+    memset(a->array, 0, WORD_SIZE*nwords);
+    for (a->len += nwords; a->len > 0 && a->array[a->len-1] == 0; --a->len);
+
+    // printf("result: "); print_arr(a);
+
+}
+
+
+static void _lshift_one_bit(struct bn* a)
+{
+    require(a, "a is null");
+
+    if (bignum_is_zero(a)) return;
+    
+    
+    BN_COUNT(limb_shift, a->len);
+    DTYPE f = a->array[a->len-1];
+    require (!(a->len == BN_ARRAY_SIZE && ((MAX_VAL >> 1) < f)), "this shouldn't not happen");
+
+    for (int i = (int)a->len-1; i > 0; --i)
+        a->array[i] = (a->array[i] << 1) | (a->array[i - 1] >> ((8 * WORD_SIZE) - 1));
+
+    a->array[0] <<= 1;
+    
+    if (a->len < BN_ARRAY_SIZE) {
+        a->array[a->len] = (f >> ((8 * WORD_SIZE) - 1));
+        if (a->array[a->len] > 0)
+            ++a->len;
+    }
+}
+
+
+static void _rshift_one_bit(struct bn* a)
+{
+    require(a, "a is null");
+
+    if (bignum_is_zero(a)) return;
+
+    BN_COUNT(limb_shift, a->len);
+    int i;
+    for (i = 0; i+1 < a->len; ++i)
+    {
+        a->array[i] = (a->array[i] >> 1) | (a->array[i + 1] << ((8 * WORD_SIZE) - 1));
+    }
+    a->array[a->len - 1] >>= 1;
+    if (a->array[a->len - 1] == 0)
+        --a->len;
+}
+
+#if defined(USE_IO) || !defined(__H8_2329F__)
+void print_arr(const struct bn* a)
+{
+    if (a->len == 0) {
+        printf("%4x ", 0);
+    } else {
+    for (int i = 0; i < a->len; ++i)
+        printf("%.4x ", a->array[i]);
+    }
+    printf("len = %d\n", a->len);
+}
+#endif
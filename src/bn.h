@@ -1,119 +1,229 @@
-#ifndef __BIGNUM_H__
-#define __BIGNUM_H__
-
-#include <stdint.h>
-#include <stdbool.h>
-
-#include "util.h"
-
-#define WORD_SIZE 2
-
-/* This macro defines the word size in bytes of the array that constitues the big-number data structure.*/
-#ifndef WORD_SIZE
-  #define WORD_SIZE 4
-#endif
-
-/* Size of big-numbers in bytes*/
-#define BN_ARRAY_SIZE    (512 / WORD_SIZE)
-
-
-/* Here comes the compile-time specialization for how large the underlying array size should be.*/
-/* The choices are 1, 2 and 4 bytes in size with uint32, uint64 for WORD_SIZE==4, as temporary.*/
-#ifndef WORD_SIZE
-  #error Must define WORD_SIZE to be 1, 2, 4
-#elif (WORD_SIZE == 1)
-  /* Data type of array in structure*/
-  #define DTYPE                    uint8_t
-  /* bitmask for getting MSB*/
-  #define DTYPE_MSB                ((DTYPE_TMP)(0x80))
-  /* Data-type larger than DTYPE, for holding intermediate results of calculations*/
-  #define DTYPE_TMP                uint32_t
-  /* sprintf format string*/
-  #define SPRINTF_FORMAT_STR       "%.02x"
-  #define SSCANF_FORMAT_STR        "%2hhx"
-  /* Max value of integer type*/
-  #define MAX_VAL                  ((DTYPE_TMP)0xFF)
-#elif (WORD_SIZE == 2)
-  #define DTYPE                    uint16_t
-  #define DTYPE_TMP                uint32_t
-  #define DTYPE_MSB                ((DTYPE_TMP)(0x8000))
-  #define SPRINTF_FORMAT_STR       "%.04x"
-  #define SSCANF_FORMAT_STR        "%4hx"
-  #define MAX_VAL                  ((DTYPE_TMP)0xFFFF)
-#elif (WORD_SIZE == 4)
-  #define DTYPE                    uint32_t
-  #define DTYPE_TMP                uint64_t
-  #define DTYPE_MSB                ((DTYPE_TMP)(0x80000000))
-  #define SPRINTF_FORMAT_STR       "%.08x"
-  #define SSCANF_FORMAT_STR        "%8x"
-  #define MAX_VAL                  ((DTYPE_TMP)0xFFFFFFFF)
-#endif
-#ifndef DTYPE
-  #error DTYPE must be defined to uint8_t, uint16_t uint32_t or whatever
-#endif
-
-
-
-/* Data-holding structure: array of DTYPEs*/
-struct bn
-{
-  DTYPE array[BN_ARRAY_SIZE];
-  uint16_t len;
-};
-
-struct karatsuba_ctx
-{
-  struct bn *pool;
-  uint16_t idx;
-};
-
-extern struct karatsuba_ctx karatsuba_ctx;
-
-/* Tokens returned by bignum_cmp() for value comparison*/
-enum { SMALLER = -1, EQUAL = 0, LARGER = 1 };
-
-
-
-/* Initialization functions:*/
-void bignum_init(struct bn* n); /* required*/
-void bignum_from_int(struct bn* n, DTYPE_TMP i); /* required*/
-// uint32_t  bignum_to_int(struct bn* n);
-// void bignum_from_string(struct bn* n, char* str, int nbytes);
-// void bignum_to_string(struct bn* n, char* str, int maxsize);
-void bignum_to_bytes(const struct bn* n, unsigned char* bytes, uint32_t len); /* required*/
-void bignum_from_bytes(struct bn* n, const unsigned char* bytes, uint32_t len); /* required*/
-
-/* Basic arithmetic operations:*/
-void bignum_add(struct bn* a, struct bn* b, struct bn* c); /* c = a + b*/ /* required*/
-void bignum_sub(struct bn* a, struct bn* b, struct bn* c); /* c = a - b*/ /* required*/
-void bignum_mul_naive(struct bn*, struct bn*, struct bn*);
-void bignum_mul_karatsuba(struct bn*, struct bn*, struct bn*);
-#ifdef NAIVE_MUL
-#define bignum_mul(a, b, c) bignum_mul_naive((a), (b), (c))
-#else
-#define bignum_mul(a, b, c) bignum_mul_karatsuba((a), (b), (c))
-#endif
-void bignum_div(struct bn* a, struct bn* b, struct bn* c); /* c = a / b*/ /* required*/
-void bignum_mod(struct bn* a, struct bn* b, struct bn* c); /* c = a % b*/ /* required*/
-
-/* Bitwise operations:*/
-// void bignum_and(struct bn* a, struct bn* b, struct bn* c); /* c = a & b*/
-void bignum_or(struct bn* a, struct bn* b, struct bn* c);  /* c = a | b*/ /* required*/
-// void bignum_xor(struct bn* a, struct bn* b, struct bn* c); /* c = a ^ b*/
-void bignum_lshift(struct bn* a, struct bn* b, int nbits); /* b = a << nbits*/
-void bignum_rshift(struct bn* a, struct bn* b, int nbits); /* b = a >> nbits*/
-
-/* Special operators and comparison*/
-int  bignum_cmp(struct bn* a, struct bn* b);               /* Compare: returns LARGER, EQUAL or SMALLER*/
-#define bignum_is_zero(n) (!((n)->len))
-//int  bignum_is_zero(struct bn* n);                         /* For comparison with zero*/ /* required*/
-// void bignum_inc(struct bn* n);                             /* Increment: add one to n*/
-// void bignum_dec(struct bn* n);                             /* Decrement: subtract one from n*/
-void bignum_pow(struct bn* a, struct bn* b, struct bn* c); /* Calculate a^b -- e.g. 2^10 => 1024*/
-void bignum_assign(struct bn* dst, const struct bn* src);        /* Copy src into dst -- dst := src*/ /* required*/
-
-void print_arr(const struct bn*);
-  
-#endif /* #ifndef __BIGNUM_H__*/
-
-
+#ifndef __BIGNUM_H__
+#define __BIGNUM_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "util.h"
+
+/* This macro defines the word size in bytes of the array that constitues the big-number data structure.*/
+/* 2 unless the build says otherwise: `make bench` builds every size.*/
+#ifndef WORD_SIZE
+  #define WORD_SIZE 2
+#endif
+
+/* Width of big-numbers in bits. A product must fit, so this is twice the largest modulus.*/
+#ifndef BN_MAX_BITS
+  #define BN_MAX_BITS 4096
+#endif
+
+/* Size of big-numbers in words*/
+#define BN_ARRAY_SIZE    (BN_MAX_BITS / 8 / WORD_SIZE)
+
+
+/* Here comes the compile-time specialization for how large the underlying array size should be.*/
+/* The choices are 1, 2 and 4 bytes in size with uint32, uint64 for WORD_SIZE==4, as temporary.*/
+#ifndef WORD_SIZE
+  #error Must define WORD_SIZE to be 1, 2, 4
+#elif (WORD_SIZE == 1)
+  /* Data type of array in structure*/
+  #define DTYPE                    uint8_t
+  /* bitmask for getting MSB*/
+  #define DTYPE_MSB                ((DTYPE_TMP)(0x80))
+  /* Data-type larger than DTYPE, for holding intermediate results of calculations*/
+  #define DTYPE_TMP                uint32_t
+  /* sprintf format string*/
+  #define SPRINTF_FORMAT_STR       "%.02x"
+  #define SSCANF_FORMAT_STR        "%2hhx"
+  /* Max value of integer type*/
+  #define MAX_VAL                  ((DTYPE_TMP)0xFF)
+#elif (WORD_SIZE == 2)
+  #define DTYPE                    uint16_t
+  #define DTYPE_TMP                uint32_t
+  #define DTYPE_MSB                ((DTYPE_TMP)(0x8000))
+  #define SPRINTF_FORMAT_STR       "%.04x"
+  #define SSCANF_FORMAT_STR        "%4hx"
+  #define MAX_VAL                  ((DTYPE_TMP)0xFFFF)
+#elif (WORD_SIZE == 4)
+  #define DTYPE                    uint32_t
+  #define DTYPE_TMP                uint64_t
+  #define DTYPE_MSB                ((DTYPE_TMP)(0x80000000))
+  #define SPRINTF_FORMAT_STR       "%.08x"
+  #define SSCANF_FORMAT_STR        "%8x"
+  #define MAX_VAL                  ((DTYPE_TMP)0xFFFFFFFF)
+#endif
+#ifndef DTYPE
+  #error DTYPE must be defined to uint8_t, uint16_t uint32_t or whatever
+#endif
+
+
+
+/* Data-holding structure: array of DTYPEs*/
+struct bn
+{
+  DTYPE array[BN_ARRAY_SIZE];
+  uint16_t len;
+};
+
+/* sizeof(struct bn) in a build with the given BN_MAX_BITS and WORD_SIZE*/
+#define BN_STRUCT_BYTES(bits, ws) (((bits) / 8 + 2 + (ws) - 1) / (ws) * (ws))
+
+/* Operands shorter than this many words are left to bignum_mul_naive. Under
+   4, (x0 + x1) is no shorter than its operand and the recursion never ends.*/
+#ifndef BN_KARATSUBA_CUTOFF
+  #define BN_KARATSUBA_CUTOFF 10
+#endif
+#if BN_KARATSUBA_CUTOFF < 4
+  #error BN_KARATSUBA_CUTOFF must be at least 4
+#endif
+
+/* Worst-case recursion depth of bignum_mul_karatsuba on L-word operands.
+   Each level recurses on (x0 + x1) * (y0 + y1), which can be ceil(L/2) + 1 words
+   long; nine levels cover 5000 words, more than BN_MAX_BITS ever allows.*/
+#define BN_KARATSUBA_DEPTH(L) BN_KD0_(L)
+#define BN_KHALF_(L) (((L) + 1) / 2 + 1)
+#define BN_KD0_(L) ((L) < BN_KARATSUBA_CUTOFF ? 0 : 1 + BN_KD1_(BN_KHALF_(L)))
+#define BN_KD1_(L) ((L) < BN_KARATSUBA_CUTOFF ? 0 : 1 + BN_KD2_(BN_KHALF_(L)))
+#define BN_KD2_(L) ((L) < BN_KARATSUBA_CUTOFF ? 0 : 1 + BN_KD3_(BN_KHALF_(L)))
+#define BN_KD3_(L) ((L) < BN_KARATSUBA_CUTOFF ? 0 : 1 + BN_KD4_(BN_KHALF_(L)))
+#define BN_KD4_(L) ((L) < BN_KARATSUBA_CUTOFF ? 0 : 1 + BN_KD5_(BN_KHALF_(L)))
+#define BN_KD5_(L) ((L) < BN_KARATSUBA_CUTOFF ? 0 : 1 + BN_KD6_(BN_KHALF_(L)))
+#define BN_KD6_(L) ((L) < BN_KARATSUBA_CUTOFF ? 0 : 1 + BN_KD7_(BN_KHALF_(L)))
+#define BN_KD7_(L) ((L) < BN_KARATSUBA_CUTOFF ? 0 : 1 + BN_KD8_(BN_KHALF_(L)))
+#define BN_KD8_(L) ((L) < BN_KARATSUBA_CUTOFF ? 0 : 1)
+
+/* Pooled temporaries held at once by bignum_mod on L-word operands: its own
+   product plus the larger of bignum_div's 3 and karatsuba's 9 per level.*/
+#define BN_MOD_TEMPS(L) (1 + (9 * BN_KARATSUBA_DEPTH(L) > 3 ? 9 * BN_KARATSUBA_DEPTH(L) : 3))
+
+/* Tokens returned by bignum_cmp() for value comparison*/
+enum { SMALLER = -1, EQUAL = 0, LARGER = 1 };
+
+
+
+/* Initialization functions:*/
+void bignum_init(struct bn* n); /* required*/
+void bignum_from_int(struct bn* n, DTYPE_TMP i); /* required*/
+// uint32_t  bignum_to_int(struct bn* n);
+// void bignum_from_string(struct bn* n, char* str, int nbytes);
+// void bignum_to_string(struct bn* n, char* str, int maxsize);
+void bignum_to_bytes(const struct bn* n, unsigned char* bytes, uint32_t len); /* required*/
+void bignum_from_bytes(struct bn* n, const unsigned char* bytes, uint32_t len); /* required*/
+void bignum_from_bytes_in_place(struct bn* n, uint32_t len); /* the len bytes at n->array, big-endian*/
+
+/* Basic arithmetic operations:*/
+void bignum_add(struct bn* a, struct bn* b, struct bn* c); /* c = a + b*/ /* required*/
+void bignum_sub(struct bn* a, struct bn* b, struct bn* c); /* c = a - b*/ /* required*/
+void bignum_mul_naive(struct bn*, struct bn*, struct bn*);
+void bignum_mul_karatsuba(struct bn*, struct bn*, struct bn*);
+#ifdef NAIVE_MUL
+#define bignum_mul(a, b, c) bignum_mul_naive((a), (b), (c))
+#else
+#define bignum_mul(a, b, c) bignum_mul_karatsuba((a), (b), (c))
+#endif
+void bignum_div(struct bn* a, struct bn* b, struct bn* c); /* c = a / b*/ /* required*/
+void bignum_mod(struct bn* a, struct bn* b, struct bn* c); /* c = a % b*/ /* required*/
+
+/* Bitwise operations:*/
+// void bignum_and(struct bn* a, struct bn* b, struct bn* c); /* c = a & b*/
+void bignum_or(struct bn* a, struct bn* b, struct bn* c);  /* c = a | b*/ /* required*/
+// void bignum_xor(struct bn* a, struct bn* b, struct bn* c); /* c = a ^ b*/
+void bignum_lshift(struct bn* a, struct bn* b, int nbits); /* b = a << nbits*/
+void bignum_rshift(struct bn* a, struct bn* b, int nbits); /* b = a >> nbits*/
+
+/* Special operators and comparison*/
+int  bignum_cmp(struct bn* a, struct bn* b);               /* Compare: returns LARGER, EQUAL or SMALLER*/
+#define bignum_is_zero(n) (!((n)->len))
+//int  bignum_is_zero(struct bn* n);                         /* For comparison with zero*/ /* required*/
+// void bignum_inc(struct bn* n);                             /* Increment: add one to n*/
+// void bignum_dec(struct bn* n);                             /* Decrement: subtract one from n*/
+void bignum_pow(struct bn* a, struct bn* b, struct bn* c); /* Calculate a^b -- e.g. 2^10 => 1024*/
+void bignum_assign(struct bn* dst, const struct bn* src);        /* Copy src into dst -- dst := src*/ /* required*/
+
+/* Montgomery constants of an odd modulus n of s words, R = 2^(8 * WORD_SIZE * s).
+   Plain limb arrays, least significant word first, so a context can sit in
+   ROM or in a mapped file as well as in the arena.*/
+struct bn_mont
+{
+  const DTYPE* n;
+  const DTYPE* rr;  /* R^2 mod n, s words: a Montgomery product with it enters the form*/
+  uint16_t len;     /* s*/
+  DTYPE n0;         /* -1/n mod 2^(8 * WORD_SIZE)*/
+};
+
+/* A fixed exponent as a sliding-window addition chain: chain[0] is the window
+   w, then one byte per step, 0 to square the accumulator or an odd k < 2^w to
+   multiply it by a^k (the first such step loads it). The 2^(w-1) odd powers
+   of a are kept on the stack, so the widest window is a build option.*/
+#ifndef BN_CHAIN_MAX_WINDOW
+  #ifdef __H8_2329F__
+    #define BN_CHAIN_MAX_WINDOW 1
+  #else
+    #define BN_CHAIN_MAX_WINDOW 4
+  #endif
+#endif
+
+/* Fixed window of bignum_mont_exp_ct, a divisor of the word size: the 2^w
+   powers of a are kept on the stack and all read for every w bits of e.*/
+#ifndef BN_CT_WINDOW
+  #ifdef __H8_2329F__
+    #define BN_CT_WINDOW 2
+  #else
+    #define BN_CT_WINDOW 4
+  #endif
+#endif
+
+/* Montgomery arithmetic, for moduli of up to half of BN_MAX_BITS:*/
+void bignum_mont_init(struct bn_mont* m, const DTYPE* n, uint16_t s, DTYPE* rr); /* fills the s words of rr*/
+void bignum_mont_mul(const struct bn_mont* m, const struct bn* a, const struct bn* b, struct bn* c); /* c = a * b / R mod n; a, b < n*/
+void bignum_mont_mod(const struct bn_mont* m, const struct bn* a, struct bn* c); /* c = a mod n; a < n * R*/
+void bignum_mont_exp(const struct bn_mont* m, const struct bn* a, const DTYPE* e, uint16_t elen, struct bn* c); /* c = a^e mod n; a < n*/
+void bignum_mont_exp_ct(const struct bn_mont* m, const struct bn* a, const DTYPE* e, uint16_t elen, struct bn* c); /* c = a^e mod n, for secret e: the work and memory accesses depend on elen only; a < n*/
+void bignum_mont_exp_chain(const struct bn_mont* m, const struct bn* a, const unsigned char* chain, uint16_t len, struct bn* c); /* c = a^e mod n; a < n*/
+void bignum_mont_mul_limbs(const struct bn_mont* m, const DTYPE* a, const DTYPE* b, DTYPE* c); /* c = a * b / R mod n on arrays of m->len words; a, b < n*/
+void bignum_mont_exp_limbs(const struct bn_mont* m, const DTYPE* a, const DTYPE* e, uint16_t elen, DTYPE* c); /* the same for a^e; c may be a*/
+bool bignum_mont_inv(const struct bn_mont* m, const struct bn* a, struct bn* c); /* c = a^-1 mod n, not in constant time; false when gcd(a, n) > 1; a < n*/
+void bignum_from_limbs(struct bn* n, const DTYPE* limbs, uint16_t len);
+
+/* Pool of temporaries carved from the arena once, recycled through a free list */
+void bignum_pool_init(uint16_t count);
+struct bn* bignum_tmp_get(void);
+void bignum_tmp_put(struct bn* n);
+
+/* -DBN_COUNTERS counts the work done, to estimate its cost on a target that
+   cannot be profiled (`make counters`): limb operations, bytes moved, calls
+   per function and how deep Karatsuba went, and the blocks the hashes
+   compress. Without it the counts are free.*/
+#ifdef BN_COUNTERS
+#define BN_COUNTED(X) X(init) X(from_int) X(to_bytes) X(from_bytes) X(add) X(sub) \
+                      X(mul_naive) X(mul_karatsuba) X(div) X(mod) X(lshift) X(rshift) \
+                      X(cmp) X(assign) X(tmp_get) X(mont_init) X(mont_mul) X(mont_exp)
+#define BN_FN_ENUM_(f) BN_FN_##f,
+enum bn_fn { BN_COUNTED(BN_FN_ENUM_) BN_FN_COUNT };
+
+struct bn_counters
+{
+  uint64_t limb_mul;     /* DTYPE by DTYPE products*/
+  uint64_t limb_add;     /* limb additions, subtractions and comparisons*/
+  uint64_t limb_shift;   /* limbs shifted by bits*/
+  uint64_t bytes_moved;  /* copied, cleared or reordered*/
+  uint64_t calls[BN_FN_COUNT];
+  uint64_t blocks_sha1, blocks_sha256, blocks_sha512;  /* compressed, whatever the backend*/
+  uint16_t karatsuba_depth, karatsuba_max_depth;
+};
+extern struct bn_counters bn_counters;
+extern const char* const bn_fn_names[BN_FN_COUNT];
+void bn_counters_reset(void);
+
+#define BN_COUNT(what, n) (bn_counters.what += (n))
+#define BN_CALL(f) (++bn_counters.calls[BN_FN_##f])
+#else
+#define BN_COUNT(what, n) ((void)0)
+#define BN_CALL(f) ((void)0)
+#endif
+
+void print_arr(const struct bn*);
+  
+#endif /* #ifndef __BIGNUM_H__*/
+
+
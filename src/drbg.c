@@ -0,0 +1,308 @@
+#ifndef __H8_2329F__
+#define _DEFAULT_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <sys/random.h>
+#endif
+
+#ifndef __H8_2329F__
+#include <unistd.h>
+#define DRBG_FORK_CHECK
+#endif
+
+#include "drbg.h"
+#include "util.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+
+#define ROL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+#define QR(a, b, c, d) do { \
+    a += b; d ^= a; d = ROL(d, 16); \
+    c += d; b ^= c; b = ROL(b, 12); \
+    a += b; d ^= a; d = ROL(d, 8); \
+    c += d; b ^= c; b = ROL(b, 7); \
+  } while (0)
+
+/* Column then diagonal quarter rounds, over whatever x[] holds */
+#define DOUBLE_ROUND(QR) do { \
+    QR(x[0], x[4], x[8], x[12]); QR(x[1], x[5], x[9], x[13]); \
+    QR(x[2], x[6], x[10], x[14]); QR(x[3], x[7], x[11], x[15]); \
+    QR(x[0], x[5], x[10], x[15]); QR(x[1], x[6], x[11], x[12]); \
+    QR(x[2], x[7], x[8], x[13]); QR(x[3], x[4], x[9], x[14]); \
+  } while (0)
+
+static void chacha20_init(uint32_t* s, const uint32_t key[8], uint32_t counter, const uint32_t nonce[3])
+{
+  s[0] = 0x61707865; s[1] = 0x3320646e; s[2] = 0x79622d32; s[3] = 0x6b206574;
+  memcpy(s + 4, key, 8 * sizeof *key);
+  s[12] = counter;
+  memcpy(s + 13, nonce, 3 * sizeof *nonce);
+}
+
+static void chacha20_block(const uint32_t* s, unsigned char* out)
+{
+  uint32_t x[16];
+  uint32_t i;
+
+  memcpy(x, s, sizeof x);
+  for (i = 0; i < 10; ++i) DOUBLE_ROUND(QR);
+
+  for (i = 0; i < 16; ++i) {
+    uint32_t v = x[i] + s[i];
+    out[4 * i] = (uint8_t) v;
+    out[4 * i + 1] = (uint8_t) (v >> 8);
+    out[4 * i + 2] = (uint8_t) (v >> 16);
+    out[4 * i + 3] = (uint8_t) (v >> 24);
+  }
+}
+
+#ifdef __SSE2__
+#define VROL(v, n) _mm_or_si128(_mm_slli_epi32(v, n), _mm_srli_epi32(v, 32 - (n)))
+#define VQR(a, b, c, d) do { \
+    a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = VROL(d, 16); \
+    c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = VROL(b, 12); \
+    a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = VROL(d, 8); \
+    c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = VROL(b, 7); \
+  } while (0)
+
+/* Four consecutive blocks, one per lane: word i of every block sits in x[i] */
+static void chacha20_block4(const uint32_t* s, unsigned char* out)
+{
+  __m128i x[16], in[16];
+  uint32_t w[4];
+  uint32_t i, l;
+
+  for (i = 0; i < 16; ++i) in[i] = _mm_set1_epi32((int)s[i]);
+  in[12] = _mm_add_epi32(in[12], _mm_set_epi32(3, 2, 1, 0));
+  memcpy(x, in, sizeof x);
+
+  for (i = 0; i < 10; ++i) DOUBLE_ROUND(VQR);
+
+  /*  x86 is little-endian, so words go out as they are */
+  for (i = 0; i < 16; ++i) {
+    _mm_storeu_si128((__m128i*)w, _mm_add_epi32(x[i], in[i]));
+    for (l = 0; l < 4; ++l) memcpy(out + 64 * l + 4 * i, &w[l], 4);
+  }
+}
+#endif
+
+void chacha20_blocks(const uint32_t key[8], uint32_t counter, const uint32_t nonce[3],
+                     unsigned char* out, uint32_t nblocks)
+{
+  uint32_t s[16];
+
+  chacha20_init(s, key, counter, nonce);
+#ifdef __SSE2__
+  for (; nblocks >= 4; nblocks -= 4, out += 4 * 64, s[12] += 4)
+    chacha20_block4(s, out);
+#endif
+  for (; nblocks > 0; --nblocks, out += 64, ++s[12])
+    chacha20_block(s, out);
+}
+
+
+/*  Fast key erasure: every refill runs ChaCha20 under the current key, keeps
+    the first 32 bytes as the next key and hands out the rest, wiping bytes
+    as they leave the buffer. */
+static DRBG_THREAD struct {
+  uint32_t key[8];
+  unsigned char buf[DRBG_BLOCKS * 64];
+  uint32_t avail;          /* unread bytes at the end of buf */
+  uint32_t since_reseed;   /* bytes handed out under the current entropy */
+#ifdef DRBG_FORK_CHECK
+  pid_t pid;               /* process that last reseeded: a forked child
+                              inherits the state and must not replay it */
+#endif
+  bool seeded;
+  bool deterministic;
+} drbg;
+
+static bool os_entropy(unsigned char* out, uint32_t len)
+{
+#if defined(__linux__)
+  while (len > 0) {
+    ssize_t got = getrandom(out, len, 0);
+    if (got <= 0) return false;
+    out += got;
+    len -= (uint32_t)got;
+  }
+  return true;
+#elif !defined(__H8_2329F__)
+  FILE* f = fopen("/dev/urandom", "rb");
+  bool ok = f && fread(out, 1, len, f) == len;
+  if (f) fclose(f);
+  return ok;
+#else
+  (void)out; (void)len;
+  return false;
+#endif
+}
+
+/*  Folds 32 bytes of OS entropy into the key */
+static bool drbg_reseed(void)
+{
+  unsigned char fresh[32];
+  uint32_t i;
+
+  if (!os_entropy(fresh, sizeof fresh)) return false;
+  for (i = 0; i < 8; ++i)
+    drbg.key[i] ^= (uint32_t)fresh[4 * i] | (uint32_t)fresh[4 * i + 1] << 8 |
+                   (uint32_t)fresh[4 * i + 2] << 16 | (uint32_t)fresh[4 * i + 3] << 24;
+  memset(fresh, 0, sizeof fresh);
+
+  drbg.since_reseed = 0;
+  drbg.avail = 0;
+  drbg.seeded = true;
+#ifdef DRBG_FORK_CHECK
+  drbg.pid = getpid();
+#endif
+  return true;
+}
+
+static void drbg_refill(void)
+{
+  static const uint32_t nonce[3] = { 0, 0, 0 };
+  uint32_t i;
+
+  chacha20_blocks(drbg.key, 0, nonce, drbg.buf, DRBG_BLOCKS);
+  for (i = 0; i < 8; ++i)
+    drbg.key[i] = (uint32_t)drbg.buf[4 * i] | (uint32_t)drbg.buf[4 * i + 1] << 8 |
+                  (uint32_t)drbg.buf[4 * i + 2] << 16 | (uint32_t)drbg.buf[4 * i + 3] << 24;
+  memset(drbg.buf, 0, 32);
+  drbg.avail = sizeof drbg.buf - 32;
+}
+
+/*  Whether OS-seeded output is due fresh entropy: by volume, or because
+    this is a fork of the process that seeded it */
+static bool drbg_stale(void)
+{
+  if (drbg.deterministic) return false;
+  if (drbg.since_reseed >= DRBG_RESEED_INTERVAL) return true;
+#ifdef DRBG_FORK_CHECK
+  if (drbg.pid != getpid()) return true;
+#endif
+  return false;
+}
+
+bool drbg_bytes(unsigned char* out, uint32_t len)
+{
+  if (!drbg.seeded || drbg_stale())
+    if (!drbg_reseed()) return false;
+
+  drbg.since_reseed += len;
+  while (len > 0) {
+    uint32_t chunk;
+    unsigned char* src;
+
+    if (drbg.avail == 0) drbg_refill();
+    chunk = len < drbg.avail ? len : drbg.avail;
+    src = drbg.buf + sizeof drbg.buf - drbg.avail;
+
+    memcpy(out, src, chunk);
+    memset(src, 0, chunk);
+    drbg.avail -= chunk;
+    out += chunk;
+    len -= chunk;
+  }
+  return true;
+}
+
+void drbg_seed(const unsigned char* seed, uint32_t len)
+{
+  unsigned char key[32] = { 0 };
+  uint32_t i;
+
+  memcpy(key, seed, len < sizeof key ? len : sizeof key);
+  for (i = 0; i < 8; ++i)
+    drbg.key[i] = (uint32_t)key[4 * i] | (uint32_t)key[4 * i + 1] << 8 |
+                  (uint32_t)key[4 * i + 2] << 16 | (uint32_t)key[4 * i + 3] << 24;
+
+  memset(drbg.buf, 0, sizeof drbg.buf);
+  drbg.avail = 0;
+  drbg.since_reseed = 0;
+  drbg.seeded = true;
+  drbg.deterministic = true;
+}
+
+
+#ifdef DRBG_MAIN
+#include <sys/wait.h>
+
+int main()
+{
+  /*  RFC 8439, 2.3.2 */
+  static const uint32_t key[8] = {
+    0x03020100, 0x07060504, 0x0b0a0908, 0x0f0e0d0c,
+    0x13121110, 0x17161514, 0x1b1a1918, 0x1f1e1d1c
+  };
+  static const uint32_t nonce[3] = { 0x09000000, 0x4a000000, 0x00000000 };
+  unsigned char expected_hex[] =
+    "10f1e7e4d13b5915500fdd1fa32071c4c7d1f4c733c068030422aa9ac3d46c4e"
+    "d2826446079faa0914c2d705d98b02a2b5129cd1de164eb9cbd083e8a2503c4e";
+  unsigned char expected[64];
+  unsigned char out[8 * 64], again[8 * 64];
+  uint32_t i;
+
+  unhexlify(expected_hex, 128, expected);
+  chacha20_blocks(key, 1, nonce, out, 1);
+  printf("chacha20 block = "); print_hex(out, 64);
+  require (memcmp(out, expected, 64) == 0, "invalid keystream");
+
+  /*  the vector path has to agree with the block at a time one */
+  chacha20_blocks(key, 0, nonce, out, 8);
+  for (i = 0; i < 8; ++i) chacha20_blocks(key, i, nonce, again + 64 * i, 1);
+  require (memcmp(out, again, sizeof out) == 0, "batched keystream differs");
+
+  /*  deterministic mode repeats itself, however the output is split */
+  drbg_seed((const unsigned char*)"seed", 4);
+  require (drbg_bytes(out, sizeof out), "drbg failed");
+  drbg_seed((const unsigned char*)"seed", 4);
+  for (i = 0; i < sizeof again; i += 20)
+    require (drbg_bytes(again + i, sizeof again - i < 20 ? sizeof again - i : 20), "drbg failed");
+  require (memcmp(out, again, sizeof out) == 0, "deterministic stream differs");
+
+  /*  and the OS-seeded mode does not */
+  drbg.seeded = drbg.deterministic = false;
+  require (drbg_bytes(again, sizeof again), "no OS entropy");
+  require (memcmp(out, again, sizeof out) != 0, "OS-seeded stream repeats the seeded one");
+
+  /*  a forked child draws from the same inherited state as its parent, so
+      it has to reseed rather than hand out the parent's next bytes */
+  {
+    int fds[2], status;
+    pid_t child;
+
+    require (pipe(fds) == 0, "pipe failed");
+    child = fork();
+    require (child >= 0, "fork failed");
+    if (child == 0) {
+      bool ok = drbg_bytes(again, sizeof again) &&
+                write(fds[1], again, sizeof again) == (ssize_t)sizeof again;
+      _exit(ok ? 0 : 1);
+    }
+    close(fds[1]);
+    require (drbg_bytes(out, sizeof out), "drbg failed");
+    for (i = 0; i < sizeof again; ) {
+      ssize_t got = read(fds[0], again + i, sizeof again - i);
+      require (got > 0, "child output short");
+      i += (uint32_t)got;
+    }
+    close(fds[0]);
+    require (waitpid(child, &status, 0) == child && WIFEXITED(status) &&
+             WEXITSTATUS(status) == 0, "child failed");
+    require (memcmp(out, again, sizeof out) != 0, "forked child repeats the parent's stream");
+  }
+
+  printf("OK\n");
+  return 0;
+}
+#endif
@@ -0,0 +1,44 @@
+#ifndef __DRBG__
+#define __DRBG__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ChaCha20 blocks generated per refill: the output is buffered so that a
+   hLen-byte OAEP seed is a memcpy, not a syscall or a cipher call */
+#ifndef DRBG_BLOCKS
+  #ifdef __H8_2329F__
+    #define DRBG_BLOCKS 1
+  #else
+    #define DRBG_BLOCKS 16
+  #endif
+#endif
+
+/* Bytes handed out before the key is mixed with fresh OS entropy */
+#ifndef DRBG_RESEED_INTERVAL
+  #define DRBG_RESEED_INTERVAL (1UL << 20)
+#endif
+
+/* One generator per thread where the compiler has thread-local storage */
+#if defined(__GNUC__) && !defined(__H8_2329F__)
+  #define DRBG_THREAD __thread
+#else
+  #define DRBG_THREAD
+#endif
+
+/* Fills out with len random bytes. The calling thread's generator is seeded
+   from the OS on first use, and again in a forked child so that it does not
+   repeat its parent; false if no entropy source is available (the H8S has
+   none: call drbg_seed first). */
+bool drbg_bytes(unsigned char* out, uint32_t len);
+
+/* Switches the calling thread's generator to deterministic mode: the same
+   seed (up to 32 bytes) gives the same stream, and the OS is never consulted.
+   For reproducible tests and benchmarks only. */
+void drbg_seed(const unsigned char* seed, uint32_t len);
+
+/* Keystream of ChaCha20 (RFC 8439) for `nblocks` 64-byte blocks */
+void chacha20_blocks(const uint32_t key[8], uint32_t counter, const uint32_t nonce[3],
+                     unsigned char* out, uint32_t nblocks);
+
+#endif
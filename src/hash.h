@@ -0,0 +1,52 @@
+#ifndef __HASH__
+#define __HASH__
+
+#include <stdint.h>
+
+/* Largest digest of the hashes below, for fixed-size buffers */
+#define HASH_MAX_LEN 64
+
+/* Largest running state (SHA-512's; SHA-256's without 64-bit integers) */
+#ifdef __H8_2329F__
+  #define HASH_MAX_CTX 100
+#else
+  #define HASH_MAX_CTX 200
+#endif
+
+/* Storage any hash below can keep its context in */
+typedef union {
+  uint32_t w[HASH_MAX_CTX / 4];
+#ifndef __H8_2329F__
+  uint64_t align;
+#endif
+} hash_ctx;
+
+/* Independent messages hashed together through the batch entry points */
+#ifdef __H8_2329F__
+  #define HASH_BATCH 1
+#else
+  #define HASH_BATCH 16
+#endif
+
+/* A hash function OAEP and MGF1 are parameterized over. hLen is `len`.
+   Contexts are plain data: copying ctx_size bytes forks a midstate.
+   update_n/final_n run n contexts at once; they are NULL for hashes
+   without a multi-buffer kernel. */
+struct hash {
+  uint32_t len;
+  uint32_t ctx_size;
+  int (*digest)(const unsigned char* input, uint32_t len, unsigned char* output);
+  void (*init)(void* ctx);
+  void (*update)(void* ctx, const unsigned char* input, uint32_t len);
+  void (*final)(void* ctx, unsigned char* output);
+  void (*update_n)(void* const* ctx, const unsigned char* const* input, const uint32_t* len, uint32_t n);
+  void (*final_n)(void* const* ctx, unsigned char* const* output, uint32_t n);
+};
+
+/* Each lives in its own translation unit, so a build only links the ones it
+   names. SHA-512 needs 64-bit integers and is left out of the H8S build. */
+extern const struct hash hash_sha1;    /* sha1.c */
+extern const struct hash hash_sha256;  /* sha256.c */
+extern const struct hash hash_sha512;  /* sha512.c */
+
+#endif
@@ -0,0 +1,341 @@
+#if defined(__linux__) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE /* MAP_PRIVATE on a file, fstat */
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define KEYSTORE_MMAP
+#endif
+
+#include "keystore.h"
+#include "sha256.h"
+#include "util.h"
+
+
+void keystore_id(const unsigned char* n, uint32_t nlen, unsigned char id[KEYSTORE_ID_LEN])
+{
+  for (; nlen > 1 && *n == 0; ++n, --nlen);
+  sha256(n, nlen, id);
+}
+
+/* Start of the probe sequence of an ID in an index of `slots` entries */
+static uint32_t slot_of(const unsigned char* id, uint32_t slots)
+{
+  return ((uint32_t)id[0] | (uint32_t)id[1] << 8 | (uint32_t)id[2] << 16 | (uint32_t)id[3] << 24) & (slots - 1);
+}
+
+
+/*  Writing: header | limb arrays | records | index. The limbs are streamed
+    out as each key is built, records and index follow once all are known,
+    and the header is written last over its placeholder. */
+static bool put_limbs(FILE* f, uint32_t* pos, const DTYPE* limbs, uint32_t len, uint32_t* off)
+{
+  static const unsigned char zero[KEYSTORE_ALIGN] = { 0 };
+  const uint32_t pad = (KEYSTORE_ALIGN - *pos % KEYSTORE_ALIGN) % KEYSTORE_ALIGN;
+
+  if (fwrite(zero, 1, pad, f) != pad || fwrite(limbs, WORD_SIZE, len, f) != len) return false;
+  *off = *pos + pad;
+  *pos += pad + len * WORD_SIZE;
+  return true;
+}
+
+static bool put_mont(FILE* f, uint32_t* pos, const struct bn_mont* m, struct keystore_mont* km)
+{
+  km->n0 = m->n0;
+  km->len = m->len;
+  return put_limbs(f, pos, m->n, m->len, &km->n) && put_limbs(f, pos, m->rr, m->len, &km->rr);
+}
+
+/* Builds the contexts of one key and streams out their limbs */
+static bool put_key(FILE* f, uint32_t* pos, const struct rsa_key_view* v, struct keystore_record* r)
+{
+  const uint32_t mark = arena_mark();
+  bool ok = false;
+
+#ifdef RSA_DECRYPT
+  if (v->d.len) {
+    struct rsa_priv key;
+    r->flags = KEYSTORE_PRIVATE;
+    ok = rsa_priv_init(&key, v) &&
+         put_mont(f, pos, &key.pub.mont, &r->n) &&
+         put_mont(f, pos, &key.p, &r->p) && put_mont(f, pos, &key.q, &r->q) &&
+         put_limbs(f, pos, key.dp, key.dplen, &r->dp) &&
+         put_limbs(f, pos, key.dq, key.dqlen, &r->dq) &&
+         put_limbs(f, pos, key.qinv_r, key.p.len, &r->qinv_r);
+    r->nlen = key.pub.nlen;
+    r->e = key.pub.e;
+    r->dplen = key.dplen;
+    r->dqlen = key.dqlen;
+  } else
+#endif
+  {
+    struct rsa_pub key;
+    uint32_t e = 0, i;
+    for (i = 0; i < v->e.len && i < 4; ++i) e = e << 8 | v->e.p[i];
+    ok = v->e.len && v->e.len <= 4 && rsa_pub_init(&key, v->n.p, v->n.len, e) &&
+         put_mont(f, pos, &key.mont, &r->n);
+    r->nlen = key.nlen;
+    r->e = key.e;
+  }
+
+  arena_rollback(mark);
+  return ok;
+}
+
+/* Opens path for writing, emptied; where files have owners, it is made
+   readable by its owner alone, as private keys go in */
+static FILE* create_private(const char* path)
+{
+#ifdef KEYSTORE_MMAP
+  int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  FILE* f = NULL;
+
+  /*  an existing file keeps its mode through O_CREAT */
+  if (fd >= 0 && fchmod(fd, 0600) == 0) f = fdopen(fd, "wb");
+  if (fd >= 0 && !f) close(fd);
+  return f;
+#else
+  return fopen(path, "wb");
+#endif
+}
+
+bool keystore_write(const char* path, const struct rsa_key_view* keys, uint32_t count)
+{
+  struct keystore_header h;
+  struct keystore_record* records = calloc(count ? count : 1, sizeof *records);
+  uint32_t slots = 1, pos = sizeof h, i, n = 0;
+  uint32_t* index;
+  FILE* f;
+  bool ok = false;
+
+  while (slots < 2 * count) slots <<= 1;
+  index = calloc(slots, sizeof *index);
+  f = create_private(path);
+  if (!records || !index || !f) goto out;
+
+  memset(&h, 0, sizeof h);
+  if (fwrite(&h, sizeof h, 1, f) != 1) goto out;
+
+  for (i = 0; i < count; ++i) {
+    struct keystore_record* r = &records[n];
+    uint32_t s;
+
+    keystore_id(keys[i].n.p, keys[i].n.len, r->id);
+    for (s = slot_of(r->id, slots); index[s]; s = (s + 1) & (slots - 1))
+      if (!memcmp(records[index[s] - 1].id, r->id, KEYSTORE_ID_LEN)) break;
+    if (index[s]) continue; /* the same modulus again: the first one stays */
+
+    if (!put_key(f, &pos, &keys[i], r)) goto out;
+    index[s] = ++n;
+  }
+
+  /*  records, then the index, both on the limb alignment */
+  for (; pos % KEYSTORE_ALIGN; ++pos)
+    if (fputc(0, f) == EOF) goto out;
+  h.records = pos;
+  pos += n * sizeof *records;
+  h.index = pos;
+  pos += slots * sizeof *index;
+  if (fwrite(records, sizeof *records, n, f) != n || fwrite(index, sizeof *index, slots, f) != slots) goto out;
+
+  memcpy(h.magic, KEYSTORE_MAGIC, sizeof KEYSTORE_MAGIC);
+  h.version = KEYSTORE_VERSION;
+  h.word_size = WORD_SIZE;
+  h.byte_order = KEYSTORE_BYTE_ORDER;
+  h.count = n;
+  h.slots = slots;
+  h.size = pos;
+  ok = fseek(f, 0, SEEK_SET) == 0 && fwrite(&h, sizeof h, 1, f) == 1;
+
+out:
+  if (f && fclose(f)) ok = false;
+  free(index);
+  free(records);
+  return ok;
+}
+
+
+bool keystore_open(struct keystore* ks, const char* path)
+{
+  const struct keystore_header* h;
+
+  ks->base = NULL;
+  ks->size = 0;
+
+#ifdef KEYSTORE_MMAP
+  struct stat st;
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return false;
+  if (fstat(fd, &st) == 0 && (uint64_t)st.st_size >= sizeof *h && (uint64_t)st.st_size < UINT32_MAX) {
+    void* p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p != MAP_FAILED) {
+      ks->base = p;
+      ks->size = (uint32_t)st.st_size;
+    }
+  }
+  close(fd);
+#else
+  FILE* fp = fopen(path, "rb");
+  long size;
+  if (!fp) return false;
+  if (fseek(fp, 0, SEEK_END) == 0 && (size = ftell(fp)) >= (long)sizeof *h && fseek(fp, 0, SEEK_SET) == 0) {
+    unsigned char* p = malloc((size_t)size);
+    if (p && fread(p, 1, (size_t)size, fp) == (size_t)size) {
+      ks->base = p;
+      ks->size = (uint32_t)size;
+    } else {
+      free(p);
+    }
+  }
+  fclose(fp);
+#endif
+  if (!ks->base) return false;
+
+  /*  the header is all there is to check: the rest is used as it lies */
+  h = ks->h = (const struct keystore_header*)ks->base;
+  if (memcmp(h->magic, KEYSTORE_MAGIC, sizeof KEYSTORE_MAGIC) || h->version != KEYSTORE_VERSION ||
+      h->word_size != WORD_SIZE || h->byte_order != KEYSTORE_BYTE_ORDER || h->size != ks->size ||
+      !h->slots || (h->slots & (h->slots - 1)) || h->count >= h->slots ||
+      h->records % KEYSTORE_ALIGN || h->index % KEYSTORE_ALIGN ||
+      h->records > ks->size || (ks->size - h->records) / sizeof *ks->records < h->count ||
+      h->index > ks->size || (ks->size - h->index) / sizeof(uint32_t) < h->slots) {
+    keystore_close(ks);
+    return false;
+  }
+  ks->records = (const struct keystore_record*)(ks->base + h->records);
+  return true;
+}
+
+void keystore_close(struct keystore* ks)
+{
+#ifdef KEYSTORE_MMAP
+  if (ks->base) munmap((void*)ks->base, ks->size);
+#else
+  free((void*)ks->base);
+#endif
+  ks->base = NULL;
+  ks->size = 0;
+}
+
+const struct keystore_record* keystore_find(const struct keystore* ks, const unsigned char id[KEYSTORE_ID_LEN])
+{
+  const uint32_t* index = (const uint32_t*)(ks->base + ks->h->index);
+  const uint32_t mask = ks->h->slots - 1;
+  uint32_t s, r, probes;
+
+  /*  a store always has empty slots, but a damaged one may not: at most one
+      lap of the index */
+  for (s = slot_of(id, ks->h->slots), probes = 0; probes < ks->h->slots && (r = index[s]) != 0;
+       s = (s + 1) & mask, ++probes)
+    if (r <= ks->h->count && !memcmp(ks->records[r - 1].id, id, KEYSTORE_ID_LEN))
+      return &ks->records[r - 1];
+  return NULL;
+}
+
+/* The limb array at off, if len words of it lie inside the file */
+static const DTYPE* limbs_at(const struct keystore* ks, uint32_t off, uint32_t len)
+{
+  if (off % KEYSTORE_ALIGN || off > ks->size || (ks->size - off) / WORD_SIZE < len) return NULL;
+  return (const DTYPE*)(ks->base + off);
+}
+
+static bool mont_at(const struct keystore* ks, const struct keystore_mont* km, struct bn_mont* m)
+{
+  if (!km->len || km->len > BN_ARRAY_SIZE / 2) return false;
+  m->n = limbs_at(ks, km->n, km->len);
+  m->rr = limbs_at(ks, km->rr, km->len);
+  m->len = (uint16_t)km->len;
+  m->n0 = (DTYPE)km->n0;
+  return m->n && m->rr;
+}
+
+bool keystore_pub(const struct keystore* ks, const struct keystore_record* r, struct rsa_pub* key)
+{
+  key->nlen = r->nlen;
+  key->e = r->e;
+  key->chain = NULL;
+  key->chain_len = 0;
+  return mont_at(ks, &r->n, &key->mont);
+}
+
+#ifdef RSA_DECRYPT
+bool keystore_priv(const struct keystore* ks, const struct keystore_record* r, struct rsa_priv* key)
+{
+  if (!(r->flags & KEYSTORE_PRIVATE) || !keystore_pub(ks, r, &key->pub)) return false;
+  if (!mont_at(ks, &r->p, &key->p) || !mont_at(ks, &r->q, &key->q) || key->p.len != key->q.len) return false;
+
+  key->dp = limbs_at(ks, r->dp, r->dplen);
+  key->dq = limbs_at(ks, r->dq, r->dqlen);
+  key->qinv_r = limbs_at(ks, r->qinv_r, key->p.len);
+  key->dplen = (uint16_t)r->dplen;
+  key->dqlen = (uint16_t)r->dqlen;
+  return key->dp && key->dq && key->qinv_r && r->dplen <= BN_ARRAY_SIZE && r->dqlen <= BN_ARRAY_SIZE;
+}
+#endif
+
+
+#ifdef KEYSTORE_MAIN
+#include "pem.h"
+
+/* keystore OUT KEYFILE...: the contexts of every key in the PEM/DER files */
+int main(int argc, char** argv)
+{
+  struct key_file* files;
+  struct rsa_key_view* keys = NULL;
+  uint32_t count = 0, cap = 0;
+  int i, r, failed = 0;
+
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s OUT KEYFILE...\n", argv[0]);
+    return 2;
+  }
+  if (!arena_init(NULL, RSA_PRIV_BYTES(BN_MAX_BITS / 2, WORD_SIZE) +
+                        RSA_POOL_BYTES(BN_MAX_BITS / 2, WORD_SIZE)))
+    return 1;
+  bignum_pool_init(RSA_POOL_COUNT(BN_MAX_BITS / 2, WORD_SIZE));
+
+  /*  the views point into the files, so all stay mapped until written */
+  files = calloc((size_t)argc, sizeof *files);
+  for (i = 2; files && i < argc; ++i) {
+    if (!key_file_open(&files[i], argv[i])) {
+      fprintf(stderr, "%s: cannot open\n", argv[i]);
+      failed = 1;
+      continue;
+    }
+    for (;;) {
+      if (count == cap) {
+        cap = cap ? 2 * cap : 64;
+        keys = realloc(keys, cap * sizeof *keys);
+        if (!keys) return 1;
+      }
+      if ((r = key_file_next(&files[i], &keys[count])) == 0) break;
+      if (r < 0) {
+        fprintf(stderr, "%s: malformed key\n", argv[i]);
+        failed = 1;
+        continue;
+      }
+      ++count;
+    }
+  }
+
+  if (!failed && !keystore_write(argv[1], keys, count)) {
+    fprintf(stderr, "%s: cannot write\n", argv[1]);
+    failed = 1;
+  }
+  if (!failed) printf("%s: %u keys read\n", argv[1], count);
+
+  for (i = 2; files && i < argc; ++i)
+    if (files[i].base) key_file_close(&files[i]);
+  free(files);
+  free(keys);
+  arena_release();
+  return failed;
+}
+#endif
@@ -0,0 +1,88 @@
+#ifndef __KEYSTORE__
+#define __KEYSTORE__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "rsa.h"
+
+/* On-disk store of precomputed key contexts, used in place through mmap.
+
+     header | limb arrays | records | hash index
+
+   Every field is in the writer's byte order and every limb array in its
+   WORD_SIZE; the header records both and keystore_open refuses a store
+   written for another build. Offsets are from the start of the file.
+   A modulus stored twice keeps its first record. */
+#define KEYSTORE_MAGIC "RSAKCTX"
+#define KEYSTORE_VERSION 1
+#define KEYSTORE_BYTE_ORDER 0x01020304u
+
+/* Keys are found by the SHA-256 of their big-endian modulus */
+#define KEYSTORE_ID_LEN 32
+
+/* Limb arrays start on this boundary */
+#define KEYSTORE_ALIGN 8
+
+#define KEYSTORE_PRIVATE 1u
+
+struct keystore_header {
+  char magic[8];
+  uint32_t version;
+  uint32_t word_size;
+  uint32_t byte_order;
+  uint32_t count;    /* records */
+  uint32_t slots;    /* index entries, a power of two */
+  uint32_t index;    /* slots record numbers + 1, 0 for an empty slot */
+  uint32_t records;  /* count struct keystore_record */
+  uint32_t size;     /* of the whole file */
+};
+
+/* struct bn_mont with offsets for pointers */
+struct keystore_mont {
+  uint32_t n, rr;
+  uint32_t n0;
+  uint32_t len;
+};
+
+struct keystore_record {
+  unsigned char id[KEYSTORE_ID_LEN];
+  uint32_t flags;
+  uint32_t nlen;
+  uint32_t e;
+  struct keystore_mont n;
+  /* KEYSTORE_PRIVATE only */
+  struct keystore_mont p, q;
+  uint32_t dp, dq, qinv_r;
+  uint32_t dplen, dqlen;
+};
+
+/* A store mapped read-only */
+struct keystore {
+  const unsigned char* base;
+  uint32_t size;
+  const struct keystore_header* h;
+  const struct keystore_record* records;
+};
+
+/* SHA-256 of the modulus, leading zero bytes stripped */
+void keystore_id(const unsigned char* n, uint32_t nlen, unsigned char id[KEYSTORE_ID_LEN]);
+
+/* Writes the contexts of `count` keys to `path`. Builds them in the arena,
+   which needs RSA_PRIV_BYTES of the largest key free, and the bn pool. */
+bool keystore_write(const char* path, const struct rsa_key_view* keys, uint32_t count);
+
+/* Maps a store and checks its header: nothing else is read until used */
+bool keystore_open(struct keystore* ks, const char* path);
+void keystore_close(struct keystore* ks);
+
+/* The record of a key ID, or NULL */
+const struct keystore_record* keystore_find(const struct keystore* ks, const unsigned char id[KEYSTORE_ID_LEN]);
+
+/* Key contexts pointing into the mapping, valid until keystore_close */
+bool keystore_pub(const struct keystore* ks, const struct keystore_record* r, struct rsa_pub* key);
+#ifdef RSA_DECRYPT
+bool keystore_priv(const struct keystore* ks, const struct keystore_record* r, struct rsa_priv* key);
+#endif
+
+#endif
@@ -0,0 +1,346 @@
+#if defined(__linux__) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE /* MAP_PRIVATE on a file, fstat */
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(__H8_2329F__) && defined(__unix__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define PEM_MMAP
+#endif
+
+#include "pem.h"
+#include "util.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && !defined(PEM_NO_SSSE3)
+#define PEM_SSSE3
+#include <cpuid.h>
+#include <tmmintrin.h>
+#endif
+
+
+/* Sextet of each character; B64_SPACE is skipped, B64_PAD is '=' */
+#define B64_SPACE 0x40
+#define B64_PAD   0x80
+static const uint8_t b64_value[256] = {
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x40, 0x40, 0xff, 0xff, 0x40, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0x40, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x3e, 0xff, 0xff, 0xff, 0x3f,
+  0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0xff, 0xff, 0xff, 0x80, 0xff, 0xff,
+  0xff, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+  0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+  0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
+#ifdef PEM_SSSE3
+/* 16 characters to 12 bytes, if all 16 are in the alphabet: the nibbles of
+   each character index two masks whose AND is zero only for valid ones, and
+   a third table gives the offset from ASCII to the sextet. */
+__attribute__((target("ssse3")))
+static bool b64_decode16(const unsigned char* s, unsigned char* d)
+{
+  const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                       0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+  const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                       0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i mask_2f = _mm_set1_epi8(0x2f);
+  unsigned char out[16];
+
+  __m128i in = _mm_loadu_si128((const __m128i*)s);
+  const __m128i hi = _mm_and_si128(_mm_srli_epi32(in, 4), mask_2f);
+  const __m128i lo = _mm_and_si128(in, mask_2f);
+  const __m128i bad = _mm_and_si128(_mm_shuffle_epi8(lut_lo, lo), _mm_shuffle_epi8(lut_hi, hi));
+  if (_mm_movemask_epi8(_mm_cmpeq_epi8(bad, _mm_setzero_si128())) != 0xffff) return false;
+
+  /* '/' shares its high nibble with '+' but not its offset */
+  in = _mm_add_epi8(in, _mm_shuffle_epi8(lut_roll, _mm_add_epi8(_mm_cmpeq_epi8(in, mask_2f), hi)));
+
+  /* aaaaaabbbbbbccccccdddddd, three bytes to a 32-bit lane, big-endian */
+  in = _mm_maddubs_epi16(in, _mm_set1_epi32(0x01400140));
+  in = _mm_madd_epi16(in, _mm_set1_epi32(0x00011000));
+  in = _mm_shuffle_epi8(in, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+  _mm_storeu_si128((__m128i*)out, in);
+  memcpy(d, out, 12);
+  return true;
+}
+
+static bool have_ssse3(void)
+{
+  static int known = -1;
+  if (known < 0) {
+    unsigned a, b, c, d;
+    known = __get_cpuid(1, &a, &b, &c, &d) && (c & bit_SSSE3);
+  }
+  return known;
+}
+#endif
+
+int32_t base64_decode(const char* in, uint32_t len, unsigned char* out)
+{
+  const unsigned char* s = (const unsigned char*)in;
+  const unsigned char* end = s + len;
+  unsigned char* d = out;
+  uint32_t acc = 0, n = 0, pad = 0;
+#ifdef PEM_SSSE3
+  const bool simd = have_ssse3();
+#endif
+
+  while (s < end) {
+#ifdef PEM_SSSE3
+    /*  whole quanta at a time between line breaks */
+    if (simd && n == 0 && end - s >= 16 && b64_decode16(s, d)) {
+      s += 16;
+      d += 12;
+      continue;
+    }
+#endif
+    const uint8_t v = b64_value[*s++];
+    if (v < 64) {
+      if (pad) return -1;
+      acc = acc << 6 | v;
+      if (++n == 4) {
+        d[0] = (unsigned char)(acc >> 16);
+        d[1] = (unsigned char)(acc >> 8);
+        d[2] = (unsigned char)acc;
+        d += 3;
+        acc = n = 0;
+      }
+    } else if (v == B64_PAD) {
+      if (n + ++pad > 4 || n < 2) return -1;
+    } else if (v != B64_SPACE) {
+      return -1;
+    }
+  }
+
+  /*  the last quantum: 2 or 3 characters padded to 4 */
+  if (n) {
+    if (n + pad != 4) return -1;
+    acc <<= 6 * pad;
+    *d++ = (unsigned char)(acc >> 16);
+    if (n == 3) *d++ = (unsigned char)(acc >> 8);
+  }
+  return (int32_t)(d - out);
+}
+
+
+/* Takes the TLV of tag `tag` at *p, leaving *p after it */
+static bool der_take(const unsigned char** p, const unsigned char* end, uint8_t tag, struct der_view* v)
+{
+  const unsigned char* s = *p;
+  uint32_t len, n;
+
+  if (end - s < 2 || s[0] != tag) return false;
+  len = s[1];
+  s += 2;
+  if (len & 0x80) {
+    /*  long form, no indefinite lengths in DER */
+    n = len & 0x7f;
+    if (n == 0 || n > 4 || (uint32_t)(end - s) < n) return false;
+    for (len = 0; n > 0; --n) len = len << 8 | *s++;
+  }
+  if ((uint32_t)(end - s) < len) return false;
+
+  v->p = s;
+  v->len = len;
+  *p = s + len;
+  return true;
+}
+
+/* A non-negative INTEGER, as its magnitude */
+static bool der_uint(const unsigned char** p, const unsigned char* end, struct der_view* v)
+{
+  if (!der_take(p, end, 0x02, v) || v->len == 0 || (v->p[0] & 0x80)) return false;
+  while (v->len > 1 && v->p[0] == 0) {
+    ++v->p;
+    --v->len;
+  }
+  return true;
+}
+
+/* AlgorithmIdentifier { rsaEncryption, NULL } */
+static bool der_rsa_alg(const unsigned char** p, const unsigned char* end)
+{
+  static const unsigned char rsa_oid[] = { 0x2a, 0x86, 0x48, 0x86, 0xf7, 0x0d, 0x01, 0x01, 0x01 };
+  struct der_view alg, oid, null;
+  const unsigned char* q;
+
+  if (!der_take(p, end, 0x30, &alg)) return false;
+  q = alg.p;
+  if (!der_take(&q, alg.p + alg.len, 0x06, &oid)) return false;
+  if (oid.len != sizeof rsa_oid || memcmp(oid.p, rsa_oid, sizeof rsa_oid)) return false;
+  return q == alg.p + alg.len || (der_take(&q, alg.p + alg.len, 0x05, &null) && !null.len);
+}
+
+bool der_rsa_key(const unsigned char* der, uint32_t len, struct rsa_key_view* key)
+{
+  const unsigned char* p = der;
+  const unsigned char* end = der + len;
+  struct der_view seq, first, v;
+
+  memset(key, 0, sizeof *key);
+  if (!der_take(&p, end, 0x30, &seq) || p != end) return false;
+  p = seq.p;
+  end = seq.p + seq.len;
+
+  /*  SPKI: the RSAPublicKey sits in a BIT STRING after the algorithm */
+  if (p < end && *p == 0x30) {
+    if (!der_rsa_alg(&p, end) || !der_take(&p, end, 0x03, &v) || p != end) return false;
+    if (v.len < 1 || v.p[0] != 0) return false;
+    return der_rsa_key(v.p + 1, v.len - 1, key) && !key->d.len;
+  }
+
+  if (!der_uint(&p, end, &first)) return false;
+
+  /*  PKCS#8: version 0, the algorithm, the RSAPrivateKey in an OCTET STRING */
+  if (p < end && *p == 0x30) {
+    if (first.len != 1 || first.p[0] != 0) return false;
+    if (!der_rsa_alg(&p, end) || !der_take(&p, end, 0x04, &v)) return false;
+    return der_rsa_key(v.p, v.len, key) && key->d.len;
+  }
+
+  if (!der_uint(&p, end, &v)) return false;
+
+  /*  RSAPublicKey { n, e } */
+  if (p == end) {
+    key->n = first;
+    key->e = v;
+    return true;
+  }
+
+  /*  RSAPrivateKey, two-prime (version 0) only */
+  if (first.len != 1 || first.p[0] != 0) return false;
+  key->n = v;
+  return der_uint(&p, end, &key->e) && der_uint(&p, end, &key->d) &&
+         der_uint(&p, end, &key->p) && der_uint(&p, end, &key->q) &&
+         der_uint(&p, end, &key->dp) && der_uint(&p, end, &key->dq) &&
+         der_uint(&p, end, &key->qinv) && p == end;
+}
+
+bool rsa_pub_from_view(struct rsa_pub* pub, const struct rsa_key_view* key)
+{
+  uint32_t e = 0, i;
+
+  if (!key->n.len || key->n.len > BN_ARRAY_SIZE * WORD_SIZE / 2) return false;
+  if (!key->e.len || key->e.len > 4) return false;
+  for (i = 0; i < key->e.len; ++i) e = e << 8 | key->e.p[i];
+
+  return rsa_pub_init(pub, key->n.p, key->n.len, e);
+}
+
+
+#ifndef __H8_2329F__
+bool key_file_open(struct key_file* f, const char* path)
+{
+  f->base = NULL;
+  f->size = f->pos = 0;
+  f->mapped = false;
+
+#ifdef PEM_MMAP
+  struct stat st;
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return false;
+  if (fstat(fd, &st) == 0 && st.st_size > 0 && (uint64_t)st.st_size < UINT32_MAX) {
+    /*  private and writable: PEM is decoded over its own text, the file is
+        never touched */
+    void* p = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (p != MAP_FAILED) {
+      f->base = p;
+      f->size = (uint32_t)st.st_size;
+      f->mapped = true;
+    }
+  }
+  close(fd);
+#else
+  FILE* fp = fopen(path, "rb");
+  long size;
+  if (!fp) return false;
+  if (fseek(fp, 0, SEEK_END) == 0 && (size = ftell(fp)) > 0 && fseek(fp, 0, SEEK_SET) == 0) {
+    f->base = malloc((size_t)size);
+    if (f->base && fread(f->base, 1, (size_t)size, fp) == (size_t)size) {
+      f->size = (uint32_t)size;
+    } else {
+      free(f->base);
+      f->base = NULL;
+    }
+  }
+  fclose(fp);
+#endif
+  return f->base != NULL;
+}
+
+void key_file_close(struct key_file* f)
+{
+#ifdef PEM_MMAP
+  if (f->mapped) munmap(f->base, f->size);
+#else
+  free(f->base);
+#endif
+  f->base = NULL;
+  f->size = f->pos = 0;
+}
+
+/* First occurrence of the nlen-byte `needle` in [p, end), or NULL */
+static unsigned char* find(unsigned char* p, const unsigned char* end, const char* needle, uint32_t nlen)
+{
+  while ((uint32_t)(end - p) >= nlen) {
+    p = memchr(p, needle[0], (size_t)(end - p) - nlen + 1);
+    if (!p) return NULL;
+    if (!memcmp(p, needle, nlen)) return p;
+    ++p;
+  }
+  return NULL;
+}
+
+int key_file_next(struct key_file* f, struct rsa_key_view* key)
+{
+  static const char begin[] = "-----BEGIN ", dashes[] = "-----", endm[] = "-----END ";
+  const unsigned char* end = f->base + f->size;
+
+  /*  DER: one key, the whole file */
+  if (f->pos == 0 && f->size > 0 && f->base[0] == 0x30) {
+    f->pos = f->size;
+    return der_rsa_key(f->base, f->size, key) ? 1 : -1;
+  }
+
+  while (f->pos < f->size) {
+    unsigned char* label = find(f->base + f->pos, end, begin, sizeof begin - 1);
+    if (!label) break;
+    label += sizeof begin - 1;
+    unsigned char* label_end = find(label, end, dashes, sizeof dashes - 1);
+    if (!label_end) break;
+    unsigned char* body = label_end + sizeof dashes - 1;
+    unsigned char* body_end = find(body, end, endm, sizeof endm - 1);
+    if (!body_end) break;
+    unsigned char* next = find(body_end + sizeof endm - 1, end, dashes, sizeof dashes - 1);
+    f->pos = next ? (uint32_t)(next - f->base) + sizeof dashes - 1 : f->size;
+
+    const uint32_t llen = (uint32_t)(label_end - label);
+    if (!(llen == 15 && !memcmp(label, "RSA PRIVATE KEY", 15)) &&
+        !(llen == 14 && !memcmp(label, "RSA PUBLIC KEY", 14)) &&
+        !(llen == 10 && !memcmp(label, "PUBLIC KEY", 10)) &&
+        !(llen == 11 && !memcmp(label, "PRIVATE KEY", 11)))
+      continue;
+
+    const int32_t len = base64_decode((const char*)body, (uint32_t)(body_end - body), body);
+    return len > 0 && der_rsa_key(body, (uint32_t)len, key) ? 1 : -1;
+  }
+
+  f->pos = f->size;
+  return 0;
+}
+#endif
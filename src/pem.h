@@ -0,0 +1,41 @@
+#ifndef __PEM__
+#define __PEM__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "rsa.h"
+
+/* Decodes base64, skipping whitespace. out may be in itself: the output
+   never overtakes the input. Returns the decoded length, -1 on bad input. */
+int32_t base64_decode(const char* in, uint32_t len, unsigned char* out);
+
+/* Parses a PKCS#1 RSAPublicKey or RSAPrivateKey, or an SPKI (or PKCS#8)
+   wrapping one, into views of der. False on anything else. */
+bool der_rsa_key(const unsigned char* der, uint32_t len, struct rsa_key_view* key);
+
+/* Reads the public half of a key view into a key context: the modulus goes
+   from the view straight into limbs. False for e wider than 32 bits or
+   moduli over the bn size. */
+bool rsa_pub_from_view(struct rsa_pub* pub, const struct rsa_key_view* key);
+
+#ifndef __H8_2329F__
+/* A key file (DER, or PEM with any number of blocks) mapped copy-on-write.
+   PEM bodies are base64-decoded in place in the mapping, so the views of
+   key_file_next point into it and live until key_file_close. */
+struct key_file {
+  unsigned char* base;
+  uint32_t size;
+  uint32_t pos;
+  bool mapped;
+};
+
+bool key_file_open(struct key_file* f, const char* path);
+void key_file_close(struct key_file* f);
+
+/* The next RSA key of the file: 1, 0 at the end, -1 on a malformed one.
+   PEM blocks of other types are skipped. */
+int key_file_next(struct key_file* f, struct rsa_key_view* key);
+#endif
+
+#endif
@@ -0,0 +1,175 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "bn.h"
+#include "pkcs1_v15.h"
+#include "rsa.h"
+#include "util.h"
+
+#ifdef PKCS1_THREADS
+#include <pthread.h>
+#endif
+
+/*  DER of the DigestInfo ahead of the hash (Section 9.2, note 1), by hLen */
+static const struct {
+  uint32_t hlen;
+  uint32_t len;
+  unsigned char der[19];
+} digest_info[] = {
+  { 20, 15, { 0x30, 0x21, 0x30, 0x09, 0x06, 0x05, 0x2b, 0x0e, 0x03, 0x02, 0x1a, 0x05, 0x00, 0x04, 0x14 } },
+  { 32, 19, { 0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x01,
+              0x05, 0x00, 0x04, 0x20 } },
+  { 64, 19, { 0x30, 0x51, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x03,
+              0x05, 0x00, 0x04, 0x40 } },
+};
+
+/*  Byte j of a number in limbs, counted from the least significant */
+#define LIMB_BYTE(x, j) ((unsigned char)((x)[(j) / WORD_SIZE] >> (8 * ((j) % WORD_SIZE))))
+
+/*  The len big-endian bytes at p into s limbs */
+static void load_limbs(DTYPE* x, uint16_t s, const unsigned char* p, uint32_t len)
+{
+  uint32_t j;
+
+  memset(x, 0, s * WORD_SIZE);
+  for (j = 0; j < len; ++j) x[j / WORD_SIZE] |= (DTYPE)p[len - 1 - j] << (8 * (j % WORD_SIZE));
+}
+
+bool pkcs1_ctx_init(struct pkcs1_ctx* c, const struct hash* h, uint32_t k)
+{
+  const uint16_t s = (uint16_t)((k + WORD_SIZE - 1) / WORD_SIZE);
+  uint32_t i, t, j;
+  DTYPE* em;
+
+  for (i = 0; i < sizeof digest_info / sizeof *digest_info && digest_info[i].hlen != h->len; ++i);
+  if (i == sizeof digest_info / sizeof *digest_info) return false;
+
+  /*  STEP 3 of 9.2: at least 8 bytes of PS */
+  t = digest_info[i].len + h->len;
+  if (k < t + 11 || s > BN_ARRAY_SIZE / 2) return false;
+  if (!(em = arena_get(s * WORD_SIZE))) return false;
+
+  /*  STEP 5: 0x00 || 0x01 || PS || 0x00 || DigestInfo, its hash zero. Byte
+      j from the end is byte k - 1 - j of EM. */
+  memset(em, 0, s * WORD_SIZE);
+  for (j = h->len; j < t; ++j)
+    em[j / WORD_SIZE] |= (DTYPE)digest_info[i].der[t - 1 - j] << (8 * (j % WORD_SIZE));
+  for (j = t + 1; j < k - 2; ++j) em[j / WORD_SIZE] |= (DTYPE)0xff << (8 * (j % WORD_SIZE));
+  em[(k - 2) / WORD_SIZE] |= (DTYPE)0x01 << (8 * ((k - 2) % WORD_SIZE));
+
+  c->h = h;
+  c->k = k;
+  c->words = s;
+  c->em = em;
+  return true;
+}
+
+int rsa_verify_pkcs1_v15(const struct pkcs1_ctx* c, const struct rsa_pub* key,
+                         const unsigned char* digest, const unsigned char* sig, uint32_t siglen)
+{
+  DTYPE x[BN_ARRAY_SIZE / 2];
+  DTYPE e[(4 + WORD_SIZE - 1) / WORD_SIZE];
+  const uint32_t hLen = c->h->len;
+  const uint16_t s = c->words;
+  uint32_t i;
+
+  /*  STEP 1 of 8.2.2 */
+  if (siglen != c->k || key->nlen != c->k || key->mont.len != s) return -1;
+
+  /*  STEP 2a: s < n, from the top limb down */
+  load_limbs(x, s, sig, siglen);
+  for (i = s; i-- > 0 && x[i] == key->mont.n[i];);
+  if (i == (uint32_t)-1 || x[i] > key->mont.n[i]) return -1;
+
+  /*  STEP 2b: m = s^e mod n in place, e bit by bit (16 squarings and a
+      multiplication for 65537) unless the key carries a chain */
+  if (key->chain) {
+    struct bn a, m;
+    bignum_from_limbs(&a, x, s);
+    bignum_mont_exp_chain(&key->mont, &a, key->chain, key->chain_len, &m);
+    memcpy(x, m.array, s * WORD_SIZE);
+  } else {
+    for (i = 0; i < sizeof e / sizeof *e; ++i) e[i] = (DTYPE)(key->e >> (8 * WORD_SIZE * i));
+    bignum_mont_exp_limbs(&key->mont, x, e, sizeof e / sizeof *e, x);
+  }
+
+  /*  STEP 2c - 4: EM against EM', limbs above the hash against the
+      template, then the hash byte by byte */
+  for (i = s; i-- > 0 && i * WORD_SIZE >= hLen;)
+    if (x[i] != c->em[i]) return -1;
+  for (i = 0; i < hLen; ++i)
+    if (LIMB_BYTE(x, i) != digest[hLen - 1 - i]) return -1;
+  return 0;
+}
+
+/* One run of a batch */
+struct pkcs1_run {
+  const struct pkcs1_ctx* c;
+  const struct rsa_pub* key;
+  const unsigned char* const* digests;
+  const unsigned char* const* sigs;
+  int* results;
+  uint32_t first, count, valid;
+};
+
+static void* verify_run(void* arg)
+{
+  struct pkcs1_run* r = arg;
+  uint32_t i;
+
+  for (i = r->first; i < r->first + r->count; ++i) {
+    r->results[i] = rsa_verify_pkcs1_v15(r->c, r->key, r->digests[i], r->sigs[i], r->c->k);
+    r->valid += !r->results[i];
+  }
+  return NULL;
+}
+
+#ifndef PKCS1_MAX_THREADS
+  #define PKCS1_MAX_THREADS 64
+#endif
+
+uint32_t rsa_verify_pkcs1_v15_batch(const struct pkcs1_ctx* c, const struct rsa_pub* key, uint32_t n,
+                                    const unsigned char* const* digests, const unsigned char* const* sigs,
+                                    int* results, uint32_t threads)
+{
+  struct pkcs1_run runs[PKCS1_MAX_THREADS];
+  uint32_t i, first = 0, valid = 0;
+
+#ifdef PKCS1_THREADS
+  pthread_t tid[PKCS1_MAX_THREADS];
+  bool started[PKCS1_MAX_THREADS];
+  if (threads > PKCS1_MAX_THREADS) threads = PKCS1_MAX_THREADS;
+  if (threads > n) threads = n;
+#else
+  threads = 1;
+#endif
+  if (!threads) threads = 1;
+
+  /*  contiguous runs, the first n % threads one signature longer */
+  for (i = 0; i < threads; ++i) {
+    runs[i].c = c;
+    runs[i].key = key;
+    runs[i].digests = digests;
+    runs[i].sigs = sigs;
+    runs[i].results = results;
+    runs[i].first = first;
+    runs[i].count = n / threads + (i < n % threads);
+    runs[i].valid = 0;
+    first += runs[i].count;
+  }
+
+#ifdef PKCS1_THREADS
+  /*  the signatures only meet the key and template, both read-only; a run
+      whose thread does not start is done here */
+  for (i = 1; i < threads; ++i) started[i] = pthread_create(&tid[i], NULL, verify_run, &runs[i]) == 0;
+  verify_run(&runs[0]);
+  for (i = 1; i < threads; ++i)
+    if (started[i]) pthread_join(tid[i], NULL);
+    else verify_run(&runs[i]);
+#else
+  verify_run(&runs[0]);
+#endif
+
+  for (i = 0; i < threads; ++i) valid += runs[i].valid;
+  return valid;
+}
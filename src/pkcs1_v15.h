@@ -0,0 +1,50 @@
+#ifndef __PKCS1_V15__
+#define __PKCS1_V15__
+
+#include <stdint.h>
+
+#include "rsa.h"
+#include "hash.h"
+#include "util.h"
+
+/* Batches are spread over threads on hosts; the H8S verifies them in turn */
+#if !defined(__H8_2329F__) && !defined(PKCS1_NO_THREADS)
+  #define PKCS1_THREADS
+#endif
+
+/* The EM every valid RSASSA-PKCS1-v1_5 signature (RFC 3447 Section 8.2)
+   under a k-byte key and hash h decrypts to, 0x00 || 0x01 || PS || 0x00 ||
+   DigestInfo, as limbs with the digest left zero. Built once per hash and
+   key size. */
+struct pkcs1_ctx {
+  const struct hash* h;
+  uint32_t k;
+  uint16_t words;    /* limbs of k bytes*/
+  const DTYPE* em;
+};
+
+/* Arena taken by pkcs1_ctx_init */
+#define PKCS1_CTX_BYTES(bits, ws) RSA_LIMB_BYTES((bits) / 8, ws)
+
+/* Lays out the expected EM. The DigestInfo prefix is picked by hLen: SHA-1,
+   SHA-256 or SHA-512. False for another hash, a k too small for it, or when
+   the arena is full. */
+bool pkcs1_ctx_init(struct pkcs1_ctx* c, const struct hash* h, uint32_t k);
+
+/* Checks the siglen-byte signature of a message whose hash is `digest`.
+   s^e mod n is computed in limbs on the stack (no pool, no arena) and
+   compared limb by limb with the expected EM, nothing is decoded. Returns 0
+   when the signature is valid, else -1. */
+int rsa_verify_pkcs1_v15(const struct pkcs1_ctx* c, const struct rsa_pub* key,
+                         const unsigned char* digest, const unsigned char* sig, uint32_t siglen);
+
+/* Verifies n signatures of k bytes under one key: results[i] is what
+   rsa_verify_pkcs1_v15 returns for digests[i] and sigs[i]. Built with
+   PKCS1_THREADS the batch is split into `threads` runs, the caller's thread
+   taking one; otherwise, or if a thread cannot be started, they run in turn.
+   Returns the number of valid signatures. */
+uint32_t rsa_verify_pkcs1_v15_batch(const struct pkcs1_ctx* c, const struct rsa_pub* key, uint32_t n,
+                                    const unsigned char* const* digests, const unsigned char* const* sigs,
+                                    int* results, uint32_t threads);
+
+#endif
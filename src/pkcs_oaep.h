@@ -0,0 +1,109 @@
+#ifndef __PKCS_OAEP__
+#define __PKCS_OAEP__
+
+#include <stdint.h>
+
+#include "rsa.h"
+#include "hash.h"
+#include "sha1.h"
+#include "util.h"
+
+/* The H8S image is the demo itself; host builds ask for it */
+#if defined(__H8_2329F__) && !defined(PKCS_OAEP_MAIN)
+  #define PKCS_OAEP_MAIN
+#endif
+
+/* Hash the demo runs OAEP with */
+#ifndef OAEP_HASH
+  #define OAEP_HASH hash_sha1
+#endif
+
+/* Largest hLen the heap is sized for: SHA-1 alone on the H8S, any hash elsewhere */
+#ifndef OAEP_MAX_HLEN
+  #ifdef __H8_2329F__
+    #define OAEP_MAX_HLEN SHA1_HASH_LEN
+  #else
+    #define OAEP_MAX_HLEN HASH_MAX_LEN
+  #endif
+#endif
+
+/* Arena taken by the key contexts of the demo: the private key, whose public
+   half also encrypts, when it decrypts; else the public key, unless that is
+   baked into const data */
+#if defined(RSA_DECRYPT)
+  #define OAEP_KEY_BYTES(bits, ws) RSA_PRIV_BYTES(bits, ws)
+#elif defined(RSA_BAKED_KEY)
+  #define OAEP_KEY_BYTES(bits, ws) 0
+#else
+  #define OAEP_KEY_BYTES(bits, ws) RSA_PUB_BYTES(bits, ws)
+#endif
+
+/* Arena taken by oaep_ctx_init for its DB template (k - hLen - 1 bytes, any
+   hash) */
+#define OAEP_CTX_BYTES(bits) ARENA_ROUND((bits) / 8)
+
+/* Arena needed to OAEP-encode then encrypt (and decrypt and decode) with a
+   `bits`-bit key on WORD_SIZE `ws`: the bn pool, the key contexts and the DB
+   template. Encoding works in the caller's EM, with one hash block of MGF1
+   output on the stack. `make profile` prints it per key size. */
+#define OAEP_HEAP_BUDGET(bits, ws) \
+    (RSA_POOL_BYTES(bits, ws) + OAEP_KEY_BYTES(bits, ws) + OAEP_CTX_BYTES(bits))
+
+/* The profile build runs in twice the budget, so that an underestimate
+   shows up as a measured peak above it rather than as an exhausted arena */
+#ifndef HEAP_SIZE
+  #ifdef ARENA_PROFILE
+    #define HEAP_SIZE (2 * OAEP_HEAP_BUDGET(RSA_KEYSIZE * 8, WORD_SIZE))
+  #else
+    #define HEAP_SIZE OAEP_HEAP_BUDGET(RSA_KEYSIZE * 8, WORD_SIZE)
+  #endif
+#endif
+
+/* dst ^= MGF1(seed, len) (Appendix B.2.1), also used by PSS */
+void mgf1_xor(const struct hash* h, const unsigned char* seed, uint32_t slen,
+              unsigned char* dst, uint32_t len);
+
+/* Everything an encoding depends on but the message: the hash, the modulus
+   size k, lHash of the label and the DB template lHash || PS. */
+struct oaep_ctx {
+  const struct hash* h;
+  uint32_t k;
+  unsigned char lhash[HASH_MAX_LEN];
+  unsigned char* db;  /* k - hLen - 1 bytes, taken from the arena */
+};
+
+/* Hashes the label (NULL for none) and lays out the template in
+   OAEP_CTX_BYTES of the arena, which must be initialised and stays taken for
+   as long as the context is used. False when k is too small for the hash or
+   the arena is full. */
+bool oaep_ctx_init(struct oaep_ctx* o, const struct hash* h, uint32_t k,
+                   const unsigned char* label, uint32_t llen);
+
+/* Encodes into the caller's k-byte `em`: DB is laid out where maskedDB goes
+   and both masks are XORed in place, so nothing is allocated. The seed comes
+   from the calling thread's DRBG (drbg.h). Returns -1 if the message is too
+   long or the DRBG has no entropy, else 0. */
+int pkcs_oaep_encode(const struct oaep_ctx* o, const unsigned char* message, uint32_t mLen,
+                     unsigned char* em);
+
+/* Encodes n messages into n consecutive k-byte EMs at `ems`, hashing them
+   side by side. Returns -1, with nothing written, if any message is too long,
+   or -1 if the DRBG has no entropy. */
+int pkcs_oaep_encode_batch(const struct oaep_ctx* o, uint32_t n,
+                           const unsigned char* const* messages, const uint32_t* mLens,
+                           unsigned char* ems);
+
+/* RSAES-OAEP-ENCRYPT in one pass: EM is encoded straight into the limb
+   storage of a pooled bn, reordered in place and exponentiated there, and
+   the cipher is serialized once into the k bytes at `to`. Returns -1 if the
+   encoding fails or k is not the key's size. */
+int rsa_oaep_encrypt(const struct oaep_ctx* o, const struct rsa_pub* key,
+                     const unsigned char* message, uint32_t mLen, unsigned char* to);
+
+#ifdef RSA_DECRYPT
+/* Decodes a k-byte EM in place. On success *message points into em and the
+   message length is returned; any decoding error gives -1. */
+int32_t pkcs_oaep_decode(const struct oaep_ctx* o, unsigned char* em, unsigned char** message);
+#endif
+
+#endif
@@ -0,0 +1,174 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "bn.h"
+#include "drbg.h"
+#include "pkcs_oaep.h"
+#include "pkcs_pss.h"
+#include "rsa.h"
+#include "util.h"
+
+/*  The prefix of M' = (0x)00 00 00 00 00 00 00 00 || mHash || salt */
+static const unsigned char pss_zeros[8];
+
+/*  emBits = modBits - 1: the bits of the modulus, less one */
+static uint32_t pss_em_bits(const struct rsa_pub* key)
+{
+  const uint16_t s = key->mont.len;
+  DTYPE top = key->mont.n[s - 1];
+  uint32_t bits = (s - 1) * 8 * WORD_SIZE;
+
+  for (; top; top >>= 1) ++bits;
+  return bits - 1;
+}
+
+/*  H = Hash(M'), without laying M' out */
+static void pss_hash(const struct hash* h, const unsigned char* mhash,
+                     const unsigned char* salt, uint32_t slen, unsigned char* out)
+{
+  hash_ctx c;
+
+  h->init(&c);
+  h->update(&c, pss_zeros, sizeof pss_zeros);
+  h->update(&c, mhash, h->len);
+  h->update(&c, salt, slen);
+  h->final(&c, out);
+}
+
+void rsa_pss_init(struct pss_ctx* p, const struct hash* h)
+{
+  p->h = h;
+  h->init(&p->msg);
+}
+
+void rsa_pss_update(struct pss_ctx* p, const unsigned char* message, uint32_t len)
+{
+  p->h->update(&p->msg, message, len);
+}
+
+int rsa_pss_verify_final(struct pss_ctx* p, const struct rsa_pub* key, uint32_t slen,
+                         const unsigned char* sig, uint32_t siglen)
+{
+  const struct hash* h = p->h;
+  const uint32_t hLen = h->len;
+  const uint32_t k = key->nlen;
+  const uint32_t emBits = pss_em_bits(key);
+  const uint32_t emLen = (emBits + 7) / 8;
+  const uint32_t dbLen = emLen - hLen - 1;
+  const unsigned char mask = (unsigned char)(0xff >> (8 * emLen - emBits));
+  unsigned char mhash[HASH_MAX_LEN], hh[HASH_MAX_LEN];
+  unsigned char *em, *db;
+  struct bn* s;
+  uint32_t i;
+  int ret = -1;
+
+  /*  STEP 2 of 9.1.2 */
+  h->final(&p->msg, mhash);
+
+  /*  STEP 1 of 8.1.2, and 3 of 9.1.2 */
+  if (siglen != k || emLen < hLen + slen + 2) return -1;
+
+  /*  STEP 2 of 8.1.2: m = s^e mod n, written over s. EM is its last emLen
+      bytes; with emLen = k - 1 the first byte must be zero. */
+  s = bignum_tmp_get();
+  em = (unsigned char*)s->array;
+  bignum_from_bytes(s, sig, siglen);
+  if (rsa_encrypt_bn(key, s, em) != 0) goto out;
+  if (k > emLen && em[0]) goto out;
+  em += k - emLen;
+  db = em;
+
+  /*  STEP 4 - 6 of 9.1.2 */
+  if (em[emLen - 1] != 0xbc || (em[0] & ~mask)) goto out;
+
+  /*  STEP 7 - 9: DB unmasked in place */
+  mgf1_xor(h, em + dbLen, hLen, db, dbLen);
+  db[0] &= mask;
+
+  /*  STEP 10: PS is zeros, then 0x01 */
+  for (i = 0; i < dbLen - slen - 1; ++i)
+    if (db[i]) goto out;
+  if (db[dbLen - slen - 1] != 0x01) goto out;
+
+  /*  STEP 11 - 14 */
+  pss_hash(h, mhash, db + dbLen - slen, slen, hh);
+  if (!memcmp(hh, em + dbLen, hLen)) ret = 0;
+
+out:
+  bignum_tmp_put(s);
+  return ret;
+}
+
+int rsa_pss_verify(const struct hash* h, const struct rsa_pub* key, uint32_t slen,
+                   const unsigned char* message, uint32_t mLen, const unsigned char* sig, uint32_t siglen)
+{
+  struct pss_ctx p;
+
+  rsa_pss_init(&p, h);
+  rsa_pss_update(&p, message, mLen);
+  return rsa_pss_verify_final(&p, key, slen, sig, siglen);
+}
+
+#ifdef RSA_DECRYPT
+int rsa_pss_sign_final(struct pss_ctx* p, const struct rsa_priv* key, uint32_t slen, unsigned char* sig)
+{
+  const struct hash* h = p->h;
+  const uint32_t hLen = h->len;
+  const uint32_t k = key->pub.nlen;
+  const uint32_t emBits = pss_em_bits(&key->pub);
+  const uint32_t emLen = (emBits + 7) / 8;
+  const uint32_t dbLen = emLen - hLen - 1;
+  unsigned char mhash[HASH_MAX_LEN];
+  unsigned char *em, *db, *salt;
+  struct bn* m;
+  int ret = -1;
+
+  /*  STEP 2 of 9.1.1 */
+  h->final(&p->msg, mhash);
+
+  /*  STEP 3 */
+  if (emLen < hLen + slen + 2) return -1;
+
+  /*  EM is laid out at the end of k bytes, a zero byte ahead of it when
+      emLen = k - 1 */
+  m = bignum_tmp_get();
+  em = (unsigned char*)m->array;
+  memset(em, 0, k - emLen);
+  em += k - emLen;
+  db = em;
+  salt = db + dbLen - slen;
+
+  /*  STEP 4, 7, 8: DB = PS || 0x01 || salt, the salt drawn in place */
+  memset(db, 0, dbLen - slen - 1);
+  db[dbLen - slen - 1] = 0x01;
+  if (!drbg_bytes(salt, slen)) goto out;
+
+  /*  STEP 5, 6: H goes where it ends up in EM */
+  pss_hash(h, mhash, salt, slen, em + dbLen);
+
+  /*  STEP 9 - 12 */
+  mgf1_xor(h, em + dbLen, hLen, db, dbLen);
+  em[0] &= (unsigned char)(0xff >> (8 * emLen - emBits));
+  em[emLen - 1] = 0xbc;
+
+  /*  8.1.1 STEP 2: EM < 2^emBits < n, so this cannot fail on range; the
+      signature is checked against EM inside */
+  em = (unsigned char*)m->array;
+  if (rsa_decrypt_crt(key, em, k, sig) == 0) ret = 0;
+
+out:
+  if (ret) memset(sig, 0, k);
+  bignum_tmp_put(m);
+  return ret;
+}
+
+int rsa_pss_sign(const struct hash* h, const struct rsa_priv* key, uint32_t slen,
+                 const unsigned char* message, uint32_t mLen, unsigned char* sig)
+{
+  struct pss_ctx p;
+
+  rsa_pss_init(&p, h);
+  rsa_pss_update(&p, message, mLen);
+  return rsa_pss_sign_final(&p, key, slen, sig);
+}
+#endif
@@ -0,0 +1,45 @@
+#ifndef __PKCS_PSS__
+#define __PKCS_PSS__
+
+#include <stdint.h>
+
+#include "rsa.h"
+#include "hash.h"
+#include "util.h"
+
+/* A message being hashed for RSASSA-PSS (RFC 3447 Section 8.1). The message
+   is fed in pieces, so a large payload is never held whole; the hash also
+   serves as MGF1's. */
+struct pss_ctx {
+  const struct hash* h;
+  hash_ctx msg;
+};
+
+void rsa_pss_init(struct pss_ctx* p, const struct hash* h);
+void rsa_pss_update(struct pss_ctx* p, const unsigned char* message, uint32_t len);
+
+/* Ends the message and checks the key->nlen-byte signature `sig` made with a
+   salt of slen bytes. Returns 0 when it is valid, else -1. Only the public
+   exponent is used (bignum_mont_exp, or the addition chain of a baked key),
+   and the encoded message is checked in place in a pooled bn. */
+int rsa_pss_verify_final(struct pss_ctx* p, const struct rsa_pub* key, uint32_t slen,
+                         const unsigned char* sig, uint32_t siglen);
+
+/* rsa_pss_init, rsa_pss_update and rsa_pss_verify_final on a whole message */
+int rsa_pss_verify(const struct hash* h, const struct rsa_pub* key, uint32_t slen,
+                   const unsigned char* message, uint32_t mLen, const unsigned char* sig, uint32_t siglen);
+
+#ifdef RSA_DECRYPT
+/* Ends the message and writes its key->pub.nlen-byte signature to `sig`, with
+   a salt of slen bytes from the calling thread's DRBG. EM is encoded in a
+   pooled bn and signed through rsa_decrypt_crt, which checks it with the
+   public exponent. Returns -1 if the key is too small for the hash and salt,
+   the DRBG has no entropy or the check fails, else 0. */
+int rsa_pss_sign_final(struct pss_ctx* p, const struct rsa_priv* key, uint32_t slen, unsigned char* sig);
+
+/* rsa_pss_init, rsa_pss_update and rsa_pss_sign_final on a whole message */
+int rsa_pss_sign(const struct hash* h, const struct rsa_priv* key, uint32_t slen,
+                 const unsigned char* message, uint32_t mLen, unsigned char* sig);
+#endif
+
+#endif
@@ -1,14 +1,103 @@
-#ifndef __RSA__
-#define __RSA__
-
-#define RSA_KEYSIZE 256
-
-#include <stdint.h>
-
-unsigned char* rsa_encrypt(const unsigned char* from,
-                            uint32_t flen,
-                            const unsigned char* n,
-                            uint32_t nlen,
-                            uint32_t e);
-
-#endif
\ No newline at end of file
+#ifndef __RSA__
+#define __RSA__
+
+#define RSA_KEYSIZE 256
+
+/* The H8S build only encrypts; private-key code is left out unless asked for */
+#if !defined(__H8_2329F__) && !defined(RSA_DECRYPT)
+  #define RSA_DECRYPT
+#endif
+
+#include <stdint.h>
+
+#include "bn.h"
+#include "util.h"
+
+/* Pooled temporaries needed by an RSA operation on a `bits`-bit modulus with
+   WORD_SIZE `ws`: rsa_pss_sign_final holds 1 around rsa_decrypt_crt's 5,
+   pow_mod 1 around bignum_mod.*/
+#define RSA_POOL_COUNT(bits, ws) (6 + BN_MOD_TEMPS((bits) / 8 / (ws)))
+#define RSA_POOL_BYTES(bits, ws) (RSA_POOL_COUNT(bits, ws) * ARENA_ROUND(BN_STRUCT_BYTES(2 * (bits), ws)))
+#define RSA_POOL_SIZE RSA_POOL_COUNT(RSA_KEYSIZE * 8, WORD_SIZE)
+
+#ifndef RSA_BIG_E
+/* Bytes of a key field, big-endian: DER INTEGER contents or any buffer */
+struct der_view {
+  const unsigned char* p;
+  uint32_t len;
+};
+
+/* Fields of an RSA key as unsigned big-endian byte strings, leading zeros
+   stripped. The private ones are empty for a public key. */
+struct rsa_key_view {
+  struct der_view n, e;
+  struct der_view d, p, q, dp, dq, qinv;
+};
+
+/* Bytes of a limb array holding `bytes` bytes, as the arena hands it out */
+#define RSA_LIMB_BYTES(bytes, ws) ARENA_ROUND(((bytes) + (ws) - 1) / (ws) * (ws))
+
+/* A public key ready to use: the modulus and its Montgomery constants as
+   limb arrays, which may live in the arena, in ROM or in a mapped file.
+   A key baked at build time (`make baked`) also carries e as an addition
+   chain; without one, e is walked bit by bit. */
+struct rsa_pub {
+  struct bn_mont mont;
+  uint32_t nlen;
+  uint32_t e;
+  const unsigned char* chain;  /* NULL, or see bignum_mont_exp_chain */
+  uint16_t chain_len;
+};
+
+/* Arena taken by rsa_pub_init: n and R^2 mod n */
+#define RSA_PUB_BYTES(bits, ws) (2 * RSA_LIMB_BYTES((bits) / 8, ws))
+
+/* Reads the nlen-byte modulus n and precomputes what every encryption under
+   it shares. False for an even modulus, one over half of BN_MAX_BITS, or
+   when the arena is full. */
+bool rsa_pub_init(struct rsa_pub* key, const unsigned char* n, uint32_t nlen, uint32_t e);
+
+/* m^e mod n, serialized once into the nlen bytes at `to`. Returns -1 when m
+   is not smaller than n. */
+int rsa_encrypt_bn(const struct rsa_pub* key, struct bn* m, unsigned char* to);
+
+#ifdef RSA_DECRYPT
+/* A private key in CRT form: p and q with their Montgomery constants, the
+   half-size exponents and q^-1 mod p, kept in Montgomery form (times R). */
+struct rsa_priv {
+  struct rsa_pub pub;
+  struct bn_mont p, q;
+  const DTYPE* dp;
+  const DTYPE* dq;
+  const DTYPE* qinv_r;
+  uint16_t dplen, dqlen;
+};
+
+/* Arena taken by rsa_priv_init: the public half and seven half-size arrays */
+#define RSA_PRIV_BYTES(bits, ws) (RSA_PUB_BYTES(bits, ws) + 7 * RSA_LIMB_BYTES((bits) / 16, ws))
+
+/* Precomputes a private key from its PKCS#1 fields. False when a field is
+   missing, p and q differ in length (in words) or the arena is full; the
+   arena is then left as it was. */
+bool rsa_priv_init(struct rsa_priv* key, const struct rsa_key_view* v);
+
+/* to = from^d mod n through the CRT: two half-size exponentiations by
+   bignum_mont_exp_ct, on from blinded by r^e for a random r from the calling
+   thread's DRBG. The result is checked with the public exponent before it is
+   written, as a faulty CRT half would give the key away. Returns -1, `to`
+   untouched, when from is not smaller than n, the DRBG has no entropy or the
+   check fails. */
+int rsa_decrypt_crt(const struct rsa_priv* key, const unsigned char* from, uint32_t flen, unsigned char* to);
+#endif
+#endif
+
+/* Writes the nlen-byte cipher of from to `to`. Returns 0, or -1 when from
+   is not smaller than the modulus n.*/
+int rsa_encrypt(const unsigned char* from,
+                uint32_t flen,
+                const unsigned char* n,
+                uint32_t nlen,
+                uint32_t e,
+                unsigned char* to);
+
+#endif
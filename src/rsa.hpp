@@ -0,0 +1,274 @@
+#ifndef __RSA_HPP__
+#define __RSA_HPP__
+
+/* C++ layer over the C kernels. Header-only, and nothing here allocates
+   once a key is set up: numbers are std::arrays of limbs sized from the key
+   size at compile time, and products go straight to the Montgomery kernels
+   without passing through struct bn.
+
+     rsa::Workspace ws(bytes, pool);           // the arena, for the C calls
+     auto key = rsa::PublicKey<2048>::from_bytes(n, 256, 65537);
+     rsa::BigInt<2048> c;
+     key->encrypt(m, c);
+     rsa::BigInt<2048> r = a * b % key->modulus();  // one mulmod call      */
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+
+extern "C" {
+#include "bn.h"
+#include "rsa.h"
+#include "util.h"
+}
+
+namespace rsa {
+
+/* An unsigned number of up to Bits bits, least significant limb first */
+template <unsigned Bits>
+class BigInt {
+  static_assert(Bits % 8 == 0, "Bits must be whole bytes");
+  static_assert(2 * Bits <= BN_MAX_BITS, "Bits over half of BN_MAX_BITS");
+
+public:
+  static constexpr std::size_t bytes = Bits / 8;
+  static constexpr std::size_t limbs = (bytes + WORD_SIZE - 1) / WORD_SIZE;
+
+  BigInt() : w_{} {}
+
+  /* From big-endian bytes; false when they do not fit */
+  bool assign(const unsigned char* p, std::size_t len)
+  {
+    for (; len > bytes && *p == 0; ++p, --len);
+    if (len > bytes) return false;
+    w_.fill(0);
+    for (std::size_t i = 0; i < len; ++i)
+      w_[i / WORD_SIZE] |= (DTYPE)((DTYPE)p[len - 1 - i] << (8 * (i % WORD_SIZE)));
+    return true;
+  }
+
+  /* To len big-endian bytes, zero-padded on the left and truncated on it */
+  void to_bytes(unsigned char* out, std::size_t len) const
+  {
+    for (std::size_t i = 0; i < len; ++i)
+      out[len - 1 - i] = i < limbs * WORD_SIZE ? (unsigned char)(w_[i / WORD_SIZE] >> (8 * (i % WORD_SIZE))) : 0;
+  }
+
+  const DTYPE* data() const { return w_.data(); }
+  DTYPE* data() { return w_.data(); }
+
+  /* this < the first s limbs of n, this being no longer than s limbs */
+  bool below(const DTYPE* n, std::size_t s) const
+  {
+    for (std::size_t i = limbs; i-- > s;)
+      if (w_[i]) return false;
+    for (std::size_t i = s; i-- > 0;)
+      if (w_[i] != n[i]) return w_[i] < n[i];
+    return false;
+  }
+
+  friend bool operator==(const BigInt& a, const BigInt& b) { return a.w_ == b.w_; }
+  friend bool operator!=(const BigInt& a, const BigInt& b) { return a.w_ != b.w_; }
+
+private:
+  std::array<DTYPE, limbs> w_;
+};
+
+/* An odd modulus of up to Bits bits with its Montgomery constants. The
+   context points at the arrays inside the object, so copies and moves
+   point it again at their own. */
+template <unsigned Bits>
+class Modulus {
+public:
+  static std::optional<Modulus> from_bytes(const unsigned char* n, std::size_t len)
+  {
+    std::optional<Modulus> m(std::in_place);
+    for (; len > 1 && *n == 0; ++n, --len);
+    if (!len || !(n[len - 1] & 1) || !m->n_.assign(n, len)) return std::nullopt;
+    m->mont_.len = (uint16_t)((len + WORD_SIZE - 1) / WORD_SIZE);
+    m->bind();
+    bignum_mont_init(&m->mont_, m->n_.data(), m->mont_.len, m->rr_.data());
+    return m;
+  }
+
+  Modulus() : mont_{} {}
+  Modulus(const Modulus& o) : n_(o.n_), rr_(o.rr_), mont_(o.mont_) { bind(); }
+  Modulus& operator=(const Modulus& o)
+  {
+    n_ = o.n_;
+    rr_ = o.rr_;
+    mont_ = o.mont_;
+    bind();
+    return *this;
+  }
+
+  const bn_mont& context() const { return mont_; }
+  const BigInt<Bits>& n() const { return n_; }
+
+  /* a * b mod n, for a, b < n: into Montgomery form and out in two products */
+  void mulmod(const BigInt<Bits>& a, const BigInt<Bits>& b, BigInt<Bits>& c) const
+  {
+    bignum_mont_mul_limbs(&mont_, a.data(), b.data(), c.data());
+    bignum_mont_mul_limbs(&mont_, c.data(), rr_.data(), c.data());
+  }
+
+  /* a^e mod n, for a < n; e as limbs */
+  void powmod(const BigInt<Bits>& a, const DTYPE* e, uint16_t elen, BigInt<Bits>& c) const
+  {
+    bignum_mont_exp_limbs(&mont_, a.data(), e, elen, c.data());
+  }
+
+private:
+  void bind()
+  {
+    mont_.n = n_.data();
+    mont_.rr = rr_.data();
+  }
+
+  BigInt<Bits> n_, rr_;
+  bn_mont mont_;
+};
+
+/* a * b, held until it meets a modulus */
+template <unsigned Bits>
+struct Product {
+  const BigInt<Bits>& a;
+  const BigInt<Bits>& b;
+};
+
+template <unsigned Bits>
+Product<Bits> operator*(const BigInt<Bits>& a, const BigInt<Bits>& b)
+{
+  return { a, b };
+}
+
+template <unsigned Bits>
+BigInt<Bits> operator%(const Product<Bits>& p, const Modulus<Bits>& n)
+{
+  BigInt<Bits> c;
+  n.mulmod(p.a, p.b, c);
+  return c;
+}
+
+/* A public key; c_key() hands it to the C API (rsa_oaep_encrypt ...) */
+template <unsigned Bits>
+class PublicKey {
+public:
+  static std::optional<PublicKey> from_bytes(const unsigned char* n, std::size_t len, uint32_t e)
+  {
+    std::optional<Modulus<Bits>> m = Modulus<Bits>::from_bytes(n, len);
+    if (!m || !e) return std::nullopt;
+    for (; len > 1 && *n == 0; ++n, --len);
+    return PublicKey(*m, (uint32_t)len, e);
+  }
+
+  static std::optional<PublicKey> from_view(const rsa_key_view& v)
+  {
+    uint32_t e = 0;
+    if (!v.e.len || v.e.len > 4) return std::nullopt;
+    for (uint32_t i = 0; i < v.e.len; ++i) e = e << 8 | v.e.p[i];
+    return from_bytes(v.n.p, v.n.len, e);
+  }
+
+  PublicKey(const PublicKey& o) : mod_(o.mod_), pub_(o.pub_) { bind(); }
+  PublicKey& operator=(const PublicKey& o)
+  {
+    mod_ = o.mod_;
+    pub_ = o.pub_;
+    bind();
+    return *this;
+  }
+
+  const Modulus<Bits>& modulus() const { return mod_; }
+  const rsa_pub* c_key() const { return &pub_; }
+  std::size_t size() const { return pub_.nlen; }
+
+  /* c = m^e mod n; false when m is not below n */
+  bool encrypt(const BigInt<Bits>& m, BigInt<Bits>& c) const
+  {
+    DTYPE e[(4 + WORD_SIZE - 1) / WORD_SIZE];
+    if (!m.below(mod_.n().data(), pub_.mont.len)) return false;
+    for (std::size_t i = 0; i < sizeof e / sizeof *e; ++i) e[i] = (DTYPE)(pub_.e >> (8 * WORD_SIZE * i));
+    mod_.powmod(m, e, sizeof e / sizeof *e, c);
+    return true;
+  }
+
+  /* The same on size() big-endian bytes */
+  bool encrypt(const unsigned char* m, std::size_t len, unsigned char* to) const
+  {
+    BigInt<Bits> x, c;
+    if (!x.assign(m, len) || !encrypt(x, c)) return false;
+    c.to_bytes(to, pub_.nlen);
+    return true;
+  }
+
+private:
+  PublicKey(const Modulus<Bits>& m, uint32_t nlen, uint32_t e) : mod_(m), pub_{}
+  {
+    pub_.nlen = nlen;
+    pub_.e = e;
+    bind();
+  }
+
+  void bind() { pub_.mont = mod_.context(); }
+
+  Modulus<Bits> mod_;
+  rsa_pub pub_;
+};
+
+/* The arena and bn pool the C API works in: taken on construction, given
+   back on destruction. There is one arena per process (per thread with
+   ARENA_PER_THREAD), so a Workspace can be moved but not copied, and one
+   made while an arena is live owns nothing and tests false. */
+class Workspace {
+public:
+  Workspace(uint32_t bytes, uint16_t pool) : owner_(!arena_live() && arena_init(nullptr, bytes))
+  {
+    if (owner_) bignum_pool_init(pool);
+  }
+  ~Workspace()
+  {
+    if (owner_) arena_release();
+  }
+  Workspace(Workspace&& o) noexcept : owner_(o.owner_) { o.owner_ = false; }
+  Workspace& operator=(Workspace&& o) noexcept
+  {
+    if (this != &o) {
+      if (owner_) arena_release();
+      owner_ = o.owner_;
+      o.owner_ = false;
+    }
+    return *this;
+  }
+  Workspace(const Workspace&) = delete;
+  Workspace& operator=(const Workspace&) = delete;
+
+  explicit operator bool() const { return owner_; }
+
+private:
+  bool owner_;
+};
+
+/* Arena allocations made in its scope are rolled back when it ends */
+class Scratch {
+public:
+  Scratch() : mark_(arena_mark()), live_(true) {}
+  ~Scratch()
+  {
+    if (live_) arena_rollback(mark_);
+  }
+  Scratch(Scratch&& o) noexcept : mark_(o.mark_), live_(o.live_) { o.live_ = false; }
+  Scratch& operator=(Scratch&&) = delete;
+  Scratch(const Scratch&) = delete;
+  Scratch& operator=(const Scratch&) = delete;
+
+private:
+  uint32_t mark_;
+  bool live_;
+};
+
+} // namespace rsa
+
+#endif
@@ -1,249 +1,584 @@
-#include <stdio.h>
-#include <stdint.h>
-#include <stdlib.h>
-// #include <string.h>
-
-#include "sha1.h"
-#include "util.h"
-
-
-static uint8_t *p;
-static uint32_t *H;
-
-void sha1_start()
-{
-  p = heap_get(128);
-  H = heap_get(sizeof *H * 5);
-}
-
-void sha1_terminate()
-{
-  heap_free(128);
-  heap_free(sizeof *H * 5);
-}
-
-
-static void sha1_init()
-{ 
-  H[0] = 0x67452301;
-  H[1] = 0xEFCDAB89;
-  H[2] = 0x98BADCFE;
-  H[3] = 0x10325476;
-  H[4] = 0xC3D2E1F0;
-
-}
-
-uint32_t rotl( uint32_t x, int shift )
-{
-  return (x << shift) | (x >> (sizeof(x)*8 - shift));
-}
-
-uint32_t roundFunc( uint32_t b, uint32_t c, uint32_t d, int roundNum )
-{
-  if( roundNum <= 19 )
-  {
-    return (b & c) | ((~b) & d);
-  }
-  else if( roundNum <= 39 )
-  {
-    return ( b ^ c ^ d );
-  }
-  else if( roundNum <= 59 )
-  {
-    return (b & c) | (b & d) | (c & d);
-  }
-  else
-  {
-    return ( b ^ c ^ d );
-  }
-}
-
-uint32_t kForRound( int roundNum )
-{
-  if( roundNum <= 19 )
-  {
-    return 0x5a827999;
-  }
-  else if( roundNum <= 39 )
-  {
-    return 0x6ed9eba1;
-  }
-  else if( roundNum <= 59 )
-  {
-    return 0x8f1bbcdc;
-  }
-  else
-  {
-    return 0xca62c1d6;
-  }
-}
-
-int pad(uint8_t * block, uint8_t * extraBlock, int blockSize, int fileSize)
-{
-  int twoBlocks = 0;
-  /* l is block size in bits */
-  uint32_t l = (uint32_t)fileSize * 8;
-  if(blockSize <= 55)
-  {
-    block[blockSize] = 0x80;
-    int i;
-    for( i = 0; i < 8; i++ )
-    {
-      block[56+i] = (l >> (56-(8*i)));
-    }
-  }
-  else
-  {
-    twoBlocks = 1;
-    if(blockSize < 63)
-      block[blockSize] = 0x80;
-    else
-      extraBlock[0] = 0x80;
-
-    int i;
-    for( i = 0; i < 8; i++ )
-    {
-      extraBlock[56+i] = (l >> (56-(8*i)));
-    }
-  }
-  return twoBlocks;
-}
-
-void doSha1(uint8_t * block)
-{
-  static uint32_t w[80] = {0x00000000};
-  int i;
-  for( i = 0; i < 16; i++ )
-  {
-    int offset = (i*4);
-      w[i] =  (int32_t) (block[offset]) << 24 |
-              (int32_t) (block[offset + 1]) << 16 |
-              (int32_t) (block[offset + 2]) << 8  |
-              block[offset + 3];
-  }
-
-  for( i = 16; i < 80; i++ )
-  {
-    uint32_t tmp = (w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16]);
-    w[i] = rotl( tmp, 1 );
-  }
-
-  uint32_t a = H[0];
-  uint32_t b = H[1];
-  uint32_t c = H[2];
-  uint32_t d = H[3];
-  uint32_t e = H[4];
-
-  for( i = 0; i < 80; i++ )
-  {
-    uint32_t tmp = rotl(a, 5) + roundFunc(b,c,d,i) + e + w[i] + kForRound(i);
-    e = d;
-    d = c;
-    c = rotl(b, 30);
-    b = a;
-    a = tmp;
-  }
-
-  H[0] = H[0] + a;
-  H[1] = H[1] + b;
-  H[2] = H[2] + c;
-  H[3] = H[3] + d;
-  H[4] = H[4] + e;
-}
-
-
-int sha1(const unsigned char* input, uint32_t len, unsigned char* output)
-{
-  uint8_t *block = p, *extra_block = p+64;
-
-  sha1_init();
-
-  uint32_t i = 0;
-  while (i+64 < len) {
-    memcpy(block, input+i, 64);
-    doSha1(block);
-    i += 64;
-  }
-  uint32_t done = 0;
-  if (i < len) {
-    memcpy(block, input+i, len-i);
-    done = len-i;
-  }
-  for (uint8_t j = done; j < 64; ++j)
-    block[j] = extra_block[j] = 0x00;
-  int twoBlocks = pad(block, extra_block, done, len);
-  doSha1(block);
-  if(twoBlocks == 1)
-    doSha1(extra_block);
-  
-#ifdef BIG_ENDIAN
-  memcpy(output, H, 20);
-#else
-  for (i = 0; i < 5; ++i)
-    i2osp(output+4*i, H+i, 4);
-#endif
-
-  return 0;
-}
-
-int sha1_uint8_t(const uint8_t* input, uint32_t len, uint8_t* output)
-{
-  return sha1((const unsigned char*)input, len, (unsigned char*)output);
-}
-
-uint8_t* sha1_with_malloc(const unsigned char* input, uint32_t len)
-{
-  uint8_t* output = heap_get(SHA1_HASH_LEN);
-  if (sha1(input, len, output) != 0) return NULL;
-  return output;
-}
-uint8_t* sha1_uint8_t_with_malloc(const uint8_t* input, uint32_t len)
-{
-  uint8_t* output = heap_get(SHA1_HASH_LEN);
-  if (sha1_uint8_t(input, len, output) != 0) return NULL;
-  return output;
-}
-
-
-#ifdef SHA1_MAIN
-int main()
-{
-  sha1_start();
-
-  unsigned char input[] = "I wonder if it will work";
-  unsigned char input2[] = "";
-  unsigned char input3[] = "Hello word";
-  unsigned char input4[] = "qqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqq";
-  unsigned char output[20];
-  unsigned char expected_output_hex[40];
-  unsigned char expected_output[20];
-
-  sha1(input, sizeof input - 1, output);
-  printf("sha1(%s) = ", input); print_hex(output, 20);
-  memcpy(expected_output_hex, "c0220bd1a3d3c0fb52f1134654504187f0686f33", 40);
-  unhexlify(expected_output_hex, 40, expected_output);
-  require (memcmp(output, expected_output, 20) == 0, "invalid hash");
-
-  sha1(input2, sizeof input2 - 1, output);
-  printf("sha1() = "); print_hex(output, 20);
-  memcpy(expected_output_hex, "da39a3ee5e6b4b0d3255bfef95601890afd80709", 40);
-  unhexlify(expected_output_hex, 40, expected_output);
-  require (memcmp(output, expected_output, 20) == 0, "invalid hash");
-
-  sha1(input3, sizeof input3 - 1, output);
-  printf("sha1(%s) = ", input3); print_hex(output, 20);
-  memcpy(expected_output_hex, "739921b9bee642f0c9466d88e6a9de77be52d91f", 40);
-  unhexlify(expected_output_hex, 40, expected_output);
-  require (memcmp(output, expected_output, 20) == 0, "invalid hash");
-
-  sha1(input4, sizeof input4 - 1, output);
-  printf("sha1(%s) = ", input4); print_hex(output, 20);
-  memcpy(expected_output_hex, "f8036ad391e0b6057d39ab1a881f4ab3e7a65c51", 40);
-  unhexlify(expected_output_hex, 40, expected_output);
-  require (memcmp(output, expected_output, 20) == 0, "invalid hash");
-
-  sha1_terminate();
-
-  printf("OK\n");
-}
-#endif
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+// #include <string.h>
+
+#include "bn.h"
+#include "sha1.h"
+#include "util.h"
+
+#if SHA1_LANES > 1
+#include <immintrin.h>
+#endif
+
+
+#define ROL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+#define F1(b, c, d) ((d) ^ ((b) & ((c) ^ (d))))
+#define F2(b, c, d) ((b) ^ (c) ^ (d))
+#define F3(b, c, d) (((b) & (c)) | ((d) & ((b) | (c))))
+#define K1 0x5a827999
+#define K2 0x6ed9eba1
+#define K3 0x8f1bbcdc
+#define K4 0xca62c1d6
+
+#define LOAD32(p) ((uint32_t)(p)[0] << 24 | (uint32_t)(p)[1] << 16 | \
+                   (uint32_t)(p)[2] << 8 | (uint32_t)(p)[3])
+
+/* The schedule only ever looks 16 words back, so it rolls over w[16] */
+#define W(i) (w[(i) & 15] = ROL(w[((i) - 3) & 15] ^ w[((i) - 8) & 15] ^ \
+                                w[((i) - 14) & 15] ^ w[(i) & 15], 1))
+#define WL(i) (w[(i)])
+
+/* One round, with the working variables renamed instead of shifted */
+#define R(a, b, c, d, e, f, k, wi) do { \
+    e += ROL(a, 5) + f(b, c, d) + k + (wi); \
+    b = ROL(b, 30); \
+  } while (0)
+
+#define R5(i, f, k, W) do { \
+    R(a, b, c, d, e, f, k, W(i)); \
+    R(e, a, b, c, d, f, k, W((i) + 1)); \
+    R(d, e, a, b, c, f, k, W((i) + 2)); \
+    R(c, d, e, a, b, f, k, W((i) + 3)); \
+    R(b, c, d, e, a, f, k, W((i) + 4)); \
+  } while (0)
+
+static void sha1_blocks_portable(uint32_t* H, const uint8_t* data, uint32_t n)
+{
+  uint32_t w[16];
+  uint32_t a, b, c, d, e, i;
+
+  BN_COUNT(blocks_sha1, n);
+  for (; n > 0; --n, data += SHA1_BLOCK_LEN) {
+    for (i = 0; i < 16; ++i) w[i] = LOAD32(data + 4 * i);
+
+    a = H[0]; b = H[1]; c = H[2]; d = H[3]; e = H[4];
+
+    for (i = 0; i < 15; i += 5) R5(i, F1, K1, WL);
+    R(a, b, c, d, e, F1, K1, w[15]);
+    R(e, a, b, c, d, F1, K1, W(16));
+    R(d, e, a, b, c, F1, K1, W(17));
+    R(c, d, e, a, b, F1, K1, W(18));
+    R(b, c, d, e, a, F1, K1, W(19));
+    for (i = 20; i < 40; i += 5) R5(i, F2, K2, W);
+    for (; i < 60; i += 5) R5(i, F3, K3, W);
+    for (; i < 80; i += 5) R5(i, F2, K4, W);
+
+    H[0] += a; H[1] += b; H[2] += c; H[3] += d; H[4] += e;
+  }
+}
+
+
+/*  x86 SHA extensions, picked at run time when the CPU has them */
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && !defined(SHA1_NO_SHANI)
+#define SHA1_SHANI
+#include <cpuid.h>
+#include <immintrin.h>
+
+/*  Four rounds: `M` is the message word group, `F` the round function */
+#define NI4(Ea, Eb, M, F) \
+    Ea = _mm_sha1nexte_epu32(Ea, M); Eb = abcd; abcd = _mm_sha1rnds4_epu32(abcd, Ea, F)
+
+/*  ... with the schedule for the groups 1, 2 and 3 ahead interleaved */
+#define NI4_MSG(Ea, Eb, M0, M1, M2, M3, F) \
+    NI4(Ea, Eb, M0, F); \
+    M1 = _mm_sha1msg2_epu32(M1, M0); \
+    M3 = _mm_sha1msg1_epu32(M3, M0); \
+    M2 = _mm_xor_si128(M2, M0)
+
+__attribute__((target("sha,sse4.1")))
+static void sha1_blocks_shani(uint32_t* H, const uint8_t* data, uint32_t n)
+{
+  const __m128i bswap = _mm_set_epi64x(0x0001020304050607LL, 0x08090a0b0c0d0e0fLL);
+  __m128i abcd, e0, e1, abcd_save, e_save, m0, m1, m2, m3;
+
+  abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)H), 0x1b);
+  e0 = _mm_set_epi32((int)H[4], 0, 0, 0);
+
+  BN_COUNT(blocks_sha1, n);
+  for (; n > 0; --n, data += SHA1_BLOCK_LEN) {
+    abcd_save = abcd;
+    e_save = e0;
+
+    m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data), bswap);
+    e0 = _mm_add_epi32(e0, m0);
+    e1 = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+
+    m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 16)), bswap);
+    NI4(e1, e0, m1, 0);
+    m0 = _mm_sha1msg1_epu32(m0, m1);
+
+    m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 32)), bswap);
+    NI4(e0, e1, m2, 0);
+    m1 = _mm_sha1msg1_epu32(m1, m2);
+    m0 = _mm_xor_si128(m0, m2);
+
+    m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 48)), bswap);
+    NI4_MSG(e1, e0, m3, m0, m1, m2, 0);
+
+    NI4_MSG(e0, e1, m0, m1, m2, m3, 0);
+    NI4_MSG(e1, e0, m1, m2, m3, m0, 1);
+    NI4_MSG(e0, e1, m2, m3, m0, m1, 1);
+    NI4_MSG(e1, e0, m3, m0, m1, m2, 1);
+    NI4_MSG(e0, e1, m0, m1, m2, m3, 1);
+    NI4_MSG(e1, e0, m1, m2, m3, m0, 1);
+    NI4_MSG(e0, e1, m2, m3, m0, m1, 2);
+    NI4_MSG(e1, e0, m3, m0, m1, m2, 2);
+    NI4_MSG(e0, e1, m0, m1, m2, m3, 2);
+    NI4_MSG(e1, e0, m1, m2, m3, m0, 2);
+    NI4_MSG(e0, e1, m2, m3, m0, m1, 2);
+    NI4_MSG(e1, e0, m3, m0, m1, m2, 3);
+    NI4_MSG(e0, e1, m0, m1, m2, m3, 3);
+
+    NI4(e1, e0, m1, 3);
+    m2 = _mm_sha1msg2_epu32(m2, m1);
+    m3 = _mm_xor_si128(m3, m1);
+    NI4(e0, e1, m2, 3);
+    m3 = _mm_sha1msg2_epu32(m3, m2);
+    NI4(e1, e0, m3, 3);
+
+    e0 = _mm_sha1nexte_epu32(e0, e_save);
+    abcd = _mm_add_epi32(abcd, abcd_save);
+  }
+
+  _mm_storeu_si128((__m128i*)H, _mm_shuffle_epi32(abcd, 0x1b));
+  H[4] = (uint32_t)_mm_extract_epi32(e0, 3);
+}
+
+static int sha1_cpu_has_shani(void)
+{
+  unsigned int a, b, c, d;
+  if (!__get_cpuid(1, &a, &b, &c, &d) || !(c & bit_SSE4_1)) return 0;
+  if (!__get_cpuid_count(7, 0, &a, &b, &c, &d)) return 0;
+  return (b >> 29) & 1;
+}
+
+static void sha1_blocks_resolve(uint32_t* H, const uint8_t* data, uint32_t n);
+
+/*  Starts out on the resolver, which replaces itself on first use */
+static void (*sha1_blocks)(uint32_t* H, const uint8_t* data, uint32_t n) = sha1_blocks_resolve;
+
+int sha1_backend_shani(void)
+{
+  if (sha1_blocks == sha1_blocks_resolve)
+    sha1_blocks = sha1_cpu_has_shani() ? sha1_blocks_shani : sha1_blocks_portable;
+  return sha1_blocks == sha1_blocks_shani;
+}
+
+static void sha1_blocks_resolve(uint32_t* H, const uint8_t* data, uint32_t n)
+{
+  sha1_backend_shani();
+  sha1_blocks(H, data, n);
+}
+#else
+#define sha1_blocks sha1_blocks_portable
+
+int sha1_backend_shani(void)
+{
+  return 0;
+}
+#endif
+
+void doSha1(uint32_t * H, const uint8_t * block)
+{
+  sha1_blocks(H, block, 1);
+}
+
+
+void sha1_init(struct sha1_ctx* ctx)
+{
+  ctx->h[0] = 0x67452301;
+  ctx->h[1] = 0xEFCDAB89;
+  ctx->h[2] = 0x98BADCFE;
+  ctx->h[3] = 0x10325476;
+  ctx->h[4] = 0xC3D2E1F0;
+  ctx->len = 0;
+}
+
+void sha1_update(struct sha1_ctx* ctx, const unsigned char* input, uint32_t len)
+{
+  uint32_t used = ctx->len % SHA1_BLOCK_LEN;
+  ctx->len += len;
+
+  if (used) {
+    uint32_t fill = SHA1_BLOCK_LEN - used;
+    if (len < fill) {
+      memcpy(ctx->buf + used, input, len);
+      return;
+    }
+    memcpy(ctx->buf + used, input, fill);
+    doSha1(ctx->h, ctx->buf);
+    input += fill;
+    len -= fill;
+  }
+
+  /*  whole blocks are compressed straight from the input */
+  sha1_blocks(ctx->h, input, len / SHA1_BLOCK_LEN);
+  input += len - len % SHA1_BLOCK_LEN;
+  len %= SHA1_BLOCK_LEN;
+
+  memcpy(ctx->buf, input, len);
+}
+
+/*  Lays the padded tail of the message out in `tail` (two blocks of room)
+    and returns how many blocks it spans */
+static uint32_t sha1_pad(const struct sha1_ctx* ctx, uint8_t* tail)
+{
+  uint32_t used = ctx->len % SHA1_BLOCK_LEN, i;
+  uint32_t blocks = used + 1 > SHA1_BLOCK_LEN - 8 ? 2 : 1;
+
+  memcpy(tail, ctx->buf, used);
+  tail[used] = 0x80;
+  memset(tail + used + 1, 0, blocks * SHA1_BLOCK_LEN - 8 - used - 1);
+
+  /*  64-bit big-endian bit count: the byte count shifted, mod 2^64 */
+  for (i = 0; i < 8; ++i)
+    tail[blocks * SHA1_BLOCK_LEN - 1 - i] = (uint8_t) ((ctx->len << 3) >> (8 * i));
+  return blocks;
+}
+
+static void sha1_store(const uint32_t* h, unsigned char* output)
+{
+  uint32_t i;
+  for (i = 0; i < 5; ++i) {
+    output[4 * i] = (uint8_t) (h[i] >> 24);
+    output[4 * i + 1] = (uint8_t) (h[i] >> 16);
+    output[4 * i + 2] = (uint8_t) (h[i] >> 8);
+    output[4 * i + 3] = (uint8_t) h[i];
+  }
+}
+
+void sha1_final(struct sha1_ctx* ctx, unsigned char* output)
+{
+  uint8_t tail[2 * SHA1_BLOCK_LEN];
+  uint32_t blocks = sha1_pad(ctx, tail);
+
+  sha1_blocks(ctx->h, tail, blocks);
+  sha1_store(ctx->h, output);
+}
+
+
+/*  Multi-buffer compression: SHA1_LANES independent blocks go through one
+    pass of vector code, one message per lane. */
+#if SHA1_LANES > 1
+#if SHA1_LANES == 16
+typedef __m512i vec;
+#define VLOAD(p) _mm512_loadu_si512((const void*)(p))
+#define VSTORE(p, v) _mm512_storeu_si512((void*)(p), v)
+#define VSET1(x) _mm512_set1_epi32((int)(x))
+#define VADD(a, b) _mm512_add_epi32(a, b)
+#define VXOR(a, b) _mm512_xor_si512(a, b)
+#define VAND(a, b) _mm512_and_si512(a, b)
+#define VOR(a, b) _mm512_or_si512(a, b)
+#define VROL(a, n) _mm512_rol_epi32(a, n)
+#elif SHA1_LANES == 8
+typedef __m256i vec;
+#define VLOAD(p) _mm256_loadu_si256((const __m256i*)(p))
+#define VSTORE(p, v) _mm256_storeu_si256((__m256i*)(p), v)
+#define VSET1(x) _mm256_set1_epi32((int)(x))
+#define VADD(a, b) _mm256_add_epi32(a, b)
+#define VXOR(a, b) _mm256_xor_si256(a, b)
+#define VAND(a, b) _mm256_and_si256(a, b)
+#define VOR(a, b) _mm256_or_si256(a, b)
+#define VROL(a, n) _mm256_or_si256(_mm256_slli_epi32(a, n), _mm256_srli_epi32(a, 32 - (n)))
+#else
+typedef __m128i vec;
+#define VLOAD(p) _mm_loadu_si128((const __m128i*)(p))
+#define VSTORE(p, v) _mm_storeu_si128((__m128i*)(p), v)
+#define VSET1(x) _mm_set1_epi32((int)(x))
+#define VADD(a, b) _mm_add_epi32(a, b)
+#define VXOR(a, b) _mm_xor_si128(a, b)
+#define VAND(a, b) _mm_and_si128(a, b)
+#define VOR(a, b) _mm_or_si128(a, b)
+#define VROL(a, n) _mm_or_si128(_mm_slli_epi32(a, n), _mm_srli_epi32(a, 32 - (n)))
+#endif
+
+#define VF1(b, c, d) VXOR(d, VAND(b, VXOR(c, d)))
+#define VF2(b, c, d) VXOR(VXOR(b, c), d)
+#define VF3(b, c, d) VOR(VAND(b, c), VAND(d, VOR(b, c)))
+
+/*  One round over all lanes; the schedule rolls over w[16] */
+#define VROUND(i, f, k) do { \
+    vec wi = (i) < 16 ? w[(i)] : (w[(i) & 15] = VROL(VXOR(VXOR(w[((i) - 3) & 15], w[((i) - 8) & 15]), \
+                                                         VXOR(w[((i) - 14) & 15], w[(i) & 15])), 1)); \
+    vec t = VADD(VADD(VROL(a, 5), f(b, c, d)), VADD(VADD(e, VSET1(k)), wi)); \
+    e = d; d = c; c = VROL(b, 30); b = a; a = t; \
+  } while (0)
+
+static void sha1_compress_lanes(uint32_t* const* h, const uint8_t* const* block)
+{
+  uint32_t x[SHA1_LANES];
+  vec s[5], w[16], a, b, c, d, e;
+  uint32_t i, l;
+
+  for (i = 0; i < 5; ++i) {
+    for (l = 0; l < SHA1_LANES; ++l) x[l] = h[l][i];
+    s[i] = VLOAD(x);
+  }
+  for (i = 0; i < 16; ++i) {
+    for (l = 0; l < SHA1_LANES; ++l) {
+      x[l] = LOAD32(block[l] + 4 * i);
+    }
+    w[i] = VLOAD(x);
+  }
+
+  a = s[0]; b = s[1]; c = s[2]; d = s[3]; e = s[4];
+  for (i = 0; i < 20; ++i) VROUND(i, VF1, 0x5a827999);
+  for (; i < 40; ++i) VROUND(i, VF2, 0x6ed9eba1);
+  for (; i < 60; ++i) VROUND(i, VF3, 0x8f1bbcdc);
+  for (; i < 80; ++i) VROUND(i, VF2, 0xca62c1d6);
+  s[0] = VADD(s[0], a); s[1] = VADD(s[1], b); s[2] = VADD(s[2], c);
+  s[3] = VADD(s[3], d); s[4] = VADD(s[4], e);
+
+  for (i = 0; i < 5; ++i) {
+    VSTORE(x, s[i]);
+    for (l = 0; l < SHA1_LANES; ++l) h[l][i] = x[l];
+  }
+}
+#endif
+
+void sha1_compress_jobs(struct sha1_job* jobs, uint32_t n)
+{
+#if SHA1_LANES > 1
+  /*  one SHA-NI stream already keeps up with 16 vector lanes */
+  if (sha1_backend_shani()) goto serial;
+
+  struct sha1_job* lane[SHA1_LANES];
+  uint32_t* h[SHA1_LANES];
+  const uint8_t* block[SHA1_LANES];
+  uint32_t idle_h[5] = { 0 };
+  static const uint8_t idle_block[SHA1_BLOCK_LEN];
+  uint32_t next = 0, active = 0, l;
+
+  for (l = 0; l < SHA1_LANES; ++l) {
+    while (next < n && jobs[next].blocks == 0) ++next;
+    lane[l] = next < n ? &jobs[next++] : NULL;
+    active += lane[l] != NULL;
+  }
+
+  /*  A lane whose job runs out is refilled from the queue straight away;
+      once a single job is left it finishes on the scalar path. */
+  while (active > 1) {
+    for (l = 0; l < SHA1_LANES; ++l) {
+      h[l] = lane[l] ? lane[l]->h : idle_h;
+      block[l] = lane[l] ? lane[l]->data : idle_block;
+    }
+    BN_COUNT(blocks_sha1, active);
+    sha1_compress_lanes(h, block);
+
+    for (l = 0; l < SHA1_LANES; ++l) {
+      if (!lane[l]) continue;
+      lane[l]->data += SHA1_BLOCK_LEN;
+      if (--lane[l]->blocks) continue;
+      while (next < n && jobs[next].blocks == 0) ++next;
+      lane[l] = next < n ? &jobs[next++] : NULL;
+      active -= lane[l] == NULL;
+    }
+  }
+
+  for (l = 0; l < SHA1_LANES; ++l)
+    if (lane[l]) {
+      jobs = lane[l];
+      n = 1;
+    }
+  if (!active) return;
+serial:
+#endif
+
+  for (; n > 0; ++jobs, --n) {
+    sha1_blocks(jobs->h, jobs->data, jobs->blocks);
+    jobs->data += jobs->blocks * SHA1_BLOCK_LEN;
+    jobs->blocks = 0;
+  }
+}
+
+void sha1_update_n(struct sha1_ctx* const* ctx, const unsigned char* const* input,
+                   const uint32_t* len, uint32_t n)
+{
+  struct sha1_job jobs[SHA1_BATCH];
+  uint32_t i, j, m;
+
+  for (i = 0; i < n; i += m) {
+    m = n - i < SHA1_BATCH ? n - i : SHA1_BATCH;
+
+    /*  first top up the partial blocks already buffered */
+    for (j = 0; j < m; ++j) {
+      struct sha1_ctx* c = ctx[i + j];
+      uint32_t used = c->len % SHA1_BLOCK_LEN, fill = SHA1_BLOCK_LEN - used;
+      jobs[j].h = c->h;
+      jobs[j].data = c->buf;
+      jobs[j].blocks = used && len[i + j] >= fill;
+      if (jobs[j].blocks) memcpy(c->buf + used, input[i + j], fill);
+    }
+    sha1_compress_jobs(jobs, m);
+
+    /*  then every whole block straight from the inputs */
+    for (j = 0; j < m; ++j) {
+      struct sha1_ctx* c = ctx[i + j];
+      uint32_t used = c->len % SHA1_BLOCK_LEN;
+      uint32_t skip = used ? SHA1_BLOCK_LEN - used : 0;
+      if (skip > len[i + j]) skip = len[i + j];
+      jobs[j].h = c->h;
+      jobs[j].data = input[i + j] + skip;
+      jobs[j].blocks = (len[i + j] - skip) / SHA1_BLOCK_LEN;
+    }
+    sha1_compress_jobs(jobs, m);
+
+    /*  and buffer what is left */
+    for (j = 0; j < m; ++j) {
+      struct sha1_ctx* c = ctx[i + j];
+      uint32_t used = c->len % SHA1_BLOCK_LEN, rest;
+      uint32_t skip = used ? SHA1_BLOCK_LEN - used : 0;
+      if (skip >= len[i + j]) {
+        memcpy(c->buf + used, input[i + j], len[i + j]);
+      } else {
+        rest = (len[i + j] - skip) % SHA1_BLOCK_LEN;
+        memcpy(c->buf, input[i + j] + len[i + j] - rest, rest);
+      }
+      c->len += len[i + j];
+    }
+  }
+}
+
+void sha1_final_n(struct sha1_ctx* const* ctx, unsigned char* const* output, uint32_t n)
+{
+  struct sha1_job jobs[SHA1_BATCH];
+  uint8_t tail[SHA1_BATCH][2 * SHA1_BLOCK_LEN];
+  uint32_t i, j, m;
+
+  for (i = 0; i < n; i += m) {
+    m = n - i < SHA1_BATCH ? n - i : SHA1_BATCH;
+    for (j = 0; j < m; ++j) {
+      jobs[j].h = ctx[i + j]->h;
+      jobs[j].data = tail[j];
+      jobs[j].blocks = sha1_pad(ctx[i + j], tail[j]);
+    }
+    sha1_compress_jobs(jobs, m);
+    for (j = 0; j < m; ++j) sha1_store(ctx[i + j]->h, output[i + j]);
+  }
+}
+
+int sha1(const unsigned char* input, uint32_t len, unsigned char* output)
+{
+  struct sha1_ctx ctx;
+
+  sha1_init(&ctx);
+  sha1_update(&ctx, input, len);
+  sha1_final(&ctx, output);
+  return 0;
+}
+
+int sha1_uint8_t(const uint8_t* input, uint32_t len, uint8_t* output)
+{
+  return sha1((const unsigned char*)input, len, (unsigned char*)output);
+}
+
+uint8_t* sha1_with_malloc(const unsigned char* input, uint32_t len)
+{
+  uint8_t* output = arena_get(SHA1_HASH_LEN);
+  if (sha1(input, len, output) != 0) return NULL;
+  return output;
+}
+uint8_t* sha1_uint8_t_with_malloc(const uint8_t* input, uint32_t len)
+{
+  uint8_t* output = arena_get(SHA1_HASH_LEN);
+  if (sha1_uint8_t(input, len, output) != 0) return NULL;
+  return output;
+}
+
+static void ctx_init(void* ctx) { sha1_init(ctx); }
+static void ctx_update(void* ctx, const unsigned char* input, uint32_t len) { sha1_update(ctx, input, len); }
+static void ctx_final(void* ctx, unsigned char* output) { sha1_final(ctx, output); }
+static void ctx_update_n(void* const* ctx, const unsigned char* const* input, const uint32_t* len, uint32_t n)
+{
+  sha1_update_n((struct sha1_ctx* const*)ctx, input, len, n);
+}
+static void ctx_final_n(void* const* ctx, unsigned char* const* output, uint32_t n)
+{
+  sha1_final_n((struct sha1_ctx* const*)ctx, output, n);
+}
+
+const struct hash hash_sha1 = {
+  SHA1_HASH_LEN, sizeof(struct sha1_ctx), sha1, ctx_init, ctx_update, ctx_final,
+  ctx_update_n, ctx_final_n
+};
+
+/* hash_ctx has to be able to hold it */
+typedef char sha1_ctx_fits[sizeof(struct sha1_ctx) <= sizeof(hash_ctx) ? 1 : -1];
+
+
+#ifdef SHA1_MAIN
+int main()
+{
+  unsigned char input[] = "I wonder if it will work";
+  unsigned char input2[] = "";
+  unsigned char input3[] = "Hello word";
+  unsigned char input4[] = "qqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqq";
+  unsigned char output[20];
+  unsigned char expected_output_hex[40];
+  unsigned char expected_output[20];
+
+  sha1(input, sizeof input - 1, output);
+  printf("sha1(%s) = ", input); print_hex(output, 20);
+  memcpy(expected_output_hex, "c0220bd1a3d3c0fb52f1134654504187f0686f33", 40);
+  unhexlify(expected_output_hex, 40, expected_output);
+  require (memcmp(output, expected_output, 20) == 0, "invalid hash");
+
+  sha1(input2, sizeof input2 - 1, output);
+  printf("sha1() = "); print_hex(output, 20);
+  memcpy(expected_output_hex, "da39a3ee5e6b4b0d3255bfef95601890afd80709", 40);
+  unhexlify(expected_output_hex, 40, expected_output);
+  require (memcmp(output, expected_output, 20) == 0, "invalid hash");
+
+  sha1(input3, sizeof input3 - 1, output);
+  printf("sha1(%s) = ", input3); print_hex(output, 20);
+  memcpy(expected_output_hex, "739921b9bee642f0c9466d88e6a9de77be52d91f", 40);
+  unhexlify(expected_output_hex, 40, expected_output);
+  require (memcmp(output, expected_output, 20) == 0, "invalid hash");
+
+  sha1(input4, sizeof input4 - 1, output);
+  printf("sha1(%s) = ", input4); print_hex(output, 20);
+  memcpy(expected_output_hex, "f8036ad391e0b6057d39ab1a881f4ab3e7a65c51", 40);
+  unhexlify(expected_output_hex, 40, expected_output);
+  require (memcmp(output, expected_output, 20) == 0, "invalid hash");
+
+  /*  the multi-buffer path against sha1(), messages of mixed lengths fed
+      in two pieces; the lane kernel only runs without SHA-NI (build with
+      -DSHA1_NO_SHANI on hosts that have it) */
+  {
+    static unsigned char msg[SHA1_BATCH + 3][300], out[SHA1_BATCH + 3][20];
+    struct sha1_ctx ctx[SHA1_BATCH + 3];
+    struct sha1_ctx* cp[SHA1_BATCH + 3];
+    const unsigned char* in[SHA1_BATCH + 3];
+    unsigned char* op[SHA1_BATCH + 3];
+    uint32_t len[SHA1_BATCH + 3], half[SHA1_BATCH + 3], i, j, n;
+
+    printf("lanes %d, %s\n", SHA1_LANES, sha1_backend_shani() ? "SHA-NI (lanes not used)" : "portable");
+    for (n = 1; n <= SHA1_BATCH + 3; n += 3) {
+      for (i = 0; i < n; ++i) {
+        len[i] = (i * 67 + n * 13) % sizeof msg[i];
+        half[i] = len[i] / 3;
+        for (j = 0; j < len[i]; ++j) msg[i][j] = (unsigned char)(i * 31 + j * 7 + n);
+        cp[i] = &ctx[i];
+        op[i] = out[i];
+        sha1_init(cp[i]);
+        in[i] = msg[i];
+      }
+      sha1_update_n(cp, in, half, n);
+      for (i = 0; i < n; ++i) {
+        in[i] = msg[i] + half[i];
+        half[i] = len[i] - half[i];
+      }
+      sha1_update_n(cp, in, half, n);
+      sha1_final_n(cp, op, n);
+      for (i = 0; i < n; ++i) {
+        sha1(msg[i], len[i], output);
+        require (memcmp(output, out[i], 20) == 0, "sha1_update_n/sha1_final_n differ from sha1");
+      }
+    }
+  }
+
+  printf("OK\n");
+}
+#endif
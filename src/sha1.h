@@ -1,16 +1,67 @@
-#include <stdint.h>
-#define SHA1_HASH_LEN 20
-
-#define htonl(n) (((((uint32_t)(n) & 0xFF)) << 24) | \
-                  ((((uint32_t)(n) & 0xFF00)) << 8) | \
-                  ((((uint32_t)(n) & 0xFF0000)) >> 8) | \
-                  ((((uint32_t)(n) & 0xFF000000)) >> 24))
-
-                  
-int sha1(const unsigned char* input, uint32_t len, unsigned char* output);
-int sha1_uint8_t(const uint8_t* input, uint32_t len, uint8_t* output);
-uint8_t* sha1_with_malloc(const unsigned char* input, uint32_t len);
-uint8_t* sha1_uint8_t_with_malloc(const uint8_t* input, uint32_t len);
-
-void sha1_start();
-void sha1_terminate();
+#ifndef __SHA1__
+#define __SHA1__
+
+#include <stdint.h>
+
+#include "hash.h"
+
+#define SHA1_HASH_LEN 20
+#define SHA1_BLOCK_LEN 64
+
+/* Running state; plain data, so a midstate can be copied with memcpy */
+struct sha1_ctx {
+  uint32_t h[5];
+  uint64_t len;  /* bytes absorbed so far */
+  uint8_t buf[SHA1_BLOCK_LEN];
+};
+
+/* Blocks the multi-buffer kernel compresses side by side */
+#ifndef SHA1_LANES
+  #if defined(__AVX512F__)
+    #define SHA1_LANES 16
+  #elif defined(__AVX2__)
+    #define SHA1_LANES 8
+  #elif defined(__SSE2__)
+    #define SHA1_LANES 4
+  #else
+    #define SHA1_LANES 1
+  #endif
+#endif
+
+/* Messages sha1_update_n/sha1_final_n stage at once */
+#define SHA1_BATCH (4 * SHA1_LANES)
+
+/* `blocks` consecutive blocks at `data` to run through state `h`. The
+   scheduler advances data and blocks as it goes. */
+struct sha1_job {
+  uint32_t* h;
+  const uint8_t* data;
+  uint32_t blocks;
+};
+
+#define htonl(n) (((((uint32_t)(n) & 0xFF)) << 24) | \
+                  ((((uint32_t)(n) & 0xFF00)) << 8) | \
+                  ((((uint32_t)(n) & 0xFF0000)) >> 8) | \
+                  ((((uint32_t)(n) & 0xFF000000)) >> 24))
+
+                  
+void sha1_init(struct sha1_ctx* ctx);
+void sha1_update(struct sha1_ctx* ctx, const unsigned char* input, uint32_t len);
+void sha1_final(struct sha1_ctx* ctx, unsigned char* output);
+
+/* The same over n independent contexts, sharing vector lanes between them */
+void sha1_update_n(struct sha1_ctx* const* ctx, const unsigned char* const* input,
+                   const uint32_t* len, uint32_t n);
+void sha1_final_n(struct sha1_ctx* const* ctx, unsigned char* const* output, uint32_t n);
+void sha1_compress_jobs(struct sha1_job* jobs, uint32_t n);
+
+/* Whether compression runs on the x86 SHA extensions (build with
+   -DSHA1_NO_SHANI to force the portable code) */
+int sha1_backend_shani(void);
+
+int sha1(const unsigned char* input, uint32_t len, unsigned char* output);
+int sha1_uint8_t(const uint8_t* input, uint32_t len, uint8_t* output);
+uint8_t* sha1_with_malloc(const unsigned char* input, uint32_t len);
+uint8_t* sha1_uint8_t_with_malloc(const uint8_t* input, uint32_t len);
+
+#endif
@@ -0,0 +1,200 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "bn.h"
+#include "sha256.h"
+#include "util.h"
+
+
+static const uint32_t K[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+  0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+  0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+  0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+  0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+  0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+  0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+  0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+  0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define CH(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+#define MAJ(x, y, z) (((x) & (y)) | ((z) & ((x) | (y))))
+#define S0(x) (ROTR(x, 2) ^ ROTR(x, 13) ^ ROTR(x, 22))
+#define S1(x) (ROTR(x, 6) ^ ROTR(x, 11) ^ ROTR(x, 25))
+#define s0(x) (ROTR(x, 7) ^ ROTR(x, 18) ^ ((x) >> 3))
+#define s1(x) (ROTR(x, 17) ^ ROTR(x, 19) ^ ((x) >> 10))
+
+#define LOAD32(p) ((uint32_t)(p)[0] << 24 | (uint32_t)(p)[1] << 16 | \
+                   (uint32_t)(p)[2] << 8 | (uint32_t)(p)[3])
+
+/* The schedule only ever looks 16 words back, so it rolls over w[16] */
+#define W(i) (w[(i) & 15] += s1(w[((i) - 2) & 15]) + w[((i) - 7) & 15] + s0(w[((i) - 15) & 15]))
+
+/* One round, with the working variables renamed instead of shifted */
+#define ROUND(a, b, c, d, e, f, g, h, i, wi) do { \
+    uint32_t t1 = h + S1(e) + CH(e, f, g) + K[i] + (wi); \
+    d += t1; \
+    h = t1 + S0(a) + MAJ(a, b, c); \
+  } while (0)
+
+#define ROUNDS8(i, W) do { \
+    ROUND(a, b, c, d, e, f, g, h, (i), W(i)); \
+    ROUND(h, a, b, c, d, e, f, g, (i) + 1, W((i) + 1)); \
+    ROUND(g, h, a, b, c, d, e, f, (i) + 2, W((i) + 2)); \
+    ROUND(f, g, h, a, b, c, d, e, (i) + 3, W((i) + 3)); \
+    ROUND(e, f, g, h, a, b, c, d, (i) + 4, W((i) + 4)); \
+    ROUND(d, e, f, g, h, a, b, c, (i) + 5, W((i) + 5)); \
+    ROUND(c, d, e, f, g, h, a, b, (i) + 6, W((i) + 6)); \
+    ROUND(b, c, d, e, f, g, h, a, (i) + 7, W((i) + 7)); \
+  } while (0)
+
+#define W0(i) (w[(i)])
+
+static void sha256_compress(uint32_t* state, const unsigned char* block)
+{
+  uint32_t w[16];
+  uint32_t a = state[0], b = state[1], c = state[2], d = state[3],
+           e = state[4], f = state[5], g = state[6], h = state[7];
+  uint32_t i;
+
+  BN_COUNT(blocks_sha256, 1);
+  for (i = 0; i < 16; ++i) w[i] = LOAD32(block + 4 * i);
+
+  ROUNDS8(0, W0);
+  ROUNDS8(8, W0);
+  for (i = 16; i < 64; i += 8) ROUNDS8(i, W);
+
+  state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+  state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+
+void sha256_init(struct sha256_ctx* ctx)
+{
+  static const uint32_t iv[8] = {
+  0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+  0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+  memcpy(ctx->h, iv, sizeof iv);
+  ctx->len = 0;
+}
+
+void sha256_update(struct sha256_ctx* ctx, const unsigned char* input, uint32_t len)
+{
+  uint32_t used = ctx->len % SHA256_BLOCK_LEN;
+  ctx->len += len;
+
+  if (used) {
+    uint32_t fill = SHA256_BLOCK_LEN - used;
+    if (len < fill) {
+      memcpy(ctx->buf + used, input, len);
+      return;
+    }
+    memcpy(ctx->buf + used, input, fill);
+    sha256_compress(ctx->h, ctx->buf);
+    input += fill;
+    len -= fill;
+  }
+
+  /*  whole blocks are compressed straight from the input */
+  for (; len >= SHA256_BLOCK_LEN; input += SHA256_BLOCK_LEN, len -= SHA256_BLOCK_LEN)
+    sha256_compress(ctx->h, input);
+
+  memcpy(ctx->buf, input, len);
+}
+
+void sha256_final(struct sha256_ctx* ctx, unsigned char* output)
+{
+  uint32_t used = ctx->len % SHA256_BLOCK_LEN;
+  uint32_t i;
+
+  ctx->buf[used++] = 0x80;
+  if (used > SHA256_BLOCK_LEN - 8) {
+    memset(ctx->buf + used, 0, SHA256_BLOCK_LEN - used);
+    sha256_compress(ctx->h, ctx->buf);
+    used = 0;
+  }
+  memset(ctx->buf + used, 0, SHA256_BLOCK_LEN - 8 - used);
+
+  /*  64-bit big-endian bit count: the byte count shifted, mod 2^64 */
+  for (i = 0; i < 8; ++i)
+    ctx->buf[SHA256_BLOCK_LEN - 1 - i] = (uint8_t) ((ctx->len << 3) >> (8 * i));
+  sha256_compress(ctx->h, ctx->buf);
+
+  for (i = 0; i < 8; ++i) {
+    output[4 * i] = (uint8_t) (ctx->h[i] >> 24);
+    output[4 * i + 1] = (uint8_t) (ctx->h[i] >> 16);
+    output[4 * i + 2] = (uint8_t) (ctx->h[i] >> 8);
+    output[4 * i + 3] = (uint8_t) ctx->h[i];
+  }
+}
+
+int sha256(const unsigned char* input, uint32_t len, unsigned char* output)
+{
+  struct sha256_ctx ctx;
+
+  sha256_init(&ctx);
+  sha256_update(&ctx, input, len);
+  sha256_final(&ctx, output);
+  return 0;
+}
+
+static void ctx_init(void* ctx) { sha256_init(ctx); }
+static void ctx_update(void* ctx, const unsigned char* input, uint32_t len) { sha256_update(ctx, input, len); }
+static void ctx_final(void* ctx, unsigned char* output) { sha256_final(ctx, output); }
+
+const struct hash hash_sha256 = {
+  SHA256_HASH_LEN, sizeof(struct sha256_ctx), sha256, ctx_init, ctx_update, ctx_final, NULL, NULL
+};
+
+/* hash_ctx has to be able to hold it */
+typedef char sha256_ctx_fits[sizeof(struct sha256_ctx) <= sizeof(hash_ctx) ? 1 : -1];
+
+
+#ifdef SHA256_MAIN
+int main()
+{
+  static const char* vectors[][2] = {
+    { "I wonder if it will work", "46f5c8c58f37c0030e97dc3365bc094623686ceaddc08605256fbfff0f5fb6f7" },
+    { "", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+    { "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+      "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+    { "qqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqq",
+      "89d8851a7047583541ef470c852c9672060938d1886693fecd970edce390f47f" },
+  };
+  unsigned char output[SHA256_HASH_LEN];
+  unsigned char expected_output[SHA256_HASH_LEN];
+  uint32_t i, split;
+
+  for (i = 0; i < sizeof vectors / sizeof *vectors; ++i) {
+    const unsigned char* input = (const unsigned char*)vectors[i][0];
+    uint32_t len = strlen(vectors[i][0]);
+
+    sha256(input, len, output);
+    printf("sha256(%s) = ", input); print_hex(output, SHA256_HASH_LEN);
+    unhexlify((unsigned char*)vectors[i][1], 2 * SHA256_HASH_LEN, expected_output);
+    require (memcmp(output, expected_output, SHA256_HASH_LEN) == 0, "invalid hash");
+
+    /*  the same through every two-part split of the input */
+    for (split = 0; split <= len; ++split) {
+      struct sha256_ctx ctx;
+      sha256_init(&ctx);
+      sha256_update(&ctx, input, split);
+      sha256_update(&ctx, input + split, len - split);
+      sha256_final(&ctx, output);
+      require (memcmp(output, expected_output, SHA256_HASH_LEN) == 0, "invalid incremental hash");
+    }
+  }
+
+  printf("OK\n");
+  return 0;
+}
+#endif
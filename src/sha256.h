@@ -0,0 +1,24 @@
+#ifndef __SHA256__
+#define __SHA256__
+
+#include <stdint.h>
+
+#include "hash.h"
+
+#define SHA256_HASH_LEN 32
+#define SHA256_BLOCK_LEN 64
+
+/* Running state; plain data, so a midstate can be copied with memcpy */
+struct sha256_ctx {
+  uint32_t h[8];
+  uint64_t len;  /* bytes absorbed so far */
+  uint8_t buf[SHA256_BLOCK_LEN];
+};
+
+void sha256_init(struct sha256_ctx* ctx);
+void sha256_update(struct sha256_ctx* ctx, const unsigned char* input, uint32_t len);
+void sha256_final(struct sha256_ctx* ctx, unsigned char* output);
+
+int sha256(const unsigned char* input, uint32_t len, unsigned char* output);
+
+#endif
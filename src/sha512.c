@@ -0,0 +1,227 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "bn.h"
+#include "sha512.h"
+#include "util.h"
+
+
+static const uint64_t K[80] = {
+  0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL,
+  0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+  0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL,
+  0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+  0xd807aa98a3030242ULL, 0x12835b0145706fbeULL,
+  0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+  0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL,
+  0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+  0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL,
+  0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+  0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL,
+  0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+  0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL,
+  0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+  0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL,
+  0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+  0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL,
+  0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+  0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL,
+  0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+  0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL,
+  0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+  0xd192e819d6ef5218ULL, 0xd69906245565a910ULL,
+  0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+  0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL,
+  0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+  0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL,
+  0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+  0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL,
+  0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+  0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL,
+  0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+  0xca273eceea26619cULL, 0xd186b8c721c0c207ULL,
+  0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+  0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL,
+  0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+  0x28db77f523047d84ULL, 0x32caab7b40c72493ULL,
+  0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+  0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL,
+  0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL};
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+#define CH(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+#define MAJ(x, y, z) (((x) & (y)) | ((z) & ((x) | (y))))
+#define S0(x) (ROTR(x, 28) ^ ROTR(x, 34) ^ ROTR(x, 39))
+#define S1(x) (ROTR(x, 14) ^ ROTR(x, 18) ^ ROTR(x, 41))
+#define s0(x) (ROTR(x, 1) ^ ROTR(x, 8) ^ ((x) >> 7))
+#define s1(x) (ROTR(x, 19) ^ ROTR(x, 61) ^ ((x) >> 6))
+
+#define LOAD64(p) ((uint64_t)(p)[0] << 56 | (uint64_t)(p)[1] << 48 | \
+                   (uint64_t)(p)[2] << 40 | (uint64_t)(p)[3] << 32 | \
+                   (uint64_t)(p)[4] << 24 | (uint64_t)(p)[5] << 16 | \
+                   (uint64_t)(p)[6] << 8 | (uint64_t)(p)[7])
+
+/* The schedule only ever looks 16 words back, so it rolls over w[16] */
+#define W(i) (w[(i) & 15] += s1(w[((i) - 2) & 15]) + w[((i) - 7) & 15] + s0(w[((i) - 15) & 15]))
+
+/* One round, with the working variables renamed instead of shifted */
+#define ROUND(a, b, c, d, e, f, g, h, i, wi) do { \
+    uint64_t t1 = h + S1(e) + CH(e, f, g) + K[i] + (wi); \
+    d += t1; \
+    h = t1 + S0(a) + MAJ(a, b, c); \
+  } while (0)
+
+#define ROUNDS8(i, W) do { \
+    ROUND(a, b, c, d, e, f, g, h, (i), W(i)); \
+    ROUND(h, a, b, c, d, e, f, g, (i) + 1, W((i) + 1)); \
+    ROUND(g, h, a, b, c, d, e, f, (i) + 2, W((i) + 2)); \
+    ROUND(f, g, h, a, b, c, d, e, (i) + 3, W((i) + 3)); \
+    ROUND(e, f, g, h, a, b, c, d, (i) + 4, W((i) + 4)); \
+    ROUND(d, e, f, g, h, a, b, c, (i) + 5, W((i) + 5)); \
+    ROUND(c, d, e, f, g, h, a, b, (i) + 6, W((i) + 6)); \
+    ROUND(b, c, d, e, f, g, h, a, (i) + 7, W((i) + 7)); \
+  } while (0)
+
+#define W0(i) (w[(i)])
+
+static void sha512_compress(uint64_t* state, const unsigned char* block)
+{
+  uint64_t w[16];
+  uint64_t a = state[0], b = state[1], c = state[2], d = state[3],
+           e = state[4], f = state[5], g = state[6], h = state[7];
+  uint32_t i;
+
+  BN_COUNT(blocks_sha512, 1);
+  for (i = 0; i < 16; ++i) w[i] = LOAD64(block + 8 * i);
+
+  ROUNDS8(0, W0);
+  ROUNDS8(8, W0);
+  for (i = 16; i < 80; i += 8) ROUNDS8(i, W);
+
+  state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+  state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+
+void sha512_init(struct sha512_ctx* ctx)
+{
+  static const uint64_t iv[8] = {
+  0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL,
+  0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+  0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+  0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL};
+  memcpy(ctx->h, iv, sizeof iv);
+  ctx->len = 0;
+}
+
+void sha512_update(struct sha512_ctx* ctx, const unsigned char* input, uint32_t len)
+{
+  uint32_t used = ctx->len % SHA512_BLOCK_LEN;
+  ctx->len += len;
+
+  if (used) {
+    uint32_t fill = SHA512_BLOCK_LEN - used;
+    if (len < fill) {
+      memcpy(ctx->buf + used, input, len);
+      return;
+    }
+    memcpy(ctx->buf + used, input, fill);
+    sha512_compress(ctx->h, ctx->buf);
+    input += fill;
+    len -= fill;
+  }
+
+  /*  whole blocks are compressed straight from the input */
+  for (; len >= SHA512_BLOCK_LEN; input += SHA512_BLOCK_LEN, len -= SHA512_BLOCK_LEN)
+    sha512_compress(ctx->h, input);
+
+  memcpy(ctx->buf, input, len);
+}
+
+void sha512_final(struct sha512_ctx* ctx, unsigned char* output)
+{
+  uint32_t used = ctx->len % SHA512_BLOCK_LEN;
+  uint32_t i;
+
+  ctx->buf[used++] = 0x80;
+  if (used > SHA512_BLOCK_LEN - 16) {
+    memset(ctx->buf + used, 0, SHA512_BLOCK_LEN - used);
+    sha512_compress(ctx->h, ctx->buf);
+    used = 0;
+  }
+  memset(ctx->buf + used, 0, SHA512_BLOCK_LEN - 8 - used);
+
+  /*  128-bit big-endian bit count, whose top 64 bits stay zero here */
+  for (i = 0; i < 8; ++i)
+    ctx->buf[SHA512_BLOCK_LEN - 1 - i] = (uint8_t) ((ctx->len << 3) >> (8 * i));
+  ctx->buf[SHA512_BLOCK_LEN - 9] |= (uint8_t) (ctx->len >> 61);
+  sha512_compress(ctx->h, ctx->buf);
+
+  for (i = 0; i < 64; ++i)
+    output[i] = (uint8_t) (ctx->h[i / 8] >> (56 - 8 * (i % 8)));
+}
+
+int sha512(const unsigned char* input, uint32_t len, unsigned char* output)
+{
+  struct sha512_ctx ctx;
+
+  sha512_init(&ctx);
+  sha512_update(&ctx, input, len);
+  sha512_final(&ctx, output);
+  return 0;
+}
+
+static void ctx_init(void* ctx) { sha512_init(ctx); }
+static void ctx_update(void* ctx, const unsigned char* input, uint32_t len) { sha512_update(ctx, input, len); }
+static void ctx_final(void* ctx, unsigned char* output) { sha512_final(ctx, output); }
+
+const struct hash hash_sha512 = {
+  SHA512_HASH_LEN, sizeof(struct sha512_ctx), sha512, ctx_init, ctx_update, ctx_final, NULL, NULL
+};
+
+/* hash_ctx has to be able to hold it */
+typedef char sha512_ctx_fits[sizeof(struct sha512_ctx) <= sizeof(hash_ctx) ? 1 : -1];
+
+
+#ifdef SHA512_MAIN
+int main()
+{
+  static const char* vectors[][2] = {
+    { "I wonder if it will work",
+      "2690e70561d0e8cde1525707d1b85f5ad84b1085835b83f5974f9086b61079472e17de9b398c71d5da0ef6f77b3670186c67b2004128e1191bdfa3e57af97bb6" },
+    { "",
+      "cf83e1357eefb8bdf1542850d66d8007d620e4050b5715dc83f4a921d36ce9ce47d0d13c5d85f2b0ff8318d2877eec2f63b931bd47417a81a538327af927da3e" },
+    { "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+      "204a8fc6dda82f0a0ced7beb8e08a41657c16ef468b228a8279be331a703c33596fd15c13b1b07f9aa1d3bea57789ca031ad85c7a71dd70354ec631238ca3445" },
+    { "qqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqq",
+      "f4d3237a8f946f9d42031992a74d2ea70e85bb4c16b52b7686c38664d63f2d817fb78539a36900abdb0c561c52f53571fb5d157a5f2ec9ec738980a534b79a52" },
+  };
+  unsigned char output[SHA512_HASH_LEN];
+  unsigned char expected_output[SHA512_HASH_LEN];
+  uint32_t i, split;
+
+  for (i = 0; i < sizeof vectors / sizeof *vectors; ++i) {
+    const unsigned char* input = (const unsigned char*)vectors[i][0];
+    uint32_t len = strlen(vectors[i][0]);
+
+    sha512(input, len, output);
+    printf("sha512(%s) = ", input); print_hex(output, SHA512_HASH_LEN);
+    unhexlify((unsigned char*)vectors[i][1], 2 * SHA512_HASH_LEN, expected_output);
+    require (memcmp(output, expected_output, SHA512_HASH_LEN) == 0, "invalid hash");
+
+    /*  the same through every two-part split of the input */
+    for (split = 0; split <= len; ++split) {
+      struct sha512_ctx ctx;
+      sha512_init(&ctx);
+      sha512_update(&ctx, input, split);
+      sha512_update(&ctx, input + split, len - split);
+      sha512_final(&ctx, output);
+      require (memcmp(output, expected_output, SHA512_HASH_LEN) == 0, "invalid incremental hash");
+    }
+  }
+
+  printf("OK\n");
+  return 0;
+}
+#endif
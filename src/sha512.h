@@ -0,0 +1,24 @@
+#ifndef __SHA512__
+#define __SHA512__
+
+#include <stdint.h>
+
+#include "hash.h"
+
+#define SHA512_HASH_LEN 64
+#define SHA512_BLOCK_LEN 128
+
+/* Running state; plain data, so a midstate can be copied with memcpy */
+struct sha512_ctx {
+  uint64_t h[8];
+  uint64_t len;  /* bytes absorbed so far */
+  uint8_t buf[SHA512_BLOCK_LEN];
+};
+
+void sha512_init(struct sha512_ctx* ctx);
+void sha512_update(struct sha512_ctx* ctx, const unsigned char* input, uint32_t len);
+void sha512_final(struct sha512_ctx* ctx, unsigned char* output);
+
+int sha512(const unsigned char* input, uint32_t len, unsigned char* output);
+
+#endif
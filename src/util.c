@@ -1,75 +1,680 @@
-#include "util.h"
-
-#include <stdint.h>
-#include <stdlib.h>
-#include <string.h>
-#include <stdio.h>
-
-
-void *heap_get(uint32_t n) {
-	if (heap.brk + n > heap.buf + heap.size) return NULL;
-  void *ret = heap.brk;
-  heap.brk += n;
-
-  return ret;
-}
-
-void heap_free(uint32_t n) {
-  if (heap.buf + n >= heap.brk)
-    heap.brk = heap.buf;
-  else
-    heap.brk -= n;
-}
-
-
-#if !defined(BIG_ENDIAN)
-void i2osp(void* dest, const void* src, uint32_t len)
-{
-  static int endianness = -1;
-  if (endianness == -1)
-  {
-    uint16_t x = 0x0102;
-    void* p = (void*)&x;
-    endianness = (*(uint8_t*)p == 0x01);
-  }
-
-  if (endianness == 1)
-  {
-    memcpy(dest, src, len);
-  }
-  else
-  {
-    uint32_t i;
-    for (i = 0; i < len; ++i)
-      memcpy(((char*)dest)+i, ((char*)src)+len-i-1, 1);
-  }
-}
-#endif
-
-#if defined(USE_IO) || !defined(__H8_2329F__)
-void print_hex(const unsigned char* bytes, uint32_t len)
-{
-  uint32_t i;
-  for (i = 0; i < len; ++i)
-    printf("%.2x", bytes[i]);
-  printf("\n");
-}
-
-#endif
-
-
-#if defined(IMPLEMENT_ALL)
-void unhexlify(const unsigned char* from, uint32_t len, unsigned char* to)
-{
-  require (!(len & 1), "invalid length: not even");
-  uint32_t i;
-  for (i = 0; i < len / 2; ++i)
-  {
-    uint8_t a = from[2*i];
-    uint8_t b = from[2*i+1];
-    a -= (a < 'a') ? '0' : 'a'-10;
-    b -= (b < 'a') ? '0' : 'a'-10;
-    to[i] = (a << 4) + b;
-  }
-}
+#if defined(__linux__) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE /* MAP_ANONYMOUS, madvise */
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+/* glibc's <endian.h> byte order constant, not the target flag util.h tests */
+#undef BIG_ENDIAN
+#endif
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#ifdef STAGE_TIMERS
+#include <pthread.h>
+#include <time.h>
+#endif
+
+#if defined(PERF_COUNTERS) && defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "util.h"
+
+
+ARENA_THREAD struct arena arena;
+
+bool arena_init(void *mem, uint32_t size)
+{
+  arena.base = NULL;
+  arena.mapped = 0;
+  if (mem == NULL)
+  {
+#if defined(__linux__)
+    void *p = MAP_FAILED;
+    uint32_t len = size;
+#ifdef ARENA_HUGEPAGES
+    len = (size + ARENA_HUGEPAGE_SIZE - 1) & ~(uint32_t)(ARENA_HUGEPAGE_SIZE - 1);
+    p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+    if (p == MAP_FAILED)
+      p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return false;
+#ifdef ARENA_HUGEPAGES
+    madvise(p, len, MADV_HUGEPAGE); /* no-op when hugetlb pages were granted */
+#endif
+    arena.base = mem = p;
+    arena.mapped = len;
+#elif !defined(__H8_2329F__)
+    arena.base = malloc(size + ARENA_ALIGN - 1);
+    if (arena.base == NULL) return false;
+    mem = (void*)(((uintptr_t)arena.base + ARENA_ALIGN - 1) & ~(uintptr_t)(ARENA_ALIGN - 1));
+#else
+    return false;
+#endif
+  }
+  require (((uintptr_t)mem & (ARENA_ALIGN - 1)) == 0, "arena memory not aligned");
+
+  arena.buf = arena.brk = mem;
+  arena.size = size;
+  return true;
+}
+
+bool arena_live(void)
+{
+  return arena.buf != NULL;
+}
+
+void arena_release(void)
+{
+#if defined(__linux__)
+  if (arena.base) munmap(arena.base, arena.mapped);
+#elif !defined(__H8_2329F__)
+  free(arena.base);
+#endif
+  arena.buf = arena.brk = NULL;
+  arena.base = NULL;
+  arena.size = arena.mapped = 0;
+}
+
+static void *arena_bump(uint32_t n)
+{
+  uint32_t off = (arena_mark() + ARENA_ALIGN - 1) & ~(uint32_t)(ARENA_ALIGN - 1);
+  if (off > arena.size || n > arena.size - off) {
+    require (0, "arena exhausted");
+    return NULL;
+  }
+  arena.brk = arena.buf + off + n;
+
+  return arena.buf + off;
+}
+
+#ifndef ARENA_PROFILE
+void *arena_get(uint32_t n)
+{
+  return arena_bump(n);
+}
+
+#else
+
+#ifndef ARENA_PROFILE_SITES
+  #define ARENA_PROFILE_SITES 64
+#endif
+/* Bytes of stack painted below the caller of arena_profile_begin() */
+#ifndef ARENA_STACK_PROBE
+  #define ARENA_STACK_PROBE 0x10000
+#endif
+#define STACK_PAINT 0xa5
+
+static struct {
+  const char *op;
+  uint32_t base, peak, max_peak;
+  uint32_t allocs, bytes;
+  int pool, pool_peak;
+  volatile unsigned char *stack;
+  uint16_t nsites;
+  struct {
+    const char *file;
+    int line;
+    uint32_t count, bytes;
+  } sites[ARENA_PROFILE_SITES];
+} prof;
+
+void *arena_get_at(uint32_t n, const char *file, int line)
+{
+  void *ret = arena_bump(n);
+  if (prof.op == NULL) return ret;
+
+  if (arena_mark() > prof.peak) prof.peak = arena_mark();
+  ++prof.allocs;
+  prof.bytes += n;
+
+  uint16_t i;
+  for (i = 0; i < prof.nsites; ++i)
+    if (prof.sites[i].line == line && strcmp(prof.sites[i].file, file) == 0)
+      break;
+  if (i == prof.nsites && prof.nsites < ARENA_PROFILE_SITES) {
+    prof.sites[i].file = file;
+    prof.sites[i].line = line;
+    prof.sites[i].count = prof.sites[i].bytes = 0;
+    ++prof.nsites;
+  }
+  if (i < prof.nsites) {
+    ++prof.sites[i].count;
+    prof.sites[i].bytes += n;
+  }
+  return ret;
+}
+
+void arena_profile_pool(int delta)
+{
+  prof.pool += delta;
+  if (prof.pool > prof.pool_peak) prof.pool_peak = prof.pool;
+}
+
+/* Fills the stack the profiled operation is about to run on with a known
+   pattern. Stacks grow downwards on every host this is built for. */
+static void __attribute__((noinline)) stack_paint(void)
+{
+  volatile unsigned char probe[ARENA_STACK_PROBE];
+  uint32_t i;
+  for (i = 0; i < ARENA_STACK_PROBE; ++i) probe[i] = STACK_PAINT;
+  prof.stack = probe;
+}
+
+static uint32_t __attribute__((noinline)) stack_used(void)
+{
+  uint32_t i;
+  for (i = 0; i < ARENA_STACK_PROBE && prof.stack[i] == STACK_PAINT; ++i);
+  return ARENA_STACK_PROBE - i;
+}
+
+void arena_profile_begin(const char *op)
+{
+  require (prof.op == NULL, "arena_profile_begin() calls cannot nest");
+
+  prof.op = op;
+  prof.base = prof.peak = arena_mark();
+  prof.allocs = prof.bytes = 0;
+  prof.pool_peak = prof.pool;
+  prof.nsites = 0;
+  stack_paint();
+}
+
+void arena_profile_end(void)
+{
+  uint32_t stack = stack_used();
+  uint16_t i;
+
+  printf("== %s\n", prof.op);
+  printf("heap   %6u bytes at peak, %u above entry\n", prof.peak, prof.peak - prof.base);
+  printf("allocs %6u calls, %u bytes requested\n", prof.allocs, prof.bytes);
+  printf("pool   %6d temporaries in use at peak\n", prof.pool_peak);
+  printf("stack  %6u bytes\n", stack);
+  for (i = 0; i < prof.nsites; ++i)
+    printf("  %s:%d\t%u x, %u bytes\n", prof.sites[i].file, prof.sites[i].line,
+           prof.sites[i].count, prof.sites[i].bytes);
+
+  if (prof.peak > prof.max_peak) prof.max_peak = prof.peak;
+  prof.op = NULL;
+}
+
+uint32_t arena_profile_peak(void)
+{
+  return prof.max_peak;
+}
+#endif
+
+
+#ifdef STAGE_TIMERS
+#define STAGE_NAME_(s) #s,
+const char* const stage_names[STAGE_COUNT] = { STAGES(STAGE_NAME_) };
+
+/* One per thread recording at a time, never freed. A thread that exits
+   hands its entry back, samples and all, and the next thread to register
+   adopts it and adds to them, so the list grows to the most threads ever
+   recording at once rather than to every thread ever started. */
+struct stage_thread {
+  struct stage_thread* next;
+  int idle;  /* its thread has exited, the entry is free to adopt */
+  struct stage_hist h[STAGE_COUNT];
+};
+static struct stage_thread* stage_threads;
+static __thread struct stage_thread* stage_mine;
+static pthread_key_t stage_key;
+static pthread_once_t stage_key_once = PTHREAD_ONCE_INIT;
+
+#if !defined(__x86_64__) && !defined(__i386__) && !defined(__aarch64__)
+uint64_t stage_clock(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (uint64_t)t.tv_sec * 1000000000ull + (uint64_t)t.tv_nsec;
+}
+#endif
+
+/*  Thread exit: the samples stay for the merge, the entry for reuse */
+static void stage_retire(void* t)
+{
+  __atomic_store_n(&((struct stage_thread*)t)->idle, 1, __ATOMIC_RELEASE);
+}
+
+static void stage_key_create(void)
+{
+  pthread_key_create(&stage_key, stage_retire);
+}
+
+static struct stage_thread* stage_register(void)
+{
+  struct stage_thread* t;
+
+  pthread_once(&stage_key_once, stage_key_create);
+  for (t = __atomic_load_n(&stage_threads, __ATOMIC_ACQUIRE); t; t = t->next) {
+    int idle = 1;
+    if (__atomic_load_n(&t->idle, __ATOMIC_RELAXED) &&
+        __atomic_compare_exchange_n(&t->idle, &idle, 0, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+      break;
+  }
+  if (!t) {
+    if (!(t = calloc(1, sizeof *t))) return NULL;
+    for (uint32_t s = 0; s < STAGE_COUNT; ++s) t->h[s].min = UINT64_MAX;
+    t->next = __atomic_load_n(&stage_threads, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&stage_threads, &t->next, t, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+  }
+  pthread_setspecific(stage_key, t);
+  return stage_mine = t;
+}
+
+uint32_t stage_thread_entries(void)
+{
+  const struct stage_thread* t;
+  uint32_t n = 0;
+  for (t = __atomic_load_n(&stage_threads, __ATOMIC_ACQUIRE); t; t = t->next) ++n;
+  return n;
+}
+
+/* Only the owning thread writes its histograms; the merge may read them at
+   any time, hence the relaxed atomics, which are plain loads and stores */
+#define STAGE_LOAD(x) __atomic_load_n(&(x), __ATOMIC_RELAXED)
+#define STAGE_STORE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELAXED)
+
+void stage_record(enum stage s, uint64_t ticks)
+{
+  struct stage_thread* t = stage_mine ? stage_mine : stage_register();
+  struct stage_hist* h;
+  uint32_t i;
+
+  if (!t) return;
+  h = &t->h[s];
+  if (ticks >> STAGE_MAX_BITS) ticks = (1ull << STAGE_MAX_BITS) - 1;
+  if (ticks < (1u << STAGE_SUB_BITS)) {
+    i = (uint32_t)ticks;
+  } else {
+    /*  the top STAGE_SUB_BITS + 1 bits of ticks, within their power of two */
+    const uint32_t shift = 63 - __builtin_clzll(ticks) - STAGE_SUB_BITS;
+    i = ((shift + 1) << STAGE_SUB_BITS) | (uint32_t)((ticks >> shift) & ((1u << STAGE_SUB_BITS) - 1));
+  }
+  STAGE_STORE(h->buckets[i], STAGE_LOAD(h->buckets[i]) + 1);
+  STAGE_STORE(h->count, STAGE_LOAD(h->count) + 1);
+  STAGE_STORE(h->sum, STAGE_LOAD(h->sum) + ticks);
+  if (ticks < STAGE_LOAD(h->min)) STAGE_STORE(h->min, ticks);
+  if (ticks > STAGE_LOAD(h->max)) STAGE_STORE(h->max, ticks);
+}
+
+void stage_merge(struct stage_hist out[STAGE_COUNT])
+{
+  const struct stage_thread* t;
+  uint32_t s, i;
+
+  memset(out, 0, STAGE_COUNT * sizeof *out);
+  for (s = 0; s < STAGE_COUNT; ++s) out[s].min = UINT64_MAX;
+  for (t = __atomic_load_n(&stage_threads, __ATOMIC_ACQUIRE); t; t = t->next)
+    for (s = 0; s < STAGE_COUNT; ++s) {
+      const struct stage_hist* h = &t->h[s];
+      uint64_t v;
+      for (i = 0; i < STAGE_BUCKETS; ++i) out[s].buckets[i] += STAGE_LOAD(h->buckets[i]);
+      out[s].count += STAGE_LOAD(h->count);
+      out[s].sum += STAGE_LOAD(h->sum);
+      if ((v = STAGE_LOAD(h->min)) < out[s].min) out[s].min = v;
+      if ((v = STAGE_LOAD(h->max)) > out[s].max) out[s].max = v;
+    }
+}
+
+void stage_reset(void)
+{
+  struct stage_thread* t;
+  uint32_t s, i;
+
+  for (t = __atomic_load_n(&stage_threads, __ATOMIC_ACQUIRE); t; t = t->next)
+    for (s = 0; s < STAGE_COUNT; ++s) {
+      struct stage_hist* h = &t->h[s];
+      for (i = 0; i < STAGE_BUCKETS; ++i) STAGE_STORE(h->buckets[i], 0);
+      STAGE_STORE(h->count, 0);
+      STAGE_STORE(h->sum, 0);
+      STAGE_STORE(h->min, UINT64_MAX);
+      STAGE_STORE(h->max, 0);
+    }
+}
+
+double stage_ticks_per_ns(void)
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__)
+  /*  measured once against CLOCK_MONOTONIC over 20 ms */
+  static double ratio;
+  if (!ratio) {
+    struct timespec a, b;
+    uint64_t ta, tb, ns;
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    ta = stage_clock();
+    do {
+      clock_gettime(CLOCK_MONOTONIC, &b);
+      ns = (uint64_t)(b.tv_sec - a.tv_sec) * 1000000000ull + (uint64_t)b.tv_nsec - (uint64_t)a.tv_nsec;
+    } while (ns < 20000000);
+    tb = stage_clock();
+    ratio = (double)(tb - ta) / (double)ns;
+  }
+  return ratio;
+#else
+  return 1.0;
+#endif
+}
+
+/* Bucket i covers [low, low + width) ticks */
+static uint64_t stage_bucket_low(uint32_t i, uint64_t* width)
+{
+  uint32_t shift;
+  if (i < (1u << STAGE_SUB_BITS)) {
+    *width = 1;
+    return i;
+  }
+  shift = (i >> STAGE_SUB_BITS) - 1;
+  *width = 1ull << shift;
+  return (uint64_t)((i & ((1u << STAGE_SUB_BITS) - 1)) | (1u << STAGE_SUB_BITS)) << shift;
+}
+
+/* The q quantile, as the middle of its bucket kept within [min, max] */
+static uint64_t stage_quantile(const struct stage_hist* h, double q)
+{
+  uint64_t rank = (uint64_t)(q * (double)h->count + 0.5), seen = 0, low, width;
+  uint32_t i;
+
+  if (rank < 1) rank = 1;
+  for (i = 0; i < STAGE_BUCKETS; ++i)
+    if ((seen += h->buckets[i]) >= rank) break;
+  if (i == STAGE_BUCKETS) return h->max;
+  low = stage_bucket_low(i, &width) + width / 2;
+  return low < h->min ? h->min : low > h->max ? h->max : low;
+}
+
+bool stage_dump_json(FILE* f)
+{
+  static const struct { const char* name; double q; } quantiles[] = {
+    { "p50", 0.5 }, { "p90", 0.9 }, { "p99", 0.99 }, { "p999", 0.999 }
+  };
+  static struct stage_hist h[STAGE_COUNT];
+  const double tpn = stage_ticks_per_ns();
+  uint32_t s, i, n;
+  uint64_t low, width;
+
+  stage_merge(h);
+  fprintf(f, "{\"clock\": \"%s\", \"ticks_per_ns\": %.4f, \"stages\": [",
+#if defined(__x86_64__) || defined(__i386__)
+          "tsc",
+#elif defined(__aarch64__)
+          "cntvct",
+#else
+          "monotonic",
+#endif
+          tpn);
+  for (s = 0; s < STAGE_COUNT; ++s) {
+    fprintf(f, "%s\n  {\"stage\": \"%s\", \"count\": %llu", s ? "," : "", stage_names[s],
+            (unsigned long long)h[s].count);
+    if (h[s].count) {
+      fprintf(f, ", \"mean_ns\": %.1f, \"min_ns\": %.1f", (double)h[s].sum / (double)h[s].count / tpn,
+              (double)h[s].min / tpn);
+      for (i = 0; i < sizeof quantiles / sizeof *quantiles; ++i)
+        fprintf(f, ", \"%s_ns\": %.1f", quantiles[i].name, (double)stage_quantile(&h[s], quantiles[i].q) / tpn);
+      fprintf(f, ", \"max_ns\": %.1f", (double)h[s].max / tpn);
+    }
+    fprintf(f, ", \"buckets\": [");
+    for (i = n = 0; i < STAGE_BUCKETS; ++i)
+      if (h[s].buckets[i]) {
+        low = stage_bucket_low(i, &width);
+        fprintf(f, "%s[%.1f, %.1f, %llu]", n++ ? ", " : "", (double)low / tpn, (double)(low + width) / tpn,
+                (unsigned long long)h[s].buckets[i]);
+      }
+    fprintf(f, "]}");
+  }
+  fprintf(f, "\n]}\n");
+  return !ferror(f);
+}
+#endif
+
+
+#ifdef PERF_COUNTERS
+#define PERF_NAME_(e) #e,
+const char* const perf_names[PERF_COUNT] = { PERF_EVENTS(PERF_NAME_) };
+
+#if defined(__linux__)
+/* One group, so that all events count over the same instructions: the
+   first event that opens leads it */
+static struct {
+  int leader;
+  int fd[PERF_COUNT];
+  uint32_t mask, n;
+  enum perf_event order[PERF_COUNT]; /* events in the group's read order */
+} perf = { -1, { 0 }, 0, 0, { 0 } };
+
+uint32_t perf_open(void)
+{
+  static const struct { uint32_t type; uint64_t config; } events[PERF_COUNT] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | PERF_COUNT_HW_CACHE_OP_READ << 8 |
+                          PERF_COUNT_HW_CACHE_RESULT_MISS << 16 },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+  };
+  struct perf_event_attr attr;
+  uint32_t e;
+
+  if (perf.leader >= 0) return perf.mask;
+  for (e = 0; e < PERF_COUNT; ++e) {
+    memset(&attr, 0, sizeof attr);
+    attr.size = sizeof attr;
+    attr.type = events[e].type;
+    attr.config = events[e].config;
+    attr.disabled = perf.leader < 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    perf.fd[e] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, perf.leader, 0);
+    if (perf.fd[e] < 0) continue;
+    if (perf.leader < 0) perf.leader = perf.fd[e];
+    perf.mask |= 1u << e;
+    perf.order[perf.n++] = (enum perf_event)e;
+  }
+  return perf.mask;
+}
+
+void perf_close(void)
+{
+  uint32_t i;
+  for (i = 0; i < perf.n; ++i) close(perf.fd[perf.order[i]]);
+  perf.leader = -1;
+  perf.mask = perf.n = 0;
+}
+
+void perf_start(void)
+{
+  if (perf.leader < 0) return;
+  ioctl(perf.leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(perf.leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+void perf_stop(struct perf_counts* c)
+{
+  uint64_t buf[3 + PERF_COUNT];  /* nr, time enabled, time running, values */
+  uint32_t i;
+
+  if (perf.leader < 0) return;
+  ioctl(perf.leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+  if (read(perf.leader, buf, sizeof buf) < (ssize_t)(3 * sizeof *buf) || buf[0] != perf.n || !buf[2]) {
+    c->valid = 0;  /* the group never got the counters */
+    return;
+  }
+  for (i = 0; i < perf.n; ++i)
+    c->v[perf.order[i]] += buf[2] < buf[1] ? (uint64_t)((double)buf[3 + i] * buf[1] / buf[2]) : buf[3 + i];
+  c->valid = perf.mask;
+}
+#else
+uint32_t perf_open(void) { return 0; }
+void perf_close(void) {}
+void perf_start(void) {}
+void perf_stop(struct perf_counts* c) { c->valid = 0; }
+#endif
+#endif
+
+
+/* In place: both ends are swapped inwards */
+static void memrev_in_place(unsigned char* lo, uint32_t len)
+{
+  unsigned char* hi = lo + len;
+
+#if defined(__SSSE3__)
+  const __m128i rev16 = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+  while (hi - lo >= 32)
+  {
+    hi -= 16;
+    __m128i x = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)lo), rev16);
+    _mm_storeu_si128((__m128i*)lo, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)hi), rev16));
+    _mm_storeu_si128((__m128i*)hi, x);
+    lo += 16;
+  }
+#endif
+#if defined(__GNUC__)
+  while (hi - lo >= 16)
+  {
+    uint64_t x, y;
+    hi -= 8;
+    memcpy(&x, lo, 8);
+    memcpy(&y, hi, 8);
+    x = __builtin_bswap64(x);
+    y = __builtin_bswap64(y);
+    memcpy(lo, &y, 8);
+    memcpy(hi, &x, 8);
+    lo += 8;
+  }
+#endif
+  while (hi - lo >= 2)
+  {
+    unsigned char t = *lo;
+    *lo++ = *--hi;
+    *hi = t;
+  }
+}
+
+void memrev(void* dest, const void* src, uint32_t len)
+{
+  unsigned char* d = dest;
+  const unsigned char* s = (const unsigned char*)src + len;
+
+  if (dest == src)
+  {
+    memrev_in_place(d, len);
+    return;
+  }
+
+#if defined(__AVX2__)
+  const __m256i rev32 = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                                         15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+  for (; len >= 32; len -= 32, d += 32)
+  {
+    s -= 32;
+    __m256i x = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)s), rev32);
+    _mm256_storeu_si256((__m256i*)d, _mm256_permute4x64_epi64(x, 0x4e));
+  }
+#endif
+#if defined(__SSSE3__)
+  const __m128i rev16 = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+  for (; len >= 16; len -= 16, d += 16)
+  {
+    s -= 16;
+    _mm_storeu_si128((__m128i*)d, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)s), rev16));
+  }
+#elif defined(__SSE2__)
+  for (; len >= 16; len -= 16, d += 16)
+  {
+    s -= 16;
+    __m128i x = _mm_loadu_si128((const __m128i*)s);
+    x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8)); /* bytes within words */
+    x = _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0x1b), 0x1b);  /* words within halves */
+    _mm_storeu_si128((__m128i*)d, _mm_shuffle_epi32(x, 0x4e));    /* halves */
+  }
+#endif
+#if defined(__GNUC__)
+  for (; len >= 8; len -= 8, d += 8)
+  {
+    uint64_t w;
+    s -= 8;
+    memcpy(&w, s, 8);
+    w = __builtin_bswap64(w);
+    memcpy(d, &w, 8);
+  }
+#endif
+  while (len--)
+    *d++ = *--s;
+}
+
+void memxor(void* dest, const void* src, uint32_t len)
+{
+  unsigned char* d = dest;
+  const unsigned char* s = src;
+
+#if defined(__AVX2__)
+  for (; len >= 32; len -= 32, d += 32, s += 32)
+    _mm256_storeu_si256((__m256i*)d, _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)d),
+                                                      _mm256_loadu_si256((const __m256i*)s)));
+#endif
+#if defined(__SSE2__)
+  for (; len >= 16; len -= 16, d += 16, s += 16)
+    _mm_storeu_si128((__m128i*)d, _mm_xor_si128(_mm_loadu_si128((const __m128i*)d),
+                                                _mm_loadu_si128((const __m128i*)s)));
+#endif
+  for (; len >= 4; len -= 4, d += 4, s += 4)
+  {
+    uint32_t a, b;
+    memcpy(&a, d, 4);
+    memcpy(&b, s, 4);
+    a ^= b;
+    memcpy(d, &a, 4);
+  }
+  while (len--)
+    *d++ ^= *s++;
+}
+
+#if !defined(BIG_ENDIAN)
+void i2osp(void* dest, const void* src, uint32_t len)
+{
+  memrev(dest, src, len);
+}
+#endif
+
+#if defined(USE_IO) || !defined(__H8_2329F__)
+void print_hex(const unsigned char* bytes, uint32_t len)
+{
+  uint32_t i;
+  for (i = 0; i < len; ++i)
+    printf("%.2x", bytes[i]);
+  printf("\n");
+}
+
+#endif
+
+
+#if defined(IMPLEMENT_ALL)
+void unhexlify(const unsigned char* from, uint32_t len, unsigned char* to)
+{
+  require (!(len & 1), "invalid length: not even");
+  uint32_t i;
+  for (i = 0; i < len / 2; ++i)
+  {
+    uint8_t a = from[2*i];
+    uint8_t b = from[2*i+1];
+    a -= (a < 'a') ? '0' : 'a'-10;
+    b -= (b < 'a') ? '0' : 'a'-10;
+    to[i] = (a << 4) + b;
+  }
+}
 #endif
\ No newline at end of file
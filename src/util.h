@@ -1,49 +1,192 @@
-#ifndef __UTIL__
-#define __UTIL__
-
-#include <stdio.h>
-#include <string.h>
-#include <stdint.h>
-#include <assert.h>
-
-#ifdef __H8_2329F__
-#define BIG_ENDIAN
-#endif
-
-
-
-#ifdef NDEBUG
-	#define require(p, msg) ((void)0)
-#else
-	#ifdef __H8_2329F__
-		extern void _CLOSEALL(void);
-		#define require(p, msg) { if (!(p) ) { fprintf(stderr, "%s\n", msg); _CLOSEALL(); } }
-	#else
-		#define require(p, msg) assert (p && #msg)
-	#endif
-#endif
-
-
-//#define HEAP_SIZE 0x51a0
-#define HEAP_SIZE 0x5958 // 44*514 + 256
-
-struct heap {
-	char *buf, *brk;
-	uint32_t size;
-};
-extern struct heap heap;
-
-void *heap_get(uint32_t n);
-void heap_free(uint32_t n);
-
-void i2osp(void* dest, const void* src, uint32_t len);
-void print_hex(const unsigned char* bytes, uint32_t len);
-void unhexlify(const unsigned char* hex, uint32_t len, unsigned char* dest);
-
-
-/*
-int memcmp(const void *a, const void *b, uint32_t nb);
-void memcpy(void *dest, const void *src, uint32_t nb);
-void memset(void *src, int val, uint32_t nb);
-*/
+#ifndef __UTIL__
+#define __UTIL__
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#ifdef __H8_2329F__
+#define BIG_ENDIAN
+#endif
+
+
+
+#ifdef NDEBUG
+	#define require(p, msg) ((void)0)
+#else
+	#ifdef __H8_2329F__
+		extern void _CLOSEALL(void);
+		#define require(p, msg) { if (!(p) ) { fprintf(stderr, "%s\n", msg); _CLOSEALL(); } }
+	#else
+		#define require(p, msg) assert (p && #msg)
+	#endif
+#endif
+
+
+/* Every arena allocation starts on an ARENA_ALIGN boundary: a cache line on
+   the host, the bus width on the H8S where RAM is too scarce to pad. */
+#ifndef ARENA_ALIGN
+	#ifdef __H8_2329F__
+		#define ARENA_ALIGN 2
+	#else
+		#define ARENA_ALIGN 64
+	#endif
+#endif
+
+/* Bytes an arena_get(n) takes out of the arena, padding included. */
+#define ARENA_ROUND(n) (((n) + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN)
+
+/* Size of the pages requested when built with -DARENA_HUGEPAGES (Linux only). */
+#define ARENA_HUGEPAGE_SIZE 0x200000
+
+/* Bump allocator. Allocations are released all at once by rolling the break
+   back to a mark taken beforehand:
+       uint32_t mark = arena_mark();
+       ... arena_get() ...
+       arena_rollback(mark);                                                */
+struct arena {
+	char *buf, *brk;
+	uint32_t size;
+	void *base;      /* what has to be handed back to the OS, if anything */
+	uint32_t mapped; /* length of the mapping behind base */
+};
+/* -DARENA_PER_THREAD gives every thread its own arena and bn pool, each
+   set up by arena_init() and bignum_pool_init() on that thread. */
+#ifdef ARENA_PER_THREAD
+	#if !defined(__GNUC__)
+		#error "ARENA_PER_THREAD needs __thread"
+	#endif
+	#define ARENA_THREAD __thread
+#else
+	#define ARENA_THREAD
+#endif
+extern ARENA_THREAD struct arena arena;
+
+/* mem may be NULL on the host, the arena is then mapped from the OS. */
+bool arena_init(void *mem, uint32_t size);
+/* True between arena_init() and arena_release(): a second arena_init()
+   would drop the first arena without releasing it. */
+bool arena_live(void);
+void arena_release(void);
+#define arena_mark() ((uint32_t)(arena.brk - arena.buf))
+#define arena_rollback(mark) (arena.brk = arena.buf + (mark))
+
+/* -DARENA_PROFILE instruments the arena: between arena_profile_begin() and
+   arena_profile_end() it records the heap high-water mark, the allocations
+   made from each call site, the pooled temporaries in use and how deep the
+   stack went, then prints them for the operation. */
+#ifdef ARENA_PROFILE
+void *arena_get_at(uint32_t n, const char *file, int line);
+#define arena_get(n) arena_get_at((n), __FILE__, __LINE__)
+void arena_profile_begin(const char *op);
+void arena_profile_end(void);
+uint32_t arena_profile_peak(void); /* highest break of all profiled operations */
+void arena_profile_pool(int delta);
+#else
+void *arena_get(uint32_t n);
+#define arena_profile_begin(op) ((void)0)
+#define arena_profile_end() ((void)0)
+#endif
+
+/* -DSTAGE_TIMERS times the stages of the RSA pipeline: the label hash, the
+   OAEP seed, MGF1, byte/bignum conversions and the exponentiation. Each
+   sample goes, without locking, to a log-linear histogram of the calling
+   thread (2^STAGE_SUB_BITS buckets per power of two, so about 3% wide);
+   stage_merge() adds up all threads on demand. The clock is the TSC where
+   there is one, so a sample costs two clock reads and a few adds.
+       STAGE_BEGIN(t0);
+       ... mgf1 ...
+       STAGE_END(mgf1, t0);                                                */
+#ifdef STAGE_TIMERS
+#if !defined(__GNUC__)
+	#error "STAGE_TIMERS needs GCC builtins (__thread, __atomic)"
+#endif
+#define STAGES(X) X(oaep_hash) X(seed) X(mgf1) X(bytes) X(exp)
+#define STAGE_ENUM_(s) STAGE_##s,
+enum stage { STAGES(STAGE_ENUM_) STAGE_COUNT };
+extern const char* const stage_names[STAGE_COUNT];
+
+#define STAGE_SUB_BITS 5
+#define STAGE_MAX_BITS 36 /* longer samples land in the last bucket */
+#define STAGE_BUCKETS ((STAGE_MAX_BITS - STAGE_SUB_BITS + 1) << STAGE_SUB_BITS)
+
+struct stage_hist {
+	uint64_t count, sum, min, max; /* in ticks */
+	uint64_t buckets[STAGE_BUCKETS];
+};
+
+#if defined(__x86_64__) || defined(__i386__)
+	#include <x86intrin.h>
+	#define stage_clock() ((uint64_t)__rdtsc())
+#elif defined(__aarch64__)
+	static inline uint64_t stage_clock(void)
+	{
+		uint64_t t;
+		__asm__ volatile ("mrs %0, cntvct_el0" : "=r" (t));
+		return t;
+	}
+#else
+	uint64_t stage_clock(void); /* CLOCK_MONOTONIC, in ns */
+#endif
+
+void stage_record(enum stage s, uint64_t ticks);
+/* out[s] = the histograms of stage s of every thread added up */
+void stage_merge(struct stage_hist out[STAGE_COUNT]);
+/* Clears every thread's histograms; samples recorded meanwhile may be lost */
+void stage_reset(void);
+double stage_ticks_per_ns(void);
+/* The merged histograms as one JSON object, times in ns */
+bool stage_dump_json(FILE* f);
+/* Per-thread histogram sets allocated so far; exited threads' are reused */
+uint32_t stage_thread_entries(void);
+
+#define STAGE_BEGIN(t) const uint64_t t = stage_clock()
+#define STAGE_END(s, t) stage_record(STAGE_##s, stage_clock() - (t))
+#else
+#define STAGE_BEGIN(t) ((void)0)
+#define STAGE_END(s, t) ((void)0)
+#endif
+
+/* -DPERF_COUNTERS lets the benchmarks read the hardware counters around
+   what they time (Linux perf_event_open, user space only). perf_open()
+   returns the mask of the events this machine counts: 0 off Linux, without
+   a PMU (most VMs) or when perf_event_paranoid forbids it, and the callers
+   then report timings alone. The counts are scaled up when the kernel had
+   to multiplex the counters.
+       perf_start();  ... region ...  perf_stop(&sum);                      */
+#ifdef PERF_COUNTERS
+#define PERF_EVENTS(X) X(cycles) X(instructions) X(l1d_misses) X(llc_misses) X(branch_misses)
+#define PERF_ENUM_(e) PERF_##e,
+enum perf_event { PERF_EVENTS(PERF_ENUM_) PERF_COUNT };
+extern const char* const perf_names[PERF_COUNT];
+
+struct perf_counts {
+	uint64_t v[PERF_COUNT];
+	uint32_t valid; /* bit e set when v[e] was counted */
+};
+
+uint32_t perf_open(void);
+void perf_close(void);
+void perf_start(void);
+/* Adds the counts since perf_start() to c */
+void perf_stop(struct perf_counts* c);
+#endif
+
+/* dest = src with its bytes in reverse order; the buffers must be the same
+   or not overlap */
+void memrev(void* dest, const void* src, uint32_t len);
+/* dest ^= src, in place; the buffers must not overlap */
+void memxor(void* dest, const void* src, uint32_t len);
+void i2osp(void* dest, const void* src, uint32_t len);
+void print_hex(const unsigned char* bytes, uint32_t len);
+void unhexlify(const unsigned char* hex, uint32_t len, unsigned char* dest);
+
+
+/*
+int memcmp(const void *a, const void *b, uint32_t nb);
+void memcpy(void *dest, const void *src, uint32_t nb);
+void memset(void *src, int val, uint32_t nb);
+*/
 #endif
\ No newline at end of file
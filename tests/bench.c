@@ -0,0 +1,306 @@
+#if defined(__linux__) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 199309L /* clock_gettime */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "drbg.h"
+#include "fixture.h"
+#include "pkcs1_v15.h"
+#include "pkcs_oaep.h"
+#include "pkcs_pss.h"
+#include "rsa.h"
+#include "sha256.h"
+#include "util.h"
+
+/*  End-to-end timings of one build (one WORD_SIZE) for every key size it
+    can hold. Each operation is warmed up, then repeated until it has run
+    BENCH_MIN_REPS times and for BENCH_BUDGET_NS, at most BENCH_MAX_REPS.
+    The signatures are of the 32-byte message's SHA-256, PSS with a salt of
+    hLen.
+
+      bench [CSV [JSONL]]
+
+    A table goes to stdout, and one row or JSON object per operation to the
+    files; `make bench` runs every WORD_SIZE and merges them. Built with
+    -DPERF_COUNTERS, each sample is also bracketed by the hardware counters,
+    reported per operation next to the timings; where they cannot be read
+    their columns stay empty (null in the JSON). */
+
+#define BENCH_WARMUP 2
+#define BENCH_MIN_REPS 5
+#define BENCH_MAX_REPS 2000
+#ifndef BENCH_BUDGET_NS
+  #define BENCH_BUDGET_NS 300000000ull
+#endif
+
+static const struct { const char* path; uint32_t bits; } bench_keys[] = {
+  { "private_1024.pem", 1024 },
+  { "private.pem", 2048 },
+  { "tests/keys/private_3072.pem", 3072 },
+  { "tests/keys/private_4096.pem", 4096 },
+  { "tests/keys/private_8192.pem", 8192 },
+};
+
+/* Everything the operations of one key work on */
+struct bench_key {
+  struct rsa_key_view v;
+  struct oaep_ctx o;
+  struct rsa_pub pub;
+  struct rsa_priv priv;
+  struct pkcs1_ctx v15;
+  uint32_t k, e;
+  unsigned char msg[32];
+  unsigned char em[BN_MAX_BITS / 16], cipher[BN_MAX_BITS / 16], out[BN_MAX_BITS / 16], sig[BN_MAX_BITS / 16], v15_sig[BN_MAX_BITS / 16];
+  unsigned char digest[SHA256_HASH_LEN];
+};
+
+static FILE *csv, *jsonl;
+
+/* Per-operation means of the hardware counters, negative when not counted */
+enum { HW_CYCLES, HW_INSTRUCTIONS, HW_L1D_MISSES, HW_LLC_MISSES, HW_BRANCH_MISSES, HW_COUNT };
+static const char* const hw_names[HW_COUNT] = { "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses" };
+#ifdef PERF_COUNTERS
+static uint32_t hw_mask;
+#endif
+
+static uint64_t now_ns(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (uint64_t)t.tv_sec * 1000000000ull + (uint64_t)t.tv_nsec;
+}
+
+static int cmp_u64(const void* a, const void* b)
+{
+  const uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+  return x < y ? -1 : x > y;
+}
+
+static void run(const char* op, struct bench_key* key, void (*fn)(struct bench_key*))
+{
+  static uint64_t samples[BENCH_MAX_REPS];
+  uint64_t total = 0, t;
+  uint32_t reps = 0, i;
+  double hw[HW_COUNT];
+#ifdef PERF_COUNTERS
+  struct perf_counts pc;
+  memset(&pc, 0, sizeof pc);
+#endif
+
+  /*  slow operations are warmed up once, there is no cache left to fill */
+  t = now_ns();
+  for (i = 0; i < BENCH_WARMUP && (!i || now_ns() - t < BENCH_BUDGET_NS / 10); ++i) fn(key);
+  while (reps < BENCH_MAX_REPS && (reps < BENCH_MIN_REPS || total < BENCH_BUDGET_NS)) {
+#ifdef PERF_COUNTERS
+    /*  outside the clock reads: the ioctls are not the operation's time */
+    perf_start();
+#endif
+    t = now_ns();
+    fn(key);
+    samples[reps] = now_ns() - t;
+#ifdef PERF_COUNTERS
+    perf_stop(&pc);
+#endif
+    total += samples[reps++];
+  }
+  qsort(samples, reps, sizeof *samples, cmp_u64);
+
+  const uint64_t median = samples[reps / 2], p99 = samples[(reps * 99 + 99) / 100 - 1], mean = total / reps;
+  const double per_sec = 1e9 / (double)median;
+
+  for (i = 0; i < HW_COUNT; ++i) {
+    hw[i] = -1;
+#ifdef PERF_COUNTERS
+    if (pc.valid & 1u << i) hw[i] = (double)pc.v[i] / reps;
+#endif
+  }
+
+  printf("%9u  %4u  %-18s %6u %14.3f %14.3f %12.1f", WORD_SIZE, key->v.n.len * 8, op, reps,
+         median / 1e3, p99 / 1e3, per_sec);
+  if (hw[HW_CYCLES] >= 0 && hw[HW_INSTRUCTIONS] >= 0)
+    printf(" %10.3f %5.2f", hw[HW_CYCLES] / 1e6, hw[HW_INSTRUCTIONS] / hw[HW_CYCLES]);
+  else if (hw[HW_CYCLES] >= 0)
+    printf(" %10.3f %5s", hw[HW_CYCLES] / 1e6, "-");
+  for (i = HW_L1D_MISSES; i < HW_COUNT && hw[HW_CYCLES] >= 0; ++i)
+    if (hw[i] >= 0) printf(" %10.0f", hw[i]);
+    else printf(" %10s", "-");
+  printf("\n");
+  fflush(stdout);
+  if (csv) {
+    fprintf(csv, "%u,%u,%s,%u,%llu,%llu,%llu,%llu,%.1f", WORD_SIZE, key->v.n.len * 8, op, reps,
+            (unsigned long long)median, (unsigned long long)p99, (unsigned long long)mean,
+            (unsigned long long)samples[0], per_sec);
+    for (i = 0; i < HW_COUNT; ++i)
+      if (hw[i] >= 0) fprintf(csv, ",%.1f", hw[i]);
+      else fprintf(csv, ",");
+    fprintf(csv, "\n");
+  }
+  if (jsonl) {
+    fprintf(jsonl, "{\"word_size\": %u, \"bits\": %u, \"op\": \"%s\", \"reps\": %u, \"median_ns\": %llu, "
+            "\"p99_ns\": %llu, \"mean_ns\": %llu, \"min_ns\": %llu, \"ops_per_sec\": %.1f",
+            WORD_SIZE, key->v.n.len * 8, op, reps, (unsigned long long)median, (unsigned long long)p99,
+            (unsigned long long)mean, (unsigned long long)samples[0], per_sec);
+    for (i = 0; i < HW_COUNT; ++i)
+      if (hw[i] >= 0) fprintf(jsonl, ", \"%s\": %.1f", hw_names[i], hw[i]);
+      else fprintf(jsonl, ", \"%s\": null", hw_names[i]);
+    fprintf(jsonl, "}\n");
+  }
+}
+
+static void op_oaep_encode(struct bench_key* key)
+{
+  require (pkcs_oaep_encode(&key->o, key->msg, sizeof key->msg, key->em) == 0, "encode failed");
+}
+
+static void op_rsa_encrypt(struct bench_key* key)
+{
+  require (rsa_encrypt(key->em, key->k, key->v.n.p, key->k, key->e, key->out) == 0, "rsa_encrypt failed");
+}
+
+static void op_rsa_encrypt_bn(struct bench_key* key)
+{
+  struct bn* m = bignum_tmp_get();
+  bignum_from_bytes(m, key->em, key->k);
+  require (rsa_encrypt_bn(&key->pub, m, key->out) == 0, "rsa_encrypt_bn failed");
+  bignum_tmp_put(m);
+}
+
+static void op_rsa_oaep_encrypt(struct bench_key* key)
+{
+  require (rsa_oaep_encrypt(&key->o, &key->pub, key->msg, sizeof key->msg, key->cipher) == 0, "rsa_oaep_encrypt failed");
+}
+
+static void op_rsa_decrypt_crt(struct bench_key* key)
+{
+  require (rsa_decrypt_crt(&key->priv, key->cipher, key->k, key->out) == 0, "rsa_decrypt_crt failed");
+}
+
+static void op_pss_sign(struct bench_key* key)
+{
+  require (rsa_pss_sign(&hash_sha256, &key->priv, SHA256_HASH_LEN, key->msg, sizeof key->msg, key->sig) == 0,
+           "rsa_pss_sign failed");
+}
+
+static void op_pss_verify(struct bench_key* key)
+{
+  require (rsa_pss_verify(&hash_sha256, &key->pub, SHA256_HASH_LEN, key->msg, sizeof key->msg, key->sig, key->k) == 0,
+           "rsa_pss_verify failed");
+}
+
+static void op_verify_pkcs1_v15(struct bench_key* key)
+{
+  require (rsa_verify_pkcs1_v15(&key->v15, &key->pub, key->digest, key->v15_sig, key->k) == 0,
+           "rsa_verify_pkcs1_v15 failed");
+}
+
+/* A PKCS#1 v1.5 signature of key->digest: the context's EM with the hash in */
+static void sign_pkcs1_v15(struct bench_key* key)
+{
+  struct bn* em = bignum_tmp_get();
+  bignum_from_limbs(em, key->v15.em, key->v15.words);
+  bignum_to_bytes(em, key->em, key->k);
+  memcpy(key->em + key->k - sizeof key->digest, key->digest, sizeof key->digest);
+  require (rsa_decrypt_crt(&key->priv, key->em, key->k, key->v15_sig) == 0, "signing failed");
+  bignum_tmp_put(em);
+}
+
+static void op_rsa_pub_init(struct bench_key* key)
+{
+  const uint32_t mark = arena_mark();
+  struct rsa_pub pub;
+  require (rsa_pub_from_view(&pub, &key->v), "rsa_pub_init failed");
+  arena_rollback(mark);
+}
+
+static void op_rsa_priv_init(struct bench_key* key)
+{
+  const uint32_t mark = arena_mark();
+  struct rsa_priv priv;
+  require (rsa_priv_init(&priv, &key->v), "rsa_priv_init failed");
+  arena_rollback(mark);
+}
+
+#ifdef BENCH_MAIN
+int main(int argc, char** argv)
+{
+  static struct bench_key key;
+  static const char header[] = "word_size,bits,op,reps,median_ns,p99_ns,mean_ns,min_ns,ops_per_sec,"
+                               "cycles,instructions,l1d_misses,llc_misses,branch_misses\n";
+  uint32_t i;
+
+  if (argc > 1 && !(csv = fopen(argv[1], "w"))) return 1;
+  if (argc > 2 && !(jsonl = fopen(argv[2], "w"))) return 1;
+  if (csv) fputs(header, csv);
+
+  /*  the pool, a key's contexts, OAEP and PKCS#1 v1.5 templates, and the
+      contexts built again by the setup timings */
+  if (!fixture_init(RSA_POOL_BYTES(BN_MAX_BITS / 2, WORD_SIZE) + RSA_PUB_BYTES(BN_MAX_BITS / 2, WORD_SIZE) +
+                    2 * RSA_PRIV_BYTES(BN_MAX_BITS / 2, WORD_SIZE) + OAEP_CTX_BYTES(BN_MAX_BITS / 2) +
+                    PKCS1_CTX_BYTES(BN_MAX_BITS / 2, WORD_SIZE), BN_MAX_BITS / 2))
+    return 1;
+  drbg_seed((const unsigned char*)"bench", 5);
+  for (i = 0; i < sizeof key.msg; ++i) key.msg[i] = (unsigned char)i;
+  hash_sha256.digest(key.msg, sizeof key.msg, key.digest);
+
+#ifdef PERF_COUNTERS
+  /*  the counters come in the order of hw_names */
+  for (i = 0; i < HW_COUNT; ++i) require (!strcmp(perf_names[i], hw_names[i]), "counter names out of step");
+  if (!(hw_mask = perf_open()))
+    fprintf(stderr, "hardware counters unavailable (no PMU, or perf_event_paranoid): timings only\n");
+#endif
+  printf("word_size  bits  op                   reps     median us        p99 us        ops/s");
+#ifdef PERF_COUNTERS
+  if (hw_mask & 1u << PERF_cycles)
+    printf("    Mcycles   IPC   L1d miss   LLC miss   br. miss");
+#endif
+  printf("\n");
+  for (i = 0; i < sizeof bench_keys / sizeof *bench_keys; ++i) {
+    const uint32_t mark = arena_mark();
+    struct key_file f;
+
+    if (2 * bench_keys[i].bits > BN_MAX_BITS) {
+      fprintf(stderr, "%u-bit keys need BN_MAX_BITS of %u: skipped\n", bench_keys[i].bits, 2 * bench_keys[i].bits);
+      continue;
+    }
+    fixture_key(bench_keys[i].path, &f, &key.v);
+    key.k = key.v.n.len;
+    require (key.k * 8 == bench_keys[i].bits, "key of the wrong size");
+    require (rsa_pub_from_view(&key.pub, &key.v) && rsa_priv_init(&key.priv, &key.v), "key setup failed");
+    require (oaep_ctx_init(&key.o, &hash_sha256, key.k, NULL, 0), "oaep_ctx_init failed");
+    require (pkcs1_ctx_init(&key.v15, &hash_sha256, key.k), "pkcs1_ctx_init failed");
+    key.e = key.pub.e;
+    sign_pkcs1_v15(&key);
+
+    run("pkcs_oaep_encode", &key, op_oaep_encode);
+    run("rsa_encrypt", &key, op_rsa_encrypt);
+    run("rsa_encrypt_bn", &key, op_rsa_encrypt_bn);
+    run("rsa_oaep_encrypt", &key, op_rsa_oaep_encrypt);
+    run("rsa_decrypt_crt", &key, op_rsa_decrypt_crt);
+    run("rsa_pss_sign", &key, op_pss_sign);
+    run("rsa_pss_verify", &key, op_pss_verify);
+    run("rsa_verify_v15", &key, op_verify_pkcs1_v15);
+    run("rsa_pub_init", &key, op_rsa_pub_init);
+    run("rsa_priv_init", &key, op_rsa_priv_init);
+
+    /*  the timed paths agree with each other */
+    op_rsa_encrypt(&key);
+    require (rsa_decrypt_crt(&key.priv, key.out, key.k, key.cipher) == 0 && !memcmp(key.cipher, key.em, key.k),
+             "rsa_encrypt and rsa_decrypt_crt disagree");
+
+    key_file_close(&f);
+    arena_rollback(mark);
+  }
+
+#ifdef PERF_COUNTERS
+  perf_close();
+#endif
+  arena_release();
+  if (csv) fclose(csv);
+  if (jsonl) fclose(jsonl);
+  return 0;
+}
+#endif
@@ -0,0 +1,239 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*  Compares two sets of `bench` runs, each the CSV of several runs one
+    after the other (`make bench_record` writes the baseline to
+    bench_output.txt, `make bench_compare` a new set and calls this):
+
+      bench_compare [-t PERCENT] [-a ALPHA] BASELINE NEW
+
+    Per benchmark (word size, key size, operation) the medians of the runs
+    on each side are compared with a two-sided Mann-Whitney U test, exact
+    for small untied samples and the normal approximation otherwise. A
+    benchmark has regressed when the median of its new medians is more than
+    PERCENT (5) slower than the baseline's and p < ALPHA (0.05). At least
+    four runs a side are needed for p to get below 0.05: a benchmark with
+    too few runs to ever reach ALPHA cannot pass, nor can one of the
+    baseline's that is missing from the new runs. The exit status is 1 if
+    any benchmark regressed, has too few runs or is missing. */
+
+#define MAX_BENCHES 256
+#define MAX_RUNS 64
+
+struct series {
+  unsigned word_size, bits;
+  char op[32];
+  unsigned n;
+  double median_ns[MAX_RUNS];
+};
+
+struct run_set {
+  struct series s[MAX_BENCHES];
+  unsigned count;
+};
+
+static struct series* find(struct run_set* set, unsigned ws, unsigned bits, const char* op)
+{
+  unsigned i;
+  for (i = 0; i < set->count; ++i)
+    if (set->s[i].word_size == ws && set->s[i].bits == bits && !strcmp(set->s[i].op, op)) return &set->s[i];
+  return NULL;
+}
+
+/* Column index of name in a CSV header, -1 if missing */
+static int column(const char* header, const char* name)
+{
+  const size_t len = strlen(name);
+  const char* p = header;
+  int i;
+  for (i = 0; p; ++i, p = strchr(p, ',') ? strchr(p, ',') + 1 : NULL)
+    if (!strncmp(p, name, len) && (p[len] == ',' || p[len] == '\n' || p[len] == '\r' || !p[len])) return i;
+  return -1;
+}
+
+/* Reads every row of every run in path; repeated headers are skipped */
+static int load(const char* path, struct run_set* set)
+{
+  char line[1024], header[1024] = "";
+  int cws = -1, cbits = -1, cop = -1, cmed = -1;
+  FILE* f = fopen(path, "r");
+
+  if (!f) {
+    perror(path);
+    return -1;
+  }
+  set->count = 0;
+  while (fgets(line, sizeof line, f)) {
+    char* field[64];
+    int n = 0;
+    char* p;
+
+    if (!strncmp(line, "word_size,", 10)) {
+      if (!*header) {
+        strcpy(header, line);
+        cws = column(header, "word_size");
+        cbits = column(header, "bits");
+        cop = column(header, "op");
+        cmed = column(header, "median_ns");
+      }
+      continue;
+    }
+    if (cws < 0 || cbits < 0 || cop < 0 || cmed < 0) break;
+    for (p = line; n < 64; ++p) {
+      field[n++] = p;
+      if (!(p = strchr(p, ','))) break;
+      *p = 0;
+    }
+    if (n <= cws || n <= cbits || n <= cop || n <= cmed) continue;
+
+    const unsigned ws = (unsigned)atoi(field[cws]), bits = (unsigned)atoi(field[cbits]);
+    struct series* s = find(set, ws, bits, field[cop]);
+    if (!s) {
+      if (set->count == MAX_BENCHES) continue;
+      s = &set->s[set->count++];
+      s->word_size = ws;
+      s->bits = bits;
+      snprintf(s->op, sizeof s->op, "%s", field[cop]);
+      s->n = 0;
+    }
+    if (s->n < MAX_RUNS) s->median_ns[s->n++] = atof(field[cmed]);
+  }
+  fclose(f);
+  if (cws < 0 || cbits < 0 || cop < 0 || cmed < 0) {
+    fprintf(stderr, "%s: not a bench CSV\n", path);
+    return -1;
+  }
+  return 0;
+}
+
+static int cmp_double(const void* a, const void* b)
+{
+  const double x = *(const double*)a, y = *(const double*)b;
+  return x < y ? -1 : x > y;
+}
+
+static double median(const double* v, unsigned n)
+{
+  double s[MAX_RUNS];
+  memcpy(s, v, n * sizeof *v);
+  qsort(s, n, sizeof *s, cmp_double);
+  return n & 1 ? s[n / 2] : (s[n / 2 - 1] + s[n / 2]) / 2;
+}
+
+/* Two-sided p-value of the Mann-Whitney U test of x against y */
+static double mann_whitney(const double* x, unsigned nx, const double* y, unsigned ny)
+{
+  double u = 0, ties = 0;
+  unsigned i, j;
+
+  /*  U counts the pairs where x wins, ties for a half */
+  for (i = 0; i < nx; ++i)
+    for (j = 0; j < ny; ++j) u += x[i] > y[j] ? 1 : x[i] == y[j] ? 0.5 : 0;
+  {
+    double all[2 * MAX_RUNS];
+    unsigned k, t, n = nx + ny;
+    memcpy(all, x, nx * sizeof *x);
+    memcpy(all + nx, y, ny * sizeof *y);
+    qsort(all, n, sizeof *all, cmp_double);
+    for (k = 0; k < n; k += t) {
+      for (t = 1; k + t < n && all[k + t] == all[k]; ++t);
+      ties += (double)t * t * t - t;
+    }
+  }
+
+  const double mean = nx * ny / 2.0, lo = u < mean ? u : 2 * mean - u;
+  if (ties == 0 && nx * ny <= 400) {
+    /*  exact: ways[j][v] orderings of i x's and j y's with U = v, built up
+        by the largest element being an x (beating all j y's) or a y */
+    static double ways[2][MAX_RUNS + 1][401];
+    double total = 0, tail = 0;
+    unsigned v, r = 0;
+    memset(ways[0], 0, sizeof ways[0]);
+    for (j = 0; j <= ny; ++j) ways[0][j][0] = 1;
+    for (i = 1; i <= nx; ++i, r ^= 1)
+      for (j = 0; j <= ny; ++j)
+        for (v = 0; v <= nx * ny; ++v)
+          ways[r ^ 1][j][v] = (v >= j ? ways[r][j][v - j] : 0) + (j ? ways[r ^ 1][j - 1][v] : 0);
+    for (v = 0; v <= nx * ny; ++v) {
+      total += ways[r][ny][v];
+      if (v <= lo) tail += ways[r][ny][v];
+    }
+    return 2 * tail / total > 1 ? 1 : 2 * tail / total;
+  }
+
+  const double sd = sqrt(nx * ny / 12.0 * ((nx + ny + 1) - ties / ((double)(nx + ny) * (nx + ny - 1))));
+  if (sd == 0) return 1;
+  const double z = (mean - lo - 0.5) / sd;  /* continuity correction */
+  const double p = erfc((z > 0 ? z : 0) / sqrt(2.0));
+  return p > 1 ? 1 : p;
+}
+
+/* The smallest p the test can give on nx and ny runs, both sides apart:
+   2 / C(nx + ny, nx) */
+static double least_p(unsigned nx, unsigned ny)
+{
+  double ways = 1;
+  unsigned i;
+  for (i = 1; i <= nx; ++i) ways = ways * (ny + i) / i;
+  return 2 / ways > 1 ? 1 : 2 / ways;
+}
+
+#ifdef BENCH_COMPARE_MAIN
+int main(int argc, char** argv)
+{
+  static struct run_set base, cur;
+  double threshold = 5, alpha = 0.05;
+  unsigned i, regressions = 0, missing = 0, few = 0;
+  int a = 1;
+
+  for (; a + 1 < argc && argv[a][0] == '-'; a += 2) {
+    if (!strcmp(argv[a], "-t")) threshold = atof(argv[a + 1]);
+    else if (!strcmp(argv[a], "-a")) alpha = atof(argv[a + 1]);
+    else break;
+  }
+  if (argc - a != 2) {
+    fprintf(stderr, "usage: bench_compare [-t PERCENT] [-a ALPHA] BASELINE NEW\n");
+    return 2;
+  }
+  if (load(argv[a], &base) || load(argv[a + 1], &cur)) return 2;
+
+  printf("word_size  bits  op                 runs    base us     new us     delta  p-value\n");
+  for (i = 0; i < cur.count; ++i) {
+    const struct series* n = &cur.s[i];
+    const struct series* b = find(&base, n->word_size, n->bits, n->op);
+    if (!b) {
+      printf("%9u  %4u  %-18s  not in the baseline\n", n->word_size, n->bits, n->op);
+      continue;
+    }
+
+    const double bm = median(b->median_ns, b->n), nm = median(n->median_ns, n->n);
+    const double delta = 100 * (nm - bm) / bm;
+    const double p = mann_whitney(b->median_ns, b->n, n->median_ns, n->n);
+    const char* verdict = "";
+    if (least_p(b->n, n->n) >= alpha) {
+      verdict = "TOO FEW RUNS";
+      ++few;
+    } else if (p < alpha && delta > threshold) {
+      verdict = "REGRESSION";
+      ++regressions;
+    } else if (p < alpha && delta < -threshold) {
+      verdict = "faster";
+    }
+    printf("%9u  %4u  %-18s %2u/%-2u %10.3f %10.3f %+8.1f%%  %7.4f  %s\n", n->word_size, n->bits, n->op, b->n,
+           n->n, bm / 1e3, nm / 1e3, delta, p, verdict);
+  }
+  for (i = 0; i < base.count; ++i)
+    if (!find(&cur, base.s[i].word_size, base.s[i].bits, base.s[i].op)) {
+      printf("%9u  %4u  %-18s  missing from the new runs\n", base.s[i].word_size, base.s[i].bits, base.s[i].op);
+      ++missing;
+    }
+
+  printf("%u regression%s beyond %.1f%% at p < %g", regressions, regressions == 1 ? "" : "s", threshold, alpha);
+  if (few) printf(", %u with too few runs to reach it", few);
+  if (missing) printf(", %u benchmark%s not run", missing, missing == 1 ? "" : "s");
+  printf("\n");
+  return regressions || few || missing ? 1 : 0;
+}
+#endif
@@ -0,0 +1,309 @@
+#if defined(__linux__) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 199309L /* clock_gettime */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define cycles() __rdtsc()
+#else
+#define cycles() 0ull
+#endif
+
+#include "bn.h"
+#include "util.h"
+
+/*  Cost against size of every bignum primitive, from 1 limb up to the
+    largest operands the build holds. Each point is the best of BN_BENCH_RUNS
+    batches of at least BN_BENCH_NS.
+
+      bn_bench [CSV [CROSSOVERS]]
+
+    CSV has one row per limb count and, per primitive, ns/op and TSC cycles
+    per limb, so the curves plot straight from it. CROSSOVERS has, per pair
+    of algorithms for one job, the limb count from which the second one
+    stays faster by more than the noise (0 if it never does). Built with a
+    low BN_KARATSUBA_CUTOFF, the Karatsuba curve is Karatsuba all the way
+    down rather than bignum_mul_naive in disguise.
+    Built with -DPERF_COUNTERS, CSV also has the IPC and the L1d, LLC and
+    branch misses per call of the best batch, left empty where the hardware
+    counters cannot be read. */
+
+#ifndef BN_BENCH_NS
+  #define BN_BENCH_NS 2000000ull
+#endif
+#define BN_BENCH_RUNS 3
+
+/* A win within timing noise is no win */
+#define BN_BENCH_MARGIN 0.97
+
+/* Operands of the point being measured */
+static struct bn a, b, c, q;
+static struct bn_mont mont;
+static DTYPE n_limbs[BN_ARRAY_SIZE / 2], rr_limbs[BN_ARRAY_SIZE / 2];
+static DTYPE x_limbs[BN_ARRAY_SIZE / 2], y_limbs[BN_ARRAY_SIZE / 2];
+
+static void fill(struct bn* x, uint32_t n)
+{
+  uint32_t i;
+  bignum_init(x);
+  for (i = 0; i < n; ++i) x->array[i] = (DTYPE)rand();
+  x->array[n - 1] |= 1;
+  x->len = (uint16_t)n;
+}
+
+static void op_add(void) { bignum_add(&a, &b, &c); }
+static void op_sub(void) { bignum_sub(&a, &b, &c); }
+/* bignum_lshift shifts its input as well: each call starts from a copy */
+static void op_lshift(void)
+{
+  bignum_assign(&c, &a);
+  bignum_lshift(&c, &c, 1);
+}
+static void op_rshift(void)
+{
+  bignum_assign(&c, &a);
+  bignum_rshift(&c, &c, 1);
+}
+static void op_lshift_word(void)
+{
+  bignum_assign(&c, &a);
+  bignum_lshift(&c, &c, 8 * WORD_SIZE);
+}
+static void op_mul_naive(void) { bignum_mul_naive(&a, &b, &c); }
+static void op_mul_karatsuba(void) { bignum_mul_karatsuba(&a, &b, &c); }
+static void op_div(void) { bignum_div(&q, &b, &c); }
+static void op_mod(void) { bignum_mod(&q, &b, &c); }
+static void op_mulmod(void)
+{
+  bignum_mul(&a, &b, &q);
+  bignum_mod(&q, &c, &a);
+}
+static void op_mont_mul(void) { bignum_mont_mul_limbs(&mont, x_limbs, y_limbs, x_limbs); }
+static void op_mont_mulmod(void)
+{
+  bignum_mont_mul_limbs(&mont, x_limbs, y_limbs, x_limbs);
+  bignum_mont_mul_limbs(&mont, x_limbs, rr_limbs, x_limbs);
+}
+
+/* Operands of n limbs for each primitive; max is the largest n it takes */
+static void setup_wide(uint32_t n)
+{
+  fill(&a, n);
+  fill(&b, n);
+  a.array[n - 1] = (DTYPE)((a.array[n - 1] >> 2) | ((MAX_VAL >> 2) + 1));
+  b.array[n - 1] >>= 2;  /* a > b, and a + b fits */
+}
+static void setup_product(uint32_t n)
+{
+  fill(&a, n);
+  fill(&b, n);
+  bignum_mul(&a, &b, &q);  /* 2n limbs to divide by b */
+  bignum_assign(&c, &b);
+}
+static void setup_mulmod(uint32_t n)
+{
+  setup_product(n);
+  a.len = b.len = (uint16_t)(n - 1 ? n - 1 : 1);  /* below the modulus */
+  if (n == 1) a.array[0] = b.array[0] = (DTYPE)(c.array[0] / 2);
+}
+static void setup_mont(uint32_t n)
+{
+  uint32_t i;
+  for (i = 0; i < n; ++i) {
+    n_limbs[i] = (DTYPE)rand();
+    x_limbs[i] = y_limbs[i] = (DTYPE)rand();
+  }
+  n_limbs[0] |= 1;
+  n_limbs[n - 1] |= (DTYPE)(MAX_VAL >> 1) + 1;
+  x_limbs[n - 1] = y_limbs[n - 1] = (DTYPE)(n_limbs[n - 1] >> 1);
+  mont.len = (uint16_t)n;
+  bignum_mont_init(&mont, n_limbs, (uint16_t)n, rr_limbs);
+}
+
+static const struct prim {
+  const char* name;
+  void (*op)(void);
+  void (*setup)(uint32_t n);
+  uint32_t max;
+} prims[] = {
+  { "add", op_add, setup_wide, BN_ARRAY_SIZE - 1 },
+  { "sub", op_sub, setup_wide, BN_ARRAY_SIZE - 1 },
+  { "lshift_1", op_lshift, setup_wide, BN_ARRAY_SIZE - 1 },
+  { "rshift_1", op_rshift, setup_wide, BN_ARRAY_SIZE - 1 },
+  { "lshift_word", op_lshift_word, setup_wide, BN_ARRAY_SIZE - 1 },
+  { "mul_naive", op_mul_naive, setup_product, BN_ARRAY_SIZE / 2 },
+  { "mul_karatsuba", op_mul_karatsuba, setup_product, BN_ARRAY_SIZE / 2 },
+  { "div", op_div, setup_product, BN_ARRAY_SIZE / 2 },
+  { "mod", op_mod, setup_product, BN_ARRAY_SIZE / 2 },
+  { "mulmod", op_mulmod, setup_mulmod, BN_ARRAY_SIZE / 2 },
+  { "mont_mul", op_mont_mul, setup_mont, BN_ARRAY_SIZE / 2 },
+  { "mont_mulmod", op_mont_mulmod, setup_mont, BN_ARRAY_SIZE / 2 },
+};
+#define NPRIMS (sizeof prims / sizeof *prims)
+
+/* Two ways of doing the same job: where the second takes over. Below
+   `first` limbs the second runs the first's code. */
+static const struct { const char *slow, *fast; uint32_t first; } pairs[] = {
+  { "mul_naive", "mul_karatsuba", BN_KARATSUBA_CUTOFF },
+  { "mulmod", "mont_mulmod", 1 },
+};
+
+static uint64_t now_ns(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (uint64_t)t.tv_sec * 1000000000ull + (uint64_t)t.tv_nsec;
+}
+
+/* IPC, then L1d, LLC and branch misses per call; negative when not counted */
+#define HW_COUNT 4
+#ifdef PERF_COUNTERS
+static const char* const hw_names[HW_COUNT] = { "ipc", "l1d_misses", "llc_misses", "branch_misses" };
+#endif
+
+/* Best ns and TSC cycles per call over BN_BENCH_RUNS batches, and the
+   hardware counters of the fastest batch */
+static void measure(void (*op)(void), double* ns, double* cyc, double* hw)
+{
+  uint64_t reps = 1, t, k, r;
+  int run, i;
+#ifdef PERF_COUNTERS
+  struct perf_counts pc;
+#endif
+
+  /*  a batch long enough to time */
+  for (;;) {
+    t = now_ns();
+    for (r = 0; r < reps; ++r) op();
+    if (now_ns() - t >= BN_BENCH_NS || reps >= (1ull << 30)) break;
+    reps *= 2;
+  }
+  *ns = *cyc = 1e300;
+  for (i = 0; i < HW_COUNT; ++i) hw[i] = -1;
+  for (run = 0; run < BN_BENCH_RUNS; ++run) {
+#ifdef PERF_COUNTERS
+    memset(&pc, 0, sizeof pc);
+    perf_start();
+#endif
+    t = now_ns();
+    k = cycles();
+    for (r = 0; r < reps; ++r) op();
+    k = cycles() - k;
+    t = now_ns() - t;
+#ifdef PERF_COUNTERS
+    perf_stop(&pc);
+    if ((double)t / reps < *ns) {
+      const uint32_t has_ipc = 1u << PERF_cycles | 1u << PERF_instructions;
+      hw[0] = (pc.valid & has_ipc) == has_ipc && pc.v[PERF_cycles]
+              ? (double)pc.v[PERF_instructions] / (double)pc.v[PERF_cycles] : -1;
+      for (i = 1; i < HW_COUNT; ++i)
+        hw[i] = pc.valid & 1u << (PERF_l1d_misses + i - 1) ? (double)pc.v[PERF_l1d_misses + i - 1] / reps : -1;
+    }
+#endif
+    if ((double)t / reps < *ns) *ns = (double)t / reps;
+    if ((double)k / reps < *cyc) *cyc = (double)k / reps;
+  }
+}
+
+/* 1 to 16 limbs one by one, then in steps of an eighth, ending on the
+   largest sum the build holds */
+static uint32_t next_size(uint32_t n)
+{
+  if (n < 16) return n + 1;
+  if (n == BN_ARRAY_SIZE - 1) return BN_ARRAY_SIZE;
+  n += n / 8;
+  return n < BN_ARRAY_SIZE - 1 ? n : BN_ARRAY_SIZE - 1;
+}
+
+#ifdef BN_BENCH_MAIN
+int main(int argc, char** argv)
+{
+  static double ns[BN_ARRAY_SIZE + 1][NPRIMS];
+  static uint32_t sizes[BN_ARRAY_SIZE];
+  FILE *csv = NULL, *cross = NULL;
+  uint32_t count = 0, n, i, p, s;
+
+  if (argc > 1 && !(csv = fopen(argv[1], "w"))) return 1;
+  if (argc > 2 && !(cross = fopen(argv[2], "w"))) return 1;
+  if (!arena_init(NULL, (BN_MOD_TEMPS(BN_ARRAY_SIZE) + 1) * ARENA_ROUND(sizeof(struct bn)))) return 1;
+  bignum_pool_init(BN_MOD_TEMPS(BN_ARRAY_SIZE) + 1);
+  srand(1);
+#ifdef PERF_COUNTERS
+  if (!perf_open())
+    fprintf(stderr, "hardware counters unavailable (no PMU, or perf_event_paranoid): timings only\n");
+#endif
+
+  if (csv) {
+    fprintf(csv, "limbs");
+    for (p = 0; p < NPRIMS; ++p) {
+      fprintf(csv, ",%s_ns,%s_cycles_per_limb", prims[p].name, prims[p].name);
+#ifdef PERF_COUNTERS
+      for (i = 0; i < HW_COUNT; ++i) fprintf(csv, ",%s_%s", prims[p].name, hw_names[i]);
+#endif
+    }
+    fprintf(csv, "\n");
+  }
+  printf("WORD_SIZE %u, BN_KARATSUBA_CUTOFF %u, ns/op\nlimbs", WORD_SIZE, BN_KARATSUBA_CUTOFF);
+  for (p = 0; p < NPRIMS; ++p) printf(" %13s", prims[p].name);
+  printf("\n");
+
+  for (n = 1; n < BN_ARRAY_SIZE; n = next_size(n)) {
+    sizes[count++] = n;
+    printf("%5u", n);
+    if (csv) fprintf(csv, "%u", n);
+    for (p = 0; p < NPRIMS; ++p) {
+      double cyc = 0, hw[HW_COUNT] = { -1, -1, -1, -1 };
+      ns[n][p] = 0;
+      if (n <= prims[p].max) {
+        prims[p].setup(n);
+        measure(prims[p].op, &ns[n][p], &cyc, hw);
+      }
+      if (ns[n][p] > 0) printf(" %13.1f", ns[n][p]);
+      else printf(" %13s", "-");
+      if (csv) {
+        if (ns[n][p] > 0) fprintf(csv, ",%.1f,%.2f", ns[n][p], cyc / n);
+        else fprintf(csv, ",,");
+#ifdef PERF_COUNTERS
+        for (i = 0; i < HW_COUNT; ++i)
+          if (hw[i] >= 0) fprintf(csv, i ? ",%.2f" : ",%.3f", hw[i]);
+          else fprintf(csv, ",");
+#endif
+      }
+    }
+    printf("\n");
+    fflush(stdout);
+    if (csv) fprintf(csv, "\n");
+  }
+
+  /*  the smallest size from which the fast one wins at every size measured */
+  if (cross) fprintf(cross, "slow,fast,from_limbs\n");
+  for (i = 0; i < sizeof pairs / sizeof *pairs; ++i) {
+    uint32_t ps = 0, pf = 0, from = 0;
+    for (p = 0; p < NPRIMS; ++p) {
+      if (!strcmp(prims[p].name, pairs[i].slow)) ps = p;
+      if (!strcmp(prims[p].name, pairs[i].fast)) pf = p;
+    }
+    for (s = count; s-- > 0 && sizes[s] >= pairs[i].first;) {
+      if (!ns[sizes[s]][ps] || !ns[sizes[s]][pf]) continue;  /* beyond one's operands */
+      if (ns[sizes[s]][pf] >= BN_BENCH_MARGIN * ns[sizes[s]][ps]) break;
+      from = sizes[s];
+    }
+    if (from) printf("%s beats %s from %u limbs\n", pairs[i].fast, pairs[i].slow, from);
+    else printf("%s never stays ahead of %s\n", pairs[i].fast, pairs[i].slow);
+    if (cross) fprintf(cross, "%s,%s,%u\n", pairs[i].slow, pairs[i].fast, from);
+  }
+
+#ifdef PERF_COUNTERS
+  perf_close();
+#endif
+  arena_release();
+  if (csv) fclose(csv);
+  if (cross) fclose(cross);
+  return 0;
+}
+#endif
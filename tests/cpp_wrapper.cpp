@@ -0,0 +1,138 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+#include "rsa.hpp"
+
+extern "C" {
+#include "fixture.h"
+}
+
+#define ROUNDS 20000
+
+template <unsigned Bits>
+static rsa::BigInt<Bits> random_below(const rsa::Modulus<Bits>& n)
+{
+  unsigned char b[Bits / 8];
+  rsa::BigInt<Bits> x;
+  do {
+    for (auto& c : b) c = (unsigned char)rand();
+    x.assign(b, sizeof b);
+  } while (!x.below(n.n().data(), n.context().len));
+  return x;
+}
+
+/* a * b % n against the schoolbook bignum_mul and bignum_mod */
+template <unsigned Bits>
+static void check_mulmod(const rsa::Modulus<Bits>& n)
+{
+  unsigned char b[Bits / 8], r[Bits / 8];
+  struct bn *x = bignum_tmp_get(), *y = bignum_tmp_get(), *z = bignum_tmp_get(), *m = bignum_tmp_get();
+
+  for (int i = 0; i < 20; ++i) {
+    rsa::BigInt<Bits> a = random_below(n), c = random_below(n);
+    rsa::BigInt<Bits> p = a * c % n;
+
+    a.to_bytes(b, sizeof b);
+    bignum_from_bytes(x, b, sizeof b);
+    c.to_bytes(b, sizeof b);
+    bignum_from_bytes(y, b, sizeof b);
+    n.n().to_bytes(b, sizeof b);
+    bignum_from_bytes(m, b, sizeof b);
+    bignum_mul(x, y, z);
+    bignum_mod(z, m, x);
+    bignum_to_bytes(x, r, sizeof r);
+    p.to_bytes(b, sizeof b);
+    require(!memcmp(b, r, sizeof b), "mulmod differs from bignum_mul and bignum_mod");
+  }
+  bignum_tmp_put(m);
+  bignum_tmp_put(z);
+  bignum_tmp_put(y);
+  bignum_tmp_put(x);
+}
+
+/* the wrapper and rsa_encrypt_bn agree */
+template <unsigned Bits>
+static void check_encrypt(const rsa::PublicKey<Bits>& key)
+{
+  unsigned char m[Bits / 8], c1[Bits / 8], c2[Bits / 8];
+  const std::size_t k = key.size();
+  struct bn* x = bignum_tmp_get();
+
+  for (int i = 0; i < 5; ++i) {
+    for (std::size_t j = 0; j < k; ++j) m[j] = (unsigned char)rand();
+    m[0] = 0;
+    require(key.encrypt(m, k, c1), "encrypt failed");
+    bignum_from_bytes(x, m, (uint32_t)k);
+    require(rsa_encrypt_bn(key.c_key(), x, c2) == 0, "rsa_encrypt_bn failed");
+    require(!memcmp(c1, c2, k), "wrapper and C encrypt differ");
+  }
+  memset(m, 0xff, k);
+  require(!key.encrypt(m, k, c1), "message above n accepted");
+  bignum_tmp_put(x);
+}
+
+template <unsigned Bits>
+static rsa::PublicKey<Bits> load(const char* path)
+{
+  key_file f;
+  rsa_key_view v;
+  fixture_key(path, &f, &v);
+  auto key = rsa::PublicKey<Bits>::from_view(v);
+  require(key, "unusable key");
+  key_file_close(&f);
+  return *key;
+}
+
+#ifdef CPP_WRAPPER_MAIN
+int main()
+{
+  rsa::Workspace ws(RSA_POOL_BYTES(4096, WORD_SIZE), RSA_POOL_COUNT(4096, WORD_SIZE));
+  if (!ws) return 1;
+  srand(1);
+
+  auto k2048 = load<2048>("private.pem");
+  auto k1024 = load<1024>("private_1024.pem");
+  check_encrypt(k2048);
+  check_encrypt(k1024);
+  check_mulmod(k2048.modulus());
+  check_mulmod(k1024.modulus());
+
+  /*  a 1024-bit key in a 2048-bit type, and keys that moved */
+  check_encrypt(load<2048>("private_1024.pem"));
+  {
+    std::vector<rsa::PublicKey<2048>> keys;
+    for (int i = 0; i < 8; ++i) keys.push_back(load<2048>(i % 2 ? "private.pem" : "private_1024.pem"));
+    for (const auto& key : keys) check_encrypt(key);
+  }
+
+  /*  an even modulus is refused; a Workspace moves, it is not duplicated,
+      and a second one leaves the live arena alone */
+  {
+    {
+      rsa::Workspace second(RSA_POOL_BYTES(1024, WORD_SIZE), RSA_POOL_COUNT(1024, WORD_SIZE));
+      require(!second, "second workspace took the arena");
+    }
+    require(arena_live(), "second workspace released the arena");
+    check_encrypt(k2048);
+
+    unsigned char even[2] = { 0x12, 0x34 };
+    require(!rsa::Modulus<1024>::from_bytes(even, 2), "even modulus accepted");
+    rsa::Workspace moved(std::move(ws));
+    require(moved && !ws, "workspace not moved");
+    rsa::Scratch scratch;
+    ws = std::move(moved);
+  }
+
+  rsa::BigInt<2048> a = random_below(k2048.modulus()), b = random_below(k2048.modulus());
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < ROUNDS; ++i) a = a * b % k2048.modulus();
+  double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+  printf("2048-bit mulmod %8.2f us\n", us / ROUNDS);
+
+  printf("OK\n");
+  return 0;
+}
+#endif
@@ -0,0 +1,18 @@
+#include "fixture.h"
+#include "util.h"
+
+bool fixture_init(uint32_t bytes, uint32_t bits)
+{
+  if (!arena_init(NULL, bytes)) return false;
+  bignum_pool_init(RSA_POOL_COUNT(bits, WORD_SIZE));
+  return true;
+}
+
+void fixture_key(const char* path, struct key_file* f, struct rsa_key_view* key)
+{
+  struct rsa_key_view more;
+
+  require (key_file_open(f, path), "cannot open key file");
+  require (key_file_next(f, key) == 1, "no key in file");
+  require (key_file_next(f, &more) == 0, "more than one key in file");
+}
@@ -0,0 +1,18 @@
+#ifndef __FIXTURE__
+#define __FIXTURE__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "pem.h"
+#include "rsa.h"
+
+/* Set-up shared by the test harnesses: an OS-mapped arena of `bytes` and the
+   bn pool for keys of up to `bits` bits. False when the arena cannot be had. */
+bool fixture_init(uint32_t bytes, uint32_t bits);
+
+/* Opens the key file at `path` and reads its key into `key`; the test fails
+   unless the file holds exactly one. Close f when done with the view. */
+void fixture_key(const char* path, struct key_file* f, struct rsa_key_view* key);
+
+#endif
@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fixture.h"
+#include "keystore.h"
+#include "pem.h"
+#include "rsa.h"
+#include "util.h"
+
+#define STORE "build/keystore_check.ks"
+#define SYNTHETIC 2000
+#define SYNTHETIC_BYTES 256
+
+/* c = m^e with a context built from the view and with the mapped one */
+static void check_pub(const struct keystore* ks, const struct rsa_key_view* v, const unsigned char* m)
+{
+  unsigned char id[KEYSTORE_ID_LEN], c1[512], c2[512];
+  const struct keystore_record* r;
+  const uint32_t mark = arena_mark();
+  struct rsa_pub built, mapped;
+  struct bn* bm = bignum_tmp_get();
+
+  keystore_id(v->n.p, v->n.len, id);
+  require ((r = keystore_find(ks, id)) != NULL, "key not in store");
+  require (keystore_pub(ks, r, &mapped), "keystore_pub failed");
+  require (rsa_pub_from_view(&built, v), "rsa_pub_from_view failed");
+  require (mapped.nlen == built.nlen && mapped.e == built.e, "key sizes differ");
+
+  bignum_from_bytes(bm, m, built.nlen);
+  require (rsa_encrypt_bn(&built, bm, c1) == 0, "encrypt with built key failed");
+  bignum_from_bytes(bm, m, built.nlen);
+  require (rsa_encrypt_bn(&mapped, bm, c2) == 0, "encrypt with mapped key failed");
+  require (!memcmp(c1, c2, built.nlen), "built and mapped keys differ");
+
+  bignum_tmp_put(bm);
+  arena_rollback(mark);
+}
+
+/* m == (m^e)^d with both halves mapped */
+static void check_priv(const struct keystore* ks, const struct rsa_key_view* v, const unsigned char* m)
+{
+  unsigned char id[KEYSTORE_ID_LEN], c[512], back[512];
+  const struct keystore_record* r;
+  struct rsa_priv key;
+  struct bn* bm = bignum_tmp_get();
+
+  keystore_id(v->n.p, v->n.len, id);
+  require ((r = keystore_find(ks, id)) != NULL && (r->flags & KEYSTORE_PRIVATE), "private key not in store");
+  require (keystore_priv(ks, r, &key), "keystore_priv failed");
+  bignum_from_bytes(bm, m, key.pub.nlen);
+  require (rsa_encrypt_bn(&key.pub, bm, c) == 0, "encrypt failed");
+  require (rsa_decrypt_crt(&key, c, key.pub.nlen, back) == 0, "decrypt failed");
+  require (!memcmp(m, back, key.pub.nlen), "decrypt does not invert encrypt");
+  bignum_tmp_put(bm);
+}
+
+#ifdef KEYSTORE_CHECK_MAIN
+int main()
+{
+  static unsigned char moduli[SYNTHETIC][SYNTHETIC_BYTES];
+  static struct rsa_key_view synthetic[SYNTHETIC];
+  static const unsigned char e[3] = { 1, 0, 1 };
+  unsigned char m[512] = { 0 }, id[KEYSTORE_ID_LEN];
+  struct key_file files[4];
+  struct rsa_key_view keys[4];
+  struct keystore ks;
+  uint32_t i, j;
+
+  if (!fixture_init(2 * RSA_PRIV_BYTES(4096, WORD_SIZE) + RSA_POOL_BYTES(4096, WORD_SIZE), 4096)) return 1;
+  srand(1);
+  for (i = 1; i < sizeof m; ++i) m[i] = (unsigned char)rand();
+
+  /*  a private key, its public halves (the same modulus again) and another
+      private key of a different size */
+  fixture_key("private.pem", &files[0], &keys[0]);
+  fixture_key("tests/keys/public.pem", &files[1], &keys[1]);
+  fixture_key("tests/keys/public_rsa.pem", &files[2], &keys[2]);
+  fixture_key("private_1024.pem", &files[3], &keys[3]);
+  require (keystore_write(STORE, keys, 4), "keystore_write failed");
+
+  require (keystore_open(&ks, STORE), "keystore_open failed");
+  require (ks.h->count == 2, "duplicate modulus stored twice");
+  for (i = 0; i < 4; ++i) check_pub(&ks, &keys[i], m);
+  check_priv(&ks, &keys[0], m);
+  check_priv(&ks, &keys[3], m);
+  memset(id, 0, sizeof id);
+  require (keystore_find(&ks, id) == NULL, "unknown key found");
+  keystore_close(&ks);
+
+  /*  stores of another build are refused */
+  {
+    FILE* f = fopen(STORE, "r+b");
+    uint32_t version = KEYSTORE_VERSION + 1;
+    require (f && fseek(f, 8, SEEK_SET) == 0 && fwrite(&version, 4, 1, f) == 1 && !fclose(f), "cannot patch store");
+    require (!keystore_open(&ks, STORE), "foreign version accepted");
+  }
+
+  /*  many public keys: cold start from the store against building each
+      context from its modulus */
+  for (i = 0; i < SYNTHETIC; ++i) {
+    for (j = 0; j < SYNTHETIC_BYTES; ++j) moduli[i][j] = (unsigned char)rand();
+    moduli[i][0] |= 0x80;
+    moduli[i][SYNTHETIC_BYTES - 1] |= 1;
+    memset(&synthetic[i], 0, sizeof synthetic[i]);
+    synthetic[i].n.p = moduli[i];
+    synthetic[i].n.len = SYNTHETIC_BYTES;
+    synthetic[i].e.p = e;
+    synthetic[i].e.len = sizeof e;
+  }
+  require (keystore_write(STORE, synthetic, SYNTHETIC), "keystore_write failed");
+
+  clock_t start = clock();
+  for (i = 0; i < SYNTHETIC; ++i) {
+    const uint32_t mark = arena_mark();
+    struct rsa_pub key;
+    require (rsa_pub_from_view(&key, &synthetic[i]), "rsa_pub_from_view failed");
+    arena_rollback(mark);
+  }
+  double built = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  start = clock();
+  require (keystore_open(&ks, STORE) && ks.h->count == SYNTHETIC, "keystore_open failed");
+  for (i = 0; i < SYNTHETIC; ++i) {
+    const struct keystore_record* r;
+    struct rsa_pub key;
+    keystore_id(moduli[i], SYNTHETIC_BYTES, id);
+    require ((r = keystore_find(&ks, id)) != NULL && keystore_pub(&ks, r, &key), "key not in store");
+  }
+  double mapped = (double)(clock() - start) / CLOCKS_PER_SEC;
+  for (i = 0; i < SYNTHETIC; i += 97) check_pub(&ks, &synthetic[i], m);
+  keystore_close(&ks);
+
+  printf("%u 2048-bit contexts: built %8.2f ms  mapped %8.2f ms\n", SYNTHETIC, 1e3 * built, 1e3 * mapped);
+
+  for (i = 0; i < 4; ++i) key_file_close(&files[i]);
+  arena_release();
+  printf("OK\n");
+  return 0;
+}
+#endif
@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "pkcs_oaep.h"
+#include "drbg.h"
+#include "sha256.h"
+#include "sha512.h"
+#include "util.h"
+
+#define BATCH 64
+#define ROUNDS 200
+#define K 256
+
+#ifdef OAEP_BATCH_MAIN
+int main()
+{
+  static const struct { const char* name; const struct hash* h; } hashes[] = {
+    { "sha1", &hash_sha1 }, { "sha256", &hash_sha256 }, { "sha512", &hash_sha512 }
+  };
+  static unsigned char messages[BATCH][K];
+  static unsigned char ems[BATCH * K];
+  const unsigned char* mp[BATCH];
+  uint32_t mLens[BATCH];
+  uint32_t i, j, r;
+
+  static unsigned char em[K];
+
+  if (!arena_init(NULL, 4 * K)) return 1;
+
+  for (i = 0; i < sizeof hashes / sizeof *hashes; ++i) {
+    const struct hash* h = hashes[i].h;
+    struct oaep_ctx o;
+    require (oaep_ctx_init(&o, h, K, (const unsigned char*)hashes[i].name, 4), "oaep_ctx_init failed");
+
+    /*  batch encodes match one-by-one encodes, for every message length,
+        when both draw their seeds from the same stream */
+    for (j = 0; j < BATCH; ++j) {
+      mLens[j] = (j * 37) % (K - 2 * h->len - 1);
+      for (r = 0; r < mLens[j]; ++r) messages[j][r] = (unsigned char)rand();
+      mp[j] = messages[j];
+    }
+    drbg_seed((const unsigned char*)"oaep_batch", 10);
+    require (pkcs_oaep_encode_batch(&o, BATCH, mp, mLens, ems) == 0, "batch encode failed");
+    drbg_seed((const unsigned char*)"oaep_batch", 10);
+    for (j = 0; j < BATCH; ++j) {
+      require (pkcs_oaep_encode(&o, messages[j], mLens[j], em) == 0, "encode failed");
+      require (memcmp(em, ems + j * K, K) == 0, "batch and single encodes differ");
+    }
+    mLens[0] = K - 2 * h->len - 1;
+    require (pkcs_oaep_encode_batch(&o, BATCH, mp, mLens, ems) == -1, "too long message accepted");
+    mLens[0] = 0;
+
+    clock_t start = clock();
+    for (r = 0; r < ROUNDS; ++r)
+      for (j = 0; j < BATCH; ++j)
+        pkcs_oaep_encode(&o, messages[j], mLens[j], em);
+    double single = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    for (r = 0; r < ROUNDS; ++r)
+      pkcs_oaep_encode_batch(&o, BATCH, mp, mLens, ems);
+    double batch = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf("%-6s  single %8.2f us/encode  batch %8.2f us/encode\n", hashes[i].name,
+           1e6 * single / (ROUNDS * BATCH), 1e6 * batch / (ROUNDS * BATCH));
+  }
+
+  arena_release();
+  printf("OK\n");
+  return 0;
+}
+#endif
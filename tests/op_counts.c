@@ -0,0 +1,164 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "drbg.h"
+#include "fixture.h"
+#include "pkcs_oaep.h"
+#include "rsa.h"
+#include "sha256.h"
+#include "util.h"
+
+/*  Counts the bignum and hash work of each RSA phase (build with
+    -DBN_COUNTERS, see `make counters`) and prices it for the H8S, where
+    nothing can be timed:
+
+      op_counts [KEYFILE]
+
+    The counts are exact for this build; the price is a model. Each count is
+    multiplied by the states one such operation takes, the defaults below
+    being read off compiled loops at each WORD_SIZE (the H8S multiplies 16 by
+    16 bits in hardware; 32 by 32 is a library call) and overridable with
+    -DBN_COST_MUL=... and so on. A hash is priced per block compressed, from
+    the instructions of one round and of one schedule word on the H8S (its
+    registers are 32 bits wide, rotations go 1 or 2 bits at a time, and
+    SHA-512 takes two of each); padding and copying are left out. */
+
+#ifndef BN_COUNTERS
+  #error "op_counts needs -DBN_COUNTERS"
+#endif
+
+#if (WORD_SIZE == 1)
+  #define BN_COST_DEFAULTS 20, 6, 4
+#elif (WORD_SIZE == 2)
+  #define BN_COST_DEFAULTS 36, 10, 6
+#else
+  #define BN_COST_DEFAULTS 120, 18, 10
+#endif
+static const uint32_t cost_defaults[] = { BN_COST_DEFAULTS };
+
+#ifndef BN_COST_MUL
+  #define BN_COST_MUL cost_defaults[0]
+#endif
+#ifndef BN_COST_ADD
+  #define BN_COST_ADD cost_defaults[1]
+#endif
+#ifndef BN_COST_SHIFT
+  #define BN_COST_SHIFT cost_defaults[2]
+#endif
+#ifndef BN_COST_BYTE
+  #define BN_COST_BYTE 2   /* states per byte moved */
+#endif
+#ifndef BN_COST_CALL
+  #define BN_COST_CALL 40  /* call, prologue and the require checks */
+#endif
+#ifndef BN_COST_SHA1_BLOCK
+  #define BN_COST_SHA1_BLOCK 6400     /* 80 rounds of ~60 states, 64 schedule words of ~24 */
+#endif
+#ifndef BN_COST_SHA256_BLOCK
+  #define BN_COST_SHA256_BLOCK 14400  /* 64 rounds of ~150, 48 schedule words of ~100 */
+#endif
+#ifndef BN_COST_SHA512_BLOCK
+  #define BN_COST_SHA512_BLOCK 48000  /* 80 rounds of ~400, 64 schedule words of ~250 */
+#endif
+#ifndef BN_COST_HZ
+  #define BN_COST_HZ 20000000ull
+#endif
+
+struct phase_key {
+  struct rsa_key_view v;
+  struct oaep_ctx o;
+  struct rsa_pub pub;
+  struct rsa_priv priv;
+  uint32_t k;
+  unsigned char msg[32];
+  unsigned char em[BN_MAX_BITS / 16], cipher[BN_MAX_BITS / 16], out[BN_MAX_BITS / 16];
+};
+
+static uint64_t cost_states(const struct bn_counters* c)
+{
+  uint64_t calls = 0;
+  for (uint32_t i = 0; i < BN_FN_COUNT; ++i) calls += c->calls[i];
+  return c->limb_mul * BN_COST_MUL + c->limb_add * BN_COST_ADD + c->limb_shift * BN_COST_SHIFT +
+         c->bytes_moved * BN_COST_BYTE + calls * BN_COST_CALL + c->blocks_sha1 * BN_COST_SHA1_BLOCK +
+         c->blocks_sha256 * BN_COST_SHA256_BLOCK + c->blocks_sha512 * BN_COST_SHA512_BLOCK;
+}
+
+static void report(const char* phase)
+{
+  const struct bn_counters c = bn_counters;
+  const uint64_t states = cost_states(&c);
+  uint32_t i;
+
+  printf("%s\n", phase);
+  printf("  limb_mul %12llu   limb_add %12llu   limb_shift %10llu   bytes_moved %10llu   karatsuba depth %u\n",
+         (unsigned long long)c.limb_mul, (unsigned long long)c.limb_add, (unsigned long long)c.limb_shift,
+         (unsigned long long)c.bytes_moved, c.karatsuba_max_depth);
+  printf("  calls:");
+  for (i = 0; i < BN_FN_COUNT; ++i)
+    if (c.calls[i]) printf(" %s %llu", bn_fn_names[i], (unsigned long long)c.calls[i]);
+  if (c.blocks_sha1 || c.blocks_sha256 || c.blocks_sha512)
+    printf("\n  hash blocks: sha1 %llu sha256 %llu sha512 %llu", (unsigned long long)c.blocks_sha1,
+           (unsigned long long)c.blocks_sha256, (unsigned long long)c.blocks_sha512);
+  printf("\n  H8S estimate: %llu states, %.1f ms at %.0f MHz\n", (unsigned long long)states,
+         1e3 * (double)states / (double)BN_COST_HZ, (double)BN_COST_HZ / 1e6);
+}
+
+#ifdef BN_COUNTS_MAIN
+int main(int argc, char** argv)
+{
+  static struct phase_key key;
+  struct key_file f;
+  uint32_t i;
+
+  if (!fixture_init(RSA_POOL_BYTES(BN_MAX_BITS / 2, WORD_SIZE) + RSA_PUB_BYTES(BN_MAX_BITS / 2, WORD_SIZE) +
+                    RSA_PRIV_BYTES(BN_MAX_BITS / 2, WORD_SIZE) + OAEP_CTX_BYTES(BN_MAX_BITS / 2), BN_MAX_BITS / 2))
+    return 1;
+  drbg_seed((const unsigned char*)"op_counts", 9);
+  for (i = 0; i < sizeof key.msg; ++i) key.msg[i] = (unsigned char)i;
+
+  fixture_key(argc > 1 ? argv[1] : "private.pem", &f, &key.v);
+  key.k = key.v.n.len;
+  printf("WORD_SIZE %u, %u-bit key; states: mul %u add %u shift %u byte %u call %u, "
+         "per block sha1 %u sha256 %u sha512 %u\n\n", WORD_SIZE, key.k * 8,
+         (unsigned)BN_COST_MUL, (unsigned)BN_COST_ADD, (unsigned)BN_COST_SHIFT, (unsigned)BN_COST_BYTE,
+         (unsigned)BN_COST_CALL, (unsigned)BN_COST_SHA1_BLOCK, (unsigned)BN_COST_SHA256_BLOCK,
+         (unsigned)BN_COST_SHA512_BLOCK);
+
+  bn_counters_reset();
+  require (rsa_pub_from_view(&key.pub, &key.v), "rsa_pub_init failed");
+  report("rsa_pub_init");
+
+  bn_counters_reset();
+  require (rsa_priv_init(&key.priv, &key.v), "rsa_priv_init failed");
+  report("rsa_priv_init");
+  require (oaep_ctx_init(&key.o, &hash_sha256, key.k, NULL, 0), "oaep_ctx_init failed");
+
+  bn_counters_reset();
+  require (pkcs_oaep_encode(&key.o, key.msg, sizeof key.msg, key.em) == 0, "encode failed");
+  report("pkcs_oaep_encode");
+
+  bn_counters_reset();
+  require (rsa_encrypt(key.em, key.k, key.v.n.p, key.k, key.pub.e, key.cipher) == 0, "rsa_encrypt failed");
+  report("rsa_encrypt (pow_mod)");
+
+  bn_counters_reset();
+  struct bn* m = bignum_tmp_get();
+  bignum_from_bytes(m, key.em, key.k);
+  require (rsa_encrypt_bn(&key.pub, m, key.cipher) == 0, "rsa_encrypt_bn failed");
+  bignum_tmp_put(m);
+  report("rsa_encrypt_bn (Montgomery)");
+
+  bn_counters_reset();
+  require (rsa_oaep_encrypt(&key.o, &key.pub, key.msg, sizeof key.msg, key.cipher) == 0, "rsa_oaep_encrypt failed");
+  report("rsa_oaep_encrypt");
+
+  bn_counters_reset();
+  require (rsa_decrypt_crt(&key.priv, key.cipher, key.k, key.out) == 0, "rsa_decrypt_crt failed");
+  report("rsa_decrypt_crt");
+
+  key_file_close(&f);
+  arena_release();
+  return 0;
+}
+#endif
@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fixture.h"
+#include "pem.h"
+#include "rsa.h"
+#include "util.h"
+
+#define KEYSTORE "build/keystore.pem"
+#define KEYSTORE_KEYS 20000
+
+/* Reference encoder, wrapping lines every `wrap` characters */
+static uint32_t base64_encode(const unsigned char* in, uint32_t len, char* out, uint32_t wrap)
+{
+  static const char abc[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  uint32_t i, o = 0, col = 0;
+
+  for (i = 0; i < len; i += 3) {
+    uint32_t acc = (uint32_t)in[i] << 16 | (i + 1 < len ? (uint32_t)in[i + 1] << 8 : 0) |
+                   (i + 2 < len ? in[i + 2] : 0);
+    char q[4] = { abc[acc >> 18], abc[(acc >> 12) & 63], abc[(acc >> 6) & 63], abc[acc & 63] };
+    if (i + 1 >= len) q[2] = '=';
+    if (i + 2 >= len) q[3] = '=';
+    for (uint32_t j = 0; j < 4; ++j) {
+      out[o++] = q[j];
+      if (++col == wrap) {
+        out[o++] = '\n';
+        col = 0;
+      }
+    }
+  }
+  return o;
+}
+
+static bool view_eq(struct der_view a, struct der_view b)
+{
+  return a.len == b.len && !memcmp(a.p, b.p, a.len);
+}
+
+#ifdef PEM_LOAD_MAIN
+int main()
+{
+  static unsigned char raw[1024], back[1400];
+  static char text[1400];
+  struct key_file files[6];
+  struct rsa_key_view keys[6];
+  uint32_t i, len, wrap;
+
+  /*  base64 against the reference encoder, every length and line width */
+  srand(1);
+  for (len = 0; len < 600; ++len)
+    for (wrap = 0; wrap <= 76; wrap += 4) {
+      for (i = 0; i < len; ++i) raw[i] = (unsigned char)rand();
+      uint32_t tlen = base64_encode(raw, len, text, wrap ? wrap : 4096);
+      require (base64_decode(text, tlen, back) == (int32_t)len, "wrong decoded length");
+      require (!memcmp(raw, back, len), "wrong decoded bytes");
+      require (base64_decode(text, tlen, (unsigned char*)text) == (int32_t)len, "in place decode failed");
+      require (!memcmp(raw, text, len), "wrong in place bytes");
+    }
+  require (base64_decode("QUJD\nRA==", 9, back) == 4 && !memcmp(back, "ABCD", 4), "padding");
+  require (base64_decode("QUJDRA=", 7, back) == -1, "short padding accepted");
+  require (base64_decode("QUJDRA==QUJD", 12, back) == -1, "data after padding accepted");
+  require (base64_decode("QUJDRABCDEFGHIJK*LMN", 20, back) == -1, "bad character accepted");
+  require (base64_decode("QUJDR", 5, back) == -1, "unpadded tail accepted");
+
+  /*  the same key through PKCS#1 private, SPKI and PKCS#1 public PEM */
+  fixture_key("private.pem", &files[0], &keys[0]);
+  fixture_key("tests/keys/public.pem", &files[1], &keys[1]);
+  fixture_key("tests/keys/public_rsa.pem", &files[2], &keys[2]);
+  require (keys[0].n.len == 256 && keys[0].d.len && keys[0].qinv.len, "private key fields");
+  for (i = 1; i < 3; ++i) {
+    require (view_eq(keys[0].n, keys[i].n) && view_eq(keys[0].e, keys[i].e), "moduli differ");
+    require (!keys[i].d.len, "public key with a private exponent");
+  }
+
+  /*  and the 1024-bit one through PKCS#1 PEM, DER and PKCS#8 */
+  fixture_key("private_1024.pem", &files[3], &keys[3]);
+  fixture_key("tests/keys/private_1024.der", &files[4], &keys[4]);
+  fixture_key("tests/keys/private_1024_pkcs8.pem", &files[5], &keys[5]);
+  require (keys[3].n.len == 128, "1024-bit modulus");
+  for (i = 4; i < 6; ++i)
+    require (view_eq(keys[3].n, keys[i].n) && view_eq(keys[3].d, keys[i].d) &&
+             view_eq(keys[3].p, keys[i].p) && view_eq(keys[3].qinv, keys[i].qinv),
+             "private keys differ");
+
+  /*  a context built from a view encrypts like the byte API */
+  {
+    unsigned char m[256] = { 0 }, c1[256], c2[256];
+    struct rsa_pub pub;
+    struct bn* bm;
+
+    if (!fixture_init(2 * RSA_PUB_BYTES(2048, WORD_SIZE) + RSA_POOL_BYTES(2048, WORD_SIZE), 2048)) return 1;
+    require (rsa_pub_from_view(&pub, &keys[1]), "rsa_pub_from_view failed");
+    for (i = 1; i < 256; ++i) m[i] = (unsigned char)rand();
+    require (rsa_encrypt(m, 256, keys[0].n.p, 256, pub.e, c1) == 0, "rsa_encrypt failed");
+    bm = bignum_tmp_get();
+    bignum_from_bytes(bm, m, 256);
+    require (rsa_encrypt_bn(&pub, bm, c2) == 0 && !memcmp(c1, c2, 256), "view and byte keys differ");
+    bignum_tmp_put(bm);
+    arena_release();
+  }
+
+  /*  a keystore of many PEM blocks, with one of another type in between */
+  {
+    static char block[2][512];
+    uint32_t blen[2], n = 0;
+    FILE* fp = fopen(KEYSTORE, "wb");
+    require (fp, "cannot write " KEYSTORE);
+    for (i = 0; i < 2; ++i) {
+      FILE* in = fopen(i ? "tests/keys/public_rsa.pem" : "tests/keys/public.pem", "rb");
+      blen[i] = (uint32_t)fread(block[i], 1, sizeof block[i], in);
+      fclose(in);
+    }
+    for (i = 0; i < KEYSTORE_KEYS; ++i) {
+      fwrite(block[i & 1], 1, blen[i & 1], fp);
+      if (i == KEYSTORE_KEYS / 2) fputs("-----BEGIN CERTIFICATE-----\nAAAA\n-----END CERTIFICATE-----\n", fp);
+    }
+    fclose(fp);
+
+    struct key_file store;
+    struct rsa_key_view key;
+    int r;
+    clock_t start = clock();
+    require (key_file_open(&store, KEYSTORE), "cannot open keystore");
+    while ((r = key_file_next(&store, &key)) == 1) {
+      require (view_eq(key.n, keys[0].n), "keystore modulus differs");
+      ++n;
+    }
+    key_file_close(&store);
+    double ms = 1e3 * (double)(clock() - start) / CLOCKS_PER_SEC;
+    require (r == 0 && n == KEYSTORE_KEYS, "keystore not read to the end");
+    printf("keystore: %u keys in %.2f ms\n", n, ms);
+    remove(KEYSTORE);
+  }
+
+  for (i = 0; i < 6; ++i) key_file_close(&files[i]);
+  printf("OK\n");
+  return 0;
+}
+#endif
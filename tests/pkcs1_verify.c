@@ -0,0 +1,164 @@
+#if defined(__linux__) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 199309L /* clock_gettime */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "drbg.h"
+#include "fixture.h"
+#include "pkcs1_v15.h"
+#include "rsa.h"
+#include "sha256.h"
+#include "sha512.h"
+#include "util.h"
+
+/*  Checks rsa_verify_pkcs1_v15 on private.pem (`make pkcs1_verify`):
+    OpenSSL's signatures verify and tampered ones do not, and a batch of
+    BATCH signatures, every seventh of them bad, gets the same verdicts as
+    one-by-one calls for any number of threads. Both are timed.
+
+      pkcs1_verify [THREADS]                                               */
+
+#define BATCH 512
+#define K 256
+
+static const unsigned char kat_msg[] = "PKCS#1 v1.5 known answer";
+
+/*  openssl dgst -<hash> -sign private.pem */
+static const struct { const struct hash* h; const char* sig; } kats[] = {
+  { &hash_sha256,
+    "e569694e8a624ba5ef2ce13dcb62b8c192b6c7bdeb8bdac5812ee1b91bddeec0b19acdea3a6f779902285cccc3bf5f2d"
+    "ccfba3530a7ecd9659f996a1668cf0ecc68abd4459725903232fc0a0df47cde2ee9503c8029c0e9d2c106346ac2cba9c"
+    "3d430ba217593026bbd54e69ccbf17d263d3d5faee6a76be67f1290cfea7909de3eaf99a8bbd2e190ee856a83367a4e1"
+    "e2824eb39ac66b6dd50a5cb3bc269819c9d7150ac89619693994b7b9ccfe36cb047d9654c3affaae6073bd781fc15fd1"
+    "f6b9543ac35764b14891273f0885083c3d9572866e66cc6e4d8015d72c0db90e44129871d4d797c45394bb13e4d0e6e7"
+    "24290cf981c455d931b51a247148baab" },
+  { &hash_sha1,
+    "486dafe30df8edd2d8129d307de7c8d4f53a5accdaa4126627aff31d25189bef7a6855ecf03b78a7aedfb465add1ac3e"
+    "06d8801b9eeb8e4036f92367217d23193ac241c36a4fdba6aa1dbdf8a37b7ec5d8035617bbd0943e8edbf1e0ee16c45f"
+    "f9fcbb4918ba8bdea28c73ae26795cf058b6ab112c5b06357c7d6cb760c2b854ef26747b2414089e065c4cd820eb5d8a"
+    "55eebc42e0ab5367e190d70131b642c3fa7839a8536d060d2a179fb618482894d14e1ac23c4eb27ef12545a580e07023"
+    "fca312f1588ddd11998f5e14e7344b951b785ba22bf3d0ce7a50069b1b98537d336ce4315bef445f8a0cb332c4875500"
+    "c0d272c878bfb1ffdbb63f5e5b1605ba" },
+  { &hash_sha512,
+    "41c4e53006fb0d24cb30debd33712a2f2be39896d500edff677bc5acc043d00d1a610be8a79c06b53702bd6e400170f9"
+    "3c96ae23864aa96349984c91ba64a9382a0c49c4bab53cabd3c56be6d0adb3d11904d41f70bacd01a8194476738a3d2c"
+    "69a19005fcb3b3aec7c656b00d6aeb7128c180cc954b59dbc7d3ec44f4a4b66fb13ce14367958d4f471271542bb514b8"
+    "ee8b8aba85a02825ce9bdb936dcae8afd4a591a6b610cf2039fcf574f6a11eea3e71febd043fd06e2352b4d06c52d229"
+    "1ae12c34927557e50eb5f558f1afd0bf8d9b1ac87ec5f5c06f32e595e9dbbf11b51479555ce454f251cf32f89be6fc5c"
+    "f5f826cc426eb85e8540159969137276" },
+};
+
+/*  SHA-256's DigestInfo prefix, for the signatures made here */
+static const unsigned char sha256_info[] = {
+  0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x01, 0x05, 0x00, 0x04, 0x20
+};
+
+static unsigned char digests[BATCH][SHA256_HASH_LEN], sigs[BATCH][K];
+
+static void from_hex(const char* hex, uint32_t len, unsigned char* out)
+{
+  uint32_t i;
+  for (i = 0; i < len; ++i) {
+    unsigned int b;
+    require (sscanf(hex + 2 * i, "%2x", &b) == 1, "bad hex");
+    out[i] = (unsigned char)b;
+  }
+}
+
+static uint64_t now_ns(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (uint64_t)t.tv_sec * 1000000000ull + (uint64_t)t.tv_nsec;
+}
+
+#ifdef PKCS1_VERIFY_MAIN
+int main(int argc, char** argv)
+{
+  static const unsigned char* dp[BATCH];
+  static const unsigned char* sp[BATCH];
+  static int single[BATCH], batch[BATCH];
+  const uint32_t threads = argc > 1 ? (uint32_t)atoi(argv[1]) : 4;
+  unsigned char sig[K], digest[HASH_MAX_LEN], em[K];
+  struct rsa_key_view v;
+  struct rsa_pub pub;
+  struct rsa_priv priv;
+  struct pkcs1_ctx c;
+  struct key_file f;
+  uint32_t i, j, t, valid = 0;
+  uint64_t start;
+
+  if (!fixture_init(RSA_POOL_BYTES(2048, WORD_SIZE) + RSA_PUB_BYTES(2048, WORD_SIZE) + RSA_PRIV_BYTES(2048, WORD_SIZE) +
+                    (1 + sizeof kats / sizeof *kats) * PKCS1_CTX_BYTES(2048, WORD_SIZE), 2048))
+    return 1;
+  drbg_seed((const unsigned char*)"pkcs1_verify", 12);
+
+  fixture_key("private.pem", &f, &v);
+  require (rsa_pub_from_view(&pub, &v) && rsa_priv_init(&priv, &v), "key setup failed");
+  require (pub.nlen == K, "private.pem is not a 2048-bit key");
+
+  for (i = 0; i < sizeof kats / sizeof *kats; ++i) {
+    const struct hash* h = kats[i].h;
+    require (pkcs1_ctx_init(&c, h, K), "pkcs1_ctx_init failed");
+    from_hex(kats[i].sig, K, sig);
+    h->digest(kat_msg, sizeof kat_msg - 1, digest);
+    require (rsa_verify_pkcs1_v15(&c, &pub, digest, sig, K) == 0, "OpenSSL signature rejected");
+    require (rsa_verify_pkcs1_v15(&c, &pub, digest, sig, K - 1) == -1, "short signature accepted");
+    require (rsa_verify_pkcs1_v15(&c, &pub, digest, v.n.p, K) == -1, "s >= n accepted");
+    for (j = 0; j < K; j += 29) {
+      sig[j] ^= 0x04;
+      require (rsa_verify_pkcs1_v15(&c, &pub, digest, sig, K) == -1, "tampered signature accepted");
+      sig[j] ^= 0x04;
+    }
+    for (j = 0; j < h->len; ++j) {
+      digest[j] ^= 0x80;
+      require (rsa_verify_pkcs1_v15(&c, &pub, digest, sig, K) == -1, "other digest accepted");
+      digest[j] ^= 0x80;
+    }
+  }
+  require (!pkcs1_ctx_init(&c, &hash_sha512, 64 + 19 + 10), "key too small for the hash accepted");
+
+  /*  signatures made here through the CRT, every seventh then spoilt */
+  require (pkcs1_ctx_init(&c, &hash_sha256, K), "pkcs1_ctx_init failed");
+  for (i = 0; i < BATCH; ++i) {
+    require (drbg_bytes(digests[i], sizeof digests[i]), "drbg failed");
+    em[0] = 0x00;
+    em[1] = 0x01;
+    memset(em + 2, 0xff, K - 3 - sizeof sha256_info - SHA256_HASH_LEN);
+    em[K - 1 - sizeof sha256_info - SHA256_HASH_LEN] = 0x00;
+    memcpy(em + K - sizeof sha256_info - SHA256_HASH_LEN, sha256_info, sizeof sha256_info);
+    memcpy(em + K - SHA256_HASH_LEN, digests[i], SHA256_HASH_LEN);
+    require (rsa_decrypt_crt(&priv, em, K, sigs[i]) == 0, "signing failed");
+    if (i % 7 == 3) sigs[i][i % K] ^= 1;
+    if (i % 7 == 5) digests[i][i % SHA256_HASH_LEN] ^= 1;
+    dp[i] = digests[i];
+    sp[i] = sigs[i];
+  }
+
+  start = now_ns();
+  for (i = 0; i < BATCH; ++i) {
+    single[i] = rsa_verify_pkcs1_v15(&c, &pub, dp[i], sp[i], K);
+    valid += !single[i];
+    require (!single[i] == (i % 7 != 3 && i % 7 != 5), "wrong verdict");
+  }
+  const double one = (double)(now_ns() - start) / BATCH;
+
+  for (t = 1; t <= threads; t *= 2) {
+    memset(batch, 0x55, sizeof batch);
+    start = now_ns();
+    require (rsa_verify_pkcs1_v15_batch(&c, &pub, BATCH, dp, sp, batch, t) == valid, "batch miscounted");
+    const double many = (double)(now_ns() - start) / BATCH;
+    require (!memcmp(single, batch, sizeof batch), "batch and single verdicts differ");
+    printf("threads %2u  single %8.2f us/verify  batch %8.2f us/verify  %5.2fx\n", t, one / 1e3, many / 1e3, one / many);
+  }
+
+  key_file_close(&f);
+  arena_release();
+  printf("OK\n");
+  return 0;
+}
+#endif
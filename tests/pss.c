@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "drbg.h"
+#include "fixture.h"
+#include "pkcs_pss.h"
+#include "rsa.h"
+#include "sha256.h"
+#include "sha512.h"
+#include "util.h"
+
+/*  Checks RSASSA-PSS on private.pem (`make pss`): signatures made by
+    OpenSSL verify, and so do ours, for every hash and salt length; tampered
+    ones, other messages and the wrong salt length do not. A payload of
+    PAYLOAD bytes is hashed in pieces on both sides. */
+
+#define PAYLOAD (4u << 20)
+#define PIECE 65521
+
+static const unsigned char kat_msg[] = "RSASSA-PSS known answer";
+
+/*  openssl dgst -<hash> -sigopt rsa_padding_mode:pss -sigopt rsa_pss_saltlen:<slen> -sign private.pem */
+static const struct { const struct hash* h; uint32_t slen; const char* sig; } kats[] = {
+  { &hash_sha256, 32,
+  "415555ab20c449ba0fa3697c41d8fc83f2ee401f75653a60feaf48d2f213fbd1b6146081b701d1bc3cb5425664260c72"
+  "c03b1dd8e9ca2502f0b02763d4977389f707265091b9f39a0033c1dd6a7d0f5a82dbd6d285a3396f412c3f1e749929ee"
+  "21898a9fb2a194dd9b657d02669c9efac8806cd74486b2d16365355214880002ce31548a183a90f770ab90f3305ff791"
+  "b3ee709d26e4be37686a930e0bba11b5bfe37c6971fed73968a286f78c5132f003d0852f60fb57ebe37ccc236476b0c4"
+  "c6bd5ac76fc20c6011aba69762216b343df8108b3830f33bc2e8c0a4473c0985d60ebac85eecefde13bf6f154b26a9e5"
+  "499d4f3567ee7d6eb9374173317ae18d" },
+  { &hash_sha1, 0,
+  "d0f6d0bcc9cfafd5d21a49f36f54fd42c20065f6b2f5d6ba67dc56e8845220a70c76176bd8e7db8b6417913f37b93560"
+  "22cc4a41575ef1b4e6ef8969e554fbf4eaf2bde93ab831e996eae308d6f1e8f5f122cb4ee0a9feba1b4019f4ea702439"
+  "0081684a30ea4aadc0d773a7d2c9587fcffdfa04db82422244e326a2703157f78a669c659772e7e2a6a6dde8f1425185"
+  "675ddc18d875b89ad54d2b6d9e0dbb87f861e82dad30226d2b9c6030145617baa85e220d96744f7f93b2e73817f49976"
+  "6668674683643bf5f094be8d29ccf7b4a4209cf44ed4be1266b7568803b8555082c8bb94f64fb28519731f0ed4270246"
+  "ff75274025c49fdd525d5ec3c0a52ca7" },
+  { &hash_sha512, 64,
+  "972b555c9fe509d0ec1e55953e7315e220d832eceb4f1567133e19272ecb96668e20123d713a6c315e8ec3db70af35e6"
+  "d6105f2bef2a98bf96be41c1836d39b1306ba5ed482bff039f0225acfbf7c2b9454f23c445fc54d2adf065b56947b310"
+  "2f9d6df6c3b1008698e80ef61a61a53e84d47672e1d4780cc9099b930dacebb11e7c20fdc88815392477ec76e12fd012"
+  "94adca8c132ed49484cc170ffaf90df1449e30f0666b6c844ef5d24547d63b72ea89a29210a82aef2e38fcd0b967a79d"
+  "64669df3ed6dc5717ff0199480fd7e26806d106a37680940986bb94193bd7d937a676c9f4e731944452c3dbd36db6477"
+  "ed22b8eaefbecf54cc3f274ad36b6f8a" },
+};
+
+static unsigned char payload[PAYLOAD];
+
+static void from_hex(const char* hex, uint32_t len, unsigned char* out)
+{
+  uint32_t i;
+  for (i = 0; i < len; ++i) {
+    unsigned int b;
+    require (sscanf(hex + 2 * i, "%2x", &b) == 1, "bad hex");
+    out[i] = (unsigned char)b;
+  }
+}
+
+#ifdef PSS_MAIN
+int main()
+{
+  static const struct hash* const hashes[] = { &hash_sha1, &hash_sha256, &hash_sha512 };
+  unsigned char sig[256], sig2[256];
+  struct rsa_key_view v;
+  struct rsa_pub pub;
+  struct rsa_priv priv;
+  struct key_file f;
+  struct pss_ctx p;
+  uint32_t i, j, k;
+
+  if (!fixture_init(RSA_POOL_BYTES(2048, WORD_SIZE) + RSA_PUB_BYTES(2048, WORD_SIZE) +
+                    RSA_PRIV_BYTES(2048, WORD_SIZE), 2048))
+    return 1;
+  drbg_seed((const unsigned char*)"pss", 3);
+
+  fixture_key("private.pem", &f, &v);
+  require (rsa_pub_from_view(&pub, &v) && rsa_priv_init(&priv, &v), "key setup failed");
+  k = pub.nlen;
+  require (k == sizeof sig, "private.pem is not a 2048-bit key");
+
+  for (i = 0; i < sizeof kats / sizeof *kats; ++i) {
+    const struct hash* h = kats[i].h;
+    from_hex(kats[i].sig, k, sig);
+    require (rsa_pss_verify(h, &pub, kats[i].slen, kat_msg, sizeof kat_msg - 1, sig, k) == 0, "OpenSSL signature rejected");
+    require (rsa_pss_verify(h, &pub, kats[i].slen + 1, kat_msg, sizeof kat_msg - 1, sig, k) == -1, "wrong salt length accepted");
+    require (rsa_pss_verify(h, &pub, kats[i].slen, kat_msg, sizeof kat_msg - 2, sig, k) == -1, "other message accepted");
+    require (rsa_pss_verify(h, &pub, kats[i].slen, kat_msg, sizeof kat_msg - 1, sig, k - 1) == -1, "short signature accepted");
+    for (j = 0; j < k; j += 37) {
+      sig[j] ^= 0x10;
+      require (rsa_pss_verify(h, &pub, kats[i].slen, kat_msg, sizeof kat_msg - 1, sig, k) == -1, "tampered signature accepted");
+      sig[j] ^= 0x10;
+    }
+    /*  s = n is out of range */
+    require (rsa_pss_verify(h, &pub, kats[i].slen, kat_msg, sizeof kat_msg - 1, v.n.p, k) == -1, "s >= n accepted");
+  }
+
+  /*  our signatures, from no salt to the longest the key takes */
+  for (i = 0; i < sizeof hashes / sizeof *hashes; ++i) {
+    const struct hash* h = hashes[i];
+    const uint32_t slens[] = { 0, h->len, k - h->len - 2 };
+    for (j = 0; j < sizeof slens / sizeof *slens; ++j) {
+      require (rsa_pss_sign(h, &priv, slens[j], kat_msg, sizeof kat_msg - 1, sig) == 0, "rsa_pss_sign failed");
+      require (rsa_pss_verify(h, &pub, slens[j], kat_msg, sizeof kat_msg - 1, sig, k) == 0, "own signature rejected");
+      require (rsa_pss_sign(h, &priv, slens[j], kat_msg, sizeof kat_msg - 1, sig2) == 0, "rsa_pss_sign failed");
+      require (!slens[j] == !memcmp(sig, sig2, k), "salted signatures repeat, or unsalted ones differ");
+    }
+    require (rsa_pss_sign(h, &priv, k - h->len - 1, kat_msg, sizeof kat_msg - 1, sig) == -1, "oversized salt accepted");
+  }
+
+  /*  a large payload, streamed in on both sides in different pieces */
+  for (i = 0; i < PAYLOAD; ++i) payload[i] = (unsigned char)(i * 131 + (i >> 12));
+  rsa_pss_init(&p, &hash_sha256);
+  for (i = 0; i < PAYLOAD; i += PIECE) rsa_pss_update(&p, payload + i, PAYLOAD - i < PIECE ? PAYLOAD - i : PIECE);
+  require (rsa_pss_sign_final(&p, &priv, 32, sig) == 0, "streamed signing failed");
+  require (rsa_pss_verify(&hash_sha256, &pub, 32, payload, PAYLOAD, sig, k) == 0, "streamed signature rejected");
+  rsa_pss_init(&p, &hash_sha256);
+  for (i = 0; i < PAYLOAD; i += 1000) rsa_pss_update(&p, payload + i, PAYLOAD - i < 1000 ? PAYLOAD - i : 1000);
+  require (rsa_pss_verify_final(&p, &pub, 32, sig, k) == 0, "streamed verification failed");
+  payload[PAYLOAD / 2] ^= 1;
+  require (rsa_pss_verify(&hash_sha256, &pub, 32, payload, PAYLOAD, sig, k) == -1, "changed payload accepted");
+
+  key_file_close(&f);
+  arena_release();
+  printf("OK\n");
+  return 0;
+}
+#endif
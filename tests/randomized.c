@@ -1,90 +1,649 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <assert.h>
-#include <string.h>
-#include "bn.h"
-
-enum { ADD, SUB, MUL, DIV, AND, OR, XOR, POW, MOD, RSHFT, LSHFT };
-
-int main(int argc, char** argv)
-{
-
-  if (argc < 5)
-  {
-    printf("ERROR\n\nUsage:\n    %s [oper] [operand1] [operand2] [result]\n\nWhere oper means:\n    0 = add, 1 = sub, 2 = mul, 3 = div\n\nExample:\n    %s 3 0100 80 02\n\n    [divide 0x0100 by 0x80 and expect 0x02 as result] \n\n", argv[0], argv[0]);
-
-    return -1;
-  }  
-
-  int oper = atoi(argv[1]);
-
-/*
-  printf("program  = %s \n", argv[0]);
-  printf("operator = %s [%d]\n", argv[1], oper);
-  printf("operand1 = %s \n", argv[2]);
-  printf("operand2 = %s \n", argv[3]);
-  printf("expected = %s \n", argv[4]);
-*/
-
-  struct bn a, b, c, res;
-
-  bignum_init(&a);
-  bignum_init(&b);
-  bignum_init(&c);
-  bignum_init(&res);
-  bignum_from_string(&a, argv[2], strlen(argv[2]));
-  bignum_from_string(&b, argv[3], strlen(argv[3]));
-  bignum_from_string(&c, argv[4], strlen(argv[4]));
-
-  struct bn a_before, b_before;
-  bignum_assign(&a_before, &a);
-  bignum_assign(&b_before, &b);
-
-
-  switch (oper)
-  {
-    case ADD:   bignum_add(&a, &b, &res);   break;
-    case SUB:   bignum_sub(&a, &b, &res);   break;
-    case MUL:   bignum_mul(&a, &b, &res);   break;
-    case DIV:   bignum_div(&a, &b, &res);   break;
-    case AND:   bignum_and(&a, &b, &res);   break;
-    case OR:    bignum_or (&a, &b, &res);   break;
-    case XOR:   bignum_xor(&a, &b, &res);   break;
-    case POW:   bignum_pow(&a, &b, &res);   break;
-    case MOD:   bignum_mod(&a, &b, &res);   break;
-
-    case RSHFT:
-    {
-      bignum_rshift(&a, &res, bignum_to_int(&b));
-    } break;
-    case LSHFT: 
-    {
-      bignum_lshift(&a, &res, bignum_to_int(&b));
-    } break;
-
-    default:
-      printf("default switch-case hit: unknown operator '%d' \n", oper);
-      assert(0); 
-  }
-
-  int cmp_result = (bignum_cmp(&res, &c) == EQUAL);
-
-  if (!cmp_result)
-  {
-    char buf[8192];
-    bignum_to_string(&res, buf, sizeof(buf));
-    printf("\ngot %s\n", buf);
-    printf(" a  = %d \n", bignum_to_int(&a));
-    printf(" b  = %d \n", bignum_to_int(&b));
-    printf("res = %d \n", bignum_to_int(&res));
-    printf("\n");
-    return 1;
-  }
-
-  //assert(bignum_cmp(&a_before, &a) == EQUAL);
-  assert(bignum_cmp(&b_before, &b) == EQUAL);
-
-  return 0;
-}
-
-
+#if defined(__linux__) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L /* clock_gettime, flockfile */
+#endif
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bn.h"
+#include "util.h"
+
+/*  Differential test of the bignum kernels, in process and on every core:
+
+      randomized [CASES [THREADS [SEED]]]
+
+    Each case draws an operation and operands of any size the build holds
+    (smaller sizes more often, where the edge cases are) and checks the
+    kernel against a reference that is deliberately simple: 32-bit words,
+    schoolbook everything, bit-serial Montgomery reduction. There is no
+    reference division: a quotient and remainder from the library are
+    accepted when q * b + r == a and r < b, which only the right ones pass.
+
+    Operands are drawn as bytes, the same for every WORD_SIZE, and each case
+    hashes what the library returned; the digest printed at the end is their
+    sum, so builds of different WORD_SIZE agree on it when their kernels
+    agree on every result (`make randomized` checks that). Exponentiations
+    mostly use small moduli, to keep the reference quick, and now and then
+    ones of RSA size. Needs -DARENA_PER_THREAD. */
+
+#ifndef ARENA_PER_THREAD
+  #error "randomized needs -DARENA_PER_THREAD"
+#endif
+
+#define WIDE_BYTES (BN_MAX_BITS / 8 - 4)   /* sums, shifts and dividends */
+#define HALF_BYTES (BN_MAX_BITS / 16 - 2)  /* factors and moduli */
+#define EXP_BYTES 64                       /* moduli of most exponentiations */
+#define EXP_RSA_RATE 32                    /* 1 in this many is of RSA size */
+#define CHAIN_STEPS 48
+#define REF_WORDS (BN_MAX_BITS / 32 + 4)
+#define MAX_THREADS 64
+#define MAX_REPORTS 8
+
+/* The reference: little-endian 32-bit words, n of them in use */
+struct ref {
+  uint32_t w[REF_WORDS];
+  uint32_t n;
+};
+
+static void ref_norm(struct ref* r)
+{
+  while (r->n && !r->w[r->n - 1]) --r->n;
+}
+
+static void ref_from_bytes(struct ref* r, const unsigned char* be, uint32_t len)
+{
+  uint32_t i;
+  memset(r, 0, sizeof *r);
+  for (i = 0; i < len; ++i) r->w[i / 4] |= (uint32_t)be[len - 1 - i] << (8 * (i % 4));
+  r->n = (len + 3) / 4;
+  ref_norm(r);
+}
+
+/* Minimal big-endian bytes, at least one */
+static uint32_t ref_to_bytes(const struct ref* r, unsigned char* be)
+{
+  uint32_t len = 4 * r->n, i;
+  while (len > 1 && !(r->w[(len - 1) / 4] >> (8 * ((len - 1) % 4)) & 0xff)) --len;
+  for (i = 0; i < len; ++i) be[len - 1 - i] = (unsigned char)(r->w[i / 4] >> (8 * (i % 4)));
+  return len;
+}
+
+/* Limb by limb, so that neither side goes through bignum_to/from_bytes */
+static void ref_from_bn(struct ref* r, const struct bn* x)
+{
+  uint32_t i;
+  memset(r, 0, sizeof *r);
+  for (i = 0; i < (uint32_t)x->len * WORD_SIZE; ++i)
+    r->w[i / 4] |= (uint32_t)((x->array[i / WORD_SIZE] >> (8 * (i % WORD_SIZE))) & 0xff) << (8 * (i % 4));
+  r->n = ((uint32_t)x->len * WORD_SIZE + 3) / 4;
+  ref_norm(r);
+}
+
+static void ref_to_limbs(const struct ref* r, DTYPE* limbs, uint32_t nlimbs)
+{
+  uint32_t i;
+  memset(limbs, 0, nlimbs * WORD_SIZE);
+  for (i = 0; i < 4 * r->n && i < nlimbs * WORD_SIZE; ++i)
+    limbs[i / WORD_SIZE] |= (DTYPE)((DTYPE)((r->w[i / 4] >> (8 * (i % 4))) & 0xff) << (8 * (i % WORD_SIZE)));
+}
+
+static void ref_to_bn(struct bn* x, const struct ref* r)
+{
+  bignum_init(x);
+  ref_to_limbs(r, x->array, BN_ARRAY_SIZE);
+  x->len = (uint16_t)((4 * r->n + WORD_SIZE - 1) / WORD_SIZE);
+  while (x->len && !x->array[x->len - 1]) --x->len;
+}
+
+static int ref_cmp(const struct ref* a, const struct ref* b)
+{
+  uint32_t i;
+  if (a->n != b->n) return a->n > b->n ? LARGER : SMALLER;
+  for (i = a->n; i--;)
+    if (a->w[i] != b->w[i]) return a->w[i] > b->w[i] ? LARGER : SMALLER;
+  return EQUAL;
+}
+
+static void ref_add(struct ref* c, const struct ref* a, const struct ref* b)
+{
+  const uint32_t n = a->n > b->n ? a->n : b->n;
+  uint64_t carry = 0;
+  uint32_t i;
+  for (i = 0; i < n; ++i) {
+    carry += (uint64_t)(i < a->n ? a->w[i] : 0) + (i < b->n ? b->w[i] : 0);
+    c->w[i] = (uint32_t)carry;
+    carry >>= 32;
+  }
+  c->w[n] = (uint32_t)carry;
+  c->n = n + 1;
+  ref_norm(c);
+}
+
+/* c = a - b, a >= b */
+static void ref_sub(struct ref* c, const struct ref* a, const struct ref* b)
+{
+  uint64_t borrow = 0;
+  uint32_t i;
+  for (i = 0; i < a->n; ++i) {
+    const uint64_t d = (uint64_t)a->w[i] - (i < b->n ? b->w[i] : 0) - borrow;
+    c->w[i] = (uint32_t)d;
+    borrow = d >> 63;
+  }
+  c->n = a->n;
+  ref_norm(c);
+}
+
+static void ref_mul(struct ref* c, const struct ref* a, const struct ref* b)
+{
+  struct ref t;
+  uint32_t i, j;
+  memset(&t, 0, sizeof t);
+  for (i = 0; i < a->n; ++i) {
+    uint64_t carry = 0;
+    for (j = 0; j < b->n; ++j) {
+      carry += (uint64_t)a->w[i] * b->w[j] + t.w[i + j];
+      t.w[i + j] = (uint32_t)carry;
+      carry >>= 32;
+    }
+    t.w[i + b->n] = (uint32_t)carry;
+  }
+  t.n = a->n + b->n;
+  ref_norm(&t);
+  *c = t;
+}
+
+static void ref_shl(struct ref* c, const struct ref* a, uint32_t k)
+{
+  struct ref t;
+  uint32_t i;
+  memset(&t, 0, sizeof t);
+  for (i = 0; i < 32 * a->n; ++i)
+    if (a->w[i / 32] >> (i % 32) & 1) t.w[(i + k) / 32] |= 1u << ((i + k) % 32);
+  t.n = a->n + (k + 31) / 32;
+  ref_norm(&t);
+  *c = t;
+}
+
+static void ref_shr(struct ref* c, const struct ref* a, uint32_t k)
+{
+  struct ref t;
+  uint32_t i;
+  memset(&t, 0, sizeof t);
+  for (i = k; i < 32 * a->n; ++i)
+    if (a->w[i / 32] >> (i % 32) & 1) t.w[(i - k) / 32] |= 1u << ((i - k) % 32);
+  t.n = a->n;
+  ref_norm(&t);
+  *c = t;
+}
+
+/* t / 2^bits mod n, one bit at a time: add n when odd, halve */
+static void ref_redc(struct ref* t, const struct ref* n, uint32_t bits)
+{
+  while (bits--) {
+    if (t->n && (t->w[0] & 1)) ref_add(t, t, n);
+    ref_shr(t, t, 1);
+  }
+  if (ref_cmp(t, n) != SMALLER) ref_sub(t, t, n);
+}
+
+
+/* One thread's state */
+struct worker {
+  pthread_t thread;
+  uint64_t first, step, count, seed;
+  uint64_t digest;
+  uint64_t ops[16], ns[16];
+};
+
+static const char* const op_names[] = {
+  "add", "sub", "mul_naive", "mul_karatsuba", "div_mod", "lshift", "rshift", "cmp",
+  "bytes", "mont_mul", "mont_mod", "mont_exp", "mont_exp_chain",
+};
+#define NOPS (sizeof op_names / sizeof *op_names)
+
+static uint64_t failures;
+
+static uint64_t now_ns(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (uint64_t)t.tv_sec * 1000000000ull + (uint64_t)t.tv_nsec;
+}
+
+static uint64_t next(uint64_t* s)
+{
+  uint64_t z = (*s += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+/* 1 to max, every power of two as likely as the next */
+static uint32_t draw_len(uint64_t* s, uint32_t max)
+{
+  uint32_t bits = 0, span, len;
+  while ((1u << bits) < max) ++bits;
+  span = 1u << (next(s) % (bits + 1));
+  len = 1 + (uint32_t)(next(s) % span);
+  return len < max ? len : max;
+}
+
+/* len bytes, sometimes all ones, all zeros or long runs of either */
+static void draw_bytes(uint64_t* s, unsigned char* be, uint32_t len)
+{
+  const uint32_t shape = (uint32_t)(next(s) % 8);
+  uint32_t i;
+  for (i = 0; i < len; ++i) {
+    const uint64_t r = next(s);
+    be[i] = shape == 0 ? 0xff : shape == 1 ? (i ? 0 : 1) : shape == 2 ? (r & 4 ? 0xff : 0) : (unsigned char)r;
+  }
+}
+
+static void draw(uint64_t* s, struct ref* r, uint32_t max)
+{
+  unsigned char be[BN_MAX_BITS / 8];
+  const uint32_t len = draw_len(s, max);
+  draw_bytes(s, be, len);
+  ref_from_bytes(r, be, len);
+}
+
+static void fnv(uint64_t* h, const void* p, uint32_t len)
+{
+  const unsigned char* b = p;
+  while (len--) *h = (*h ^ *b++) * 0x100000001b3ull;
+}
+
+static void hash_ref(uint64_t* h, const struct ref* r)
+{
+  unsigned char be[4 * REF_WORDS];
+  fnv(h, be, ref_to_bytes(r, be));
+}
+
+static void hash_bn(uint64_t* h, const struct bn* x)
+{
+  struct ref r;
+  ref_from_bn(&r, x);
+  hash_ref(h, &r);
+}
+
+static void print_ref(const char* name, const struct ref* r)
+{
+  unsigned char be[4 * REF_WORDS];
+  const uint32_t len = ref_to_bytes(r, be);
+  uint32_t i;
+  fprintf(stderr, "  %s = ", name);
+  for (i = 0; i < len; ++i) fprintf(stderr, "%02x", be[i]);
+  fprintf(stderr, "\n");
+}
+
+static bool fail(uint64_t c, uint32_t op, const char* what, const struct ref* a, const struct ref* b)
+{
+  if (__atomic_fetch_add(&failures, 1, __ATOMIC_RELAXED) < MAX_REPORTS) {
+    flockfile(stderr);
+    fprintf(stderr, "case %llu, %s: %s\n", (unsigned long long)c, op_names[op], what);
+    if (a) print_ref("a", a);
+    if (b) print_ref("b", b);
+    funlockfile(stderr);
+  }
+  return false;
+}
+
+/* x holds r, with its length trimmed as bignum_cmp expects */
+static bool same(const struct bn* x, const struct ref* r)
+{
+  struct ref t;
+  if (x->len > BN_ARRAY_SIZE || (x->len && !x->array[x->len - 1])) return false;
+  ref_from_bn(&t, x);
+  return ref_cmp(&t, r) == EQUAL;
+}
+
+/* q and r are a / b and a % b: q * b + r == a and r < b */
+static bool divides(const struct ref* a, const struct ref* b, const struct ref* q, const struct ref* r)
+{
+  struct ref t;
+  if (ref_cmp(r, b) != SMALLER) return false;
+  ref_mul(&t, q, b);
+  ref_add(&t, &t, r);
+  return ref_cmp(&t, a) == EQUAL;
+}
+
+/* c = a * b mod n through bignum_div/bignum_mod, false if they are wrong */
+static bool mulmod(struct ref* c, const struct ref* a, const struct ref* b, const struct ref* n)
+{
+  struct bn *x = bignum_tmp_get(), *y = bignum_tmp_get(), *z = bignum_tmp_get();
+  struct ref p, q;
+  bool ok;
+  ref_mul(&p, a, b);
+  ref_to_bn(x, &p);
+  ref_to_bn(y, n);
+  bignum_div(x, y, z);
+  ref_from_bn(&q, z);
+  bignum_mod(x, y, z);
+  ref_from_bn(c, z);
+  ok = divides(&p, n, &q, c);
+  bignum_tmp_put(z);
+  bignum_tmp_put(y);
+  bignum_tmp_put(x);
+  return ok;
+}
+
+/* An odd modulus of len bytes, its first byte nonzero, and two numbers
+   below it */
+static uint32_t modulus_of_len(uint64_t* s, struct ref* n, struct ref* x, struct ref* y, uint32_t len)
+{
+  unsigned char be[BN_MAX_BITS / 8];
+  draw_bytes(s, be, len);
+  be[0] |= 1;
+  be[len - 1] |= 1;
+  ref_from_bytes(n, be, len);
+  be[0] = (unsigned char)(next(s) % be[0]);
+  draw_bytes(s, be + 1, len - 1);
+  ref_from_bytes(x, be, len);
+  be[0] = (unsigned char)(next(s) % (be[0] + 1));
+  draw_bytes(s, be + 1, len - 1);
+  ref_from_bytes(y, be, len);
+  if (ref_cmp(y, n) != SMALLER) *y = *x;
+  return len;
+}
+
+/* The same of up to max bytes */
+static uint32_t draw_modulus(uint64_t* s, struct ref* n, struct ref* x, struct ref* y, uint32_t max)
+{
+  return modulus_of_len(s, n, x, y, draw_len(s, max));
+}
+
+/* A modulus for an exponentiation: mostly small, now and then the size of
+   the primes of an RSA key of half or all of BN_MAX_BITS */
+static uint32_t draw_exp_modulus(uint64_t* s, struct ref* n, struct ref* x, struct ref* y)
+{
+  uint32_t len;
+  if (next(s) % EXP_RSA_RATE) return draw_modulus(s, n, x, y, EXP_BYTES);
+  len = next(s) & 1 ? HALF_BYTES : HALF_BYTES / 2;
+  return modulus_of_len(s, n, x, y, len);
+}
+
+/* Runs case c, adding its result to the digest; false on a mismatch */
+static bool run_case(struct worker* w, uint64_t c)
+{
+  static __thread struct bn a, b, q, r;
+  static __thread DTYPE nl[BN_ARRAY_SIZE / 2], rr[BN_ARRAY_SIZE / 2], xl[BN_ARRAY_SIZE / 2], yl[BN_ARRAY_SIZE / 2];
+  struct ref ra, rb, rc, rd;
+  uint64_t s = w->seed ^ (c * 0xd1342543de82ef95ull), h = 0xcbf29ce484222325ull, t0;
+  const uint32_t op = (uint32_t)(next(&s) % NOPS);
+  uint32_t k;
+  bool ok = true;
+
+  t0 = now_ns();
+  switch (op) {
+  case 0: case 1:  /* add, sub, now and then into an operand */
+    draw(&s, &ra, WIDE_BYTES);
+    draw(&s, &rb, WIDE_BYTES);
+    if (op == 1 && ref_cmp(&ra, &rb) == SMALLER) {
+      rc = ra;
+      ra = rb;
+      rb = rc;
+    }
+    ref_to_bn(&a, &ra);
+    ref_to_bn(&b, &rb);
+    if (op == 0) ref_add(&rc, &ra, &rb);
+    else ref_sub(&rc, &ra, &rb);
+    k = (uint32_t)(next(&s) % 4);
+    if (op == 0) bignum_add(&a, &b, k == 0 ? &a : k == 1 ? &b : &q);
+    else bignum_sub(&a, &b, k == 0 ? &a : k == 1 ? &b : &q);
+    ok = same(k == 0 ? &a : k == 1 ? &b : &q, &rc) || fail(c, op, "wrong result", &ra, &rb);
+    hash_bn(&h, k == 0 ? &a : k == 1 ? &b : &q);
+    break;
+
+  case 2: case 3:
+    draw(&s, &ra, HALF_BYTES);
+    draw(&s, &rb, HALF_BYTES);
+    ref_to_bn(&a, &ra);
+    ref_to_bn(&b, &rb);
+    if (op == 2) bignum_mul_naive(&a, &b, &q);
+    else bignum_mul_karatsuba(&a, &b, &q);
+    ref_mul(&rc, &ra, &rb);
+    ok = same(&q, &rc) || fail(c, op, "wrong product", &ra, &rb);
+    ok = ok && ((same(&a, &ra) && same(&b, &rb)) || fail(c, op, "operand changed", &ra, &rb));
+    hash_bn(&h, &q);
+    break;
+
+  case 4:
+    draw(&s, &ra, WIDE_BYTES);
+    do draw(&s, &rb, WIDE_BYTES); while (!rb.n);
+    ref_to_bn(&a, &ra);
+    ref_to_bn(&b, &rb);
+    bignum_div(&a, &b, &q);
+    bignum_mod(&a, &b, &r);
+    ref_from_bn(&rc, &q);
+    ref_from_bn(&rd, &r);
+    ok = (same(&q, &rc) && same(&r, &rd) && divides(&ra, &rb, &rc, &rd)) || fail(c, op, "q * b + r != a", &ra, &rb);
+    ok = ok && ((same(&a, &ra) && same(&b, &rb)) || fail(c, op, "operand changed", &ra, &rb));
+    hash_bn(&h, &q);
+    hash_bn(&h, &r);
+    break;
+
+  case 5: case 6:  /* bignum_lshift shifts its input too: only b is checked */
+    draw(&s, &ra, op == 5 ? WIDE_BYTES - 8 : WIDE_BYTES);
+    k = (uint32_t)(next(&s) % (op == 5 ? 8 * (WIDE_BYTES - 4 * ra.n) : 32 * ra.n + 40));
+    ref_to_bn(&a, &ra);
+    if (op == 5) {
+      bignum_lshift(&a, &b, (int)k);
+      ref_shl(&rc, &ra, k);
+    } else {
+      bignum_rshift(&a, &b, (int)k);
+      ref_shr(&rc, &ra, k);
+    }
+    ok = same(&b, &rc) || fail(c, op, "wrong shift", &ra, NULL);
+    fnv(&h, &k, 4);
+    hash_bn(&h, &b);
+    break;
+
+  case 7:  /* equal, one bit apart, or unrelated */
+    draw(&s, &ra, WIDE_BYTES);
+    k = (uint32_t)(next(&s) % 3);
+    if (k == 0) rb = ra;
+    else if (k == 1 && ra.n) {
+      const uint32_t bit = (uint32_t)(next(&s) % (32 * ra.n));
+      rb = ra;
+      rb.w[bit / 32] ^= 1u << (bit % 32);
+      ref_norm(&rb);
+    } else {
+      draw(&s, &rb, WIDE_BYTES);
+    }
+    ref_to_bn(&a, &ra);
+    ref_to_bn(&b, &rb);
+    {
+      const int got = bignum_cmp(&a, &b), want = ref_cmp(&ra, &rb);
+      ok = got == want || fail(c, op, "wrong order", &ra, &rb);
+      fnv(&h, &got, sizeof got);
+    }
+    break;
+
+  case 8: {  /* from and to bytes, with zero padding on both sides */
+    unsigned char be[BN_MAX_BITS / 8], out[BN_MAX_BITS / 8], want[BN_MAX_BITS / 8];
+    const uint32_t len = draw_len(&s, WIDE_BYTES), pad = (uint32_t)(next(&s) % 4);
+    draw_bytes(&s, be, len);
+    if (next(&s) & 1) memset(be, 0, (uint32_t)(next(&s) % len));
+    ref_from_bytes(&ra, be, len);
+    bignum_from_bytes(&a, be, len);
+    ok = same(&a, &ra) || fail(c, op, "bignum_from_bytes", &ra, NULL);
+    memcpy(b.array, be, len);
+    bignum_from_bytes_in_place(&b, len);
+    ok = ok && (same(&b, &ra) || fail(c, op, "bignum_from_bytes_in_place", &ra, NULL));
+    if (len + pad <= sizeof out) {
+      memset(want, 0, pad);
+      memcpy(want + pad, be, len);
+      bignum_to_bytes(&a, out, len + pad);
+      ok = ok && (!memcmp(out, want, len + pad) || fail(c, op, "bignum_to_bytes", &ra, NULL));
+      fnv(&h, out, len + pad);
+    }
+    hash_bn(&h, &a);
+    hash_bn(&h, &b);
+    break;
+  }
+
+  case 9: case 10: case 11: case 12: {
+    struct bn_mont m;
+    const uint32_t len = op < 11 ? draw_modulus(&s, &rc, &ra, &rb, HALF_BYTES) : draw_exp_modulus(&s, &rc, &ra, &rb);
+    const uint16_t sl = (uint16_t)((len + WORD_SIZE - 1) / WORD_SIZE);
+
+    ref_to_limbs(&rc, nl, sl);
+    bignum_mont_init(&m, nl, sl, rr);
+    ref_to_limbs(&ra, xl, sl);
+    ref_to_limbs(&rb, yl, sl);
+
+    if (op == 9) {  /* x y / R, then back out of the form: x y mod n */
+      bignum_mont_mul_limbs(&m, xl, yl, xl);
+      ref_mul(&rd, &ra, &rb);
+      ref_redc(&rd, &rc, 8 * WORD_SIZE * sl);
+      bignum_from_limbs(&a, xl, sl);
+      ok = same(&a, &rd) || fail(c, op, "x y / R", &ra, &rb);
+      bignum_mont_mul_limbs(&m, xl, rr, xl);
+      bignum_from_limbs(&a, xl, sl);
+      ok = ok && (mulmod(&rd, &ra, &rb, &rc) || fail(c, op, "bignum_div/bignum_mod", &ra, &rb));
+      ok = ok && (same(&a, &rd) || fail(c, op, "x y mod n", &ra, &rb));
+      hash_bn(&h, &a);
+    } else if (op == 10) {  /* a < n R: a product of two numbers below n */
+      struct ref one;
+      ref_mul(&rd, &ra, &rb);
+      ref_to_bn(&a, &rd);
+      bignum_mont_mod(&m, &a, &b);
+      ref_from_bytes(&one, (const unsigned char*)"\1", 1);
+      ok = mulmod(&rd, &rd, &one, &rc) || fail(c, op, "bignum_div/bignum_mod", &ra, &rb);
+      ok = ok && (same(&b, &rd) || fail(c, op, "a mod n", &ra, &rb));
+      hash_bn(&h, &b);
+    } else if (op == 11) {  /* x^e, e of 1 to 4 bytes, against square and multiply; the
+                               constant-time kernel too */
+      unsigned char eb[4];
+      DTYPE el[4];
+      struct ref re, acc;
+      const uint32_t elen = 1 + (uint32_t)(next(&s) % 4);
+      draw_bytes(&s, eb, elen);
+      ref_from_bytes(&re, eb, elen);
+      ref_to_limbs(&re, el, (elen + WORD_SIZE - 1) / WORD_SIZE);
+      bignum_mont_exp_limbs(&m, xl, el, (uint16_t)((elen + WORD_SIZE - 1) / WORD_SIZE), yl);
+      bignum_from_limbs(&a, yl, sl);
+      ref_from_bytes(&acc, (const unsigned char*)"\1", 1);
+      for (k = 32 * re.n; k-- && ok;) {
+        ok = mulmod(&acc, &acc, &acc, &rc);
+        if (ok && (re.w[k / 32] >> (k % 32) & 1)) ok = mulmod(&acc, &acc, &ra, &rc);
+      }
+      if (!ok) fail(c, op, "bignum_div/bignum_mod", &ra, &re);
+      /*  x^0 is 1, and 1 mod 1 is 0 */
+      if (ok && rc.n == 1 && rc.w[0] == 1) acc.n = 0;
+      ok = ok && (same(&a, &acc) || fail(c, op, "x^e mod n", &ra, &re));
+      ref_to_bn(&q, &ra);
+      bignum_mont_exp_ct(&m, &q, el, (uint16_t)((elen + WORD_SIZE - 1) / WORD_SIZE), &b);
+      ok = ok && (same(&b, &acc) || fail(c, op, "x^e mod n, constant time", &ra, &re));
+      hash_bn(&h, &a);
+      hash_bn(&h, &b);
+    } else {  /* a random addition chain, its steps replayed on the reference */
+      unsigned char chain[1 + CHAIN_STEPS];
+      struct ref pw[1 << (BN_CHAIN_MAX_WINDOW - 1)], x2, acc;
+      const uint32_t win = 1 + (uint32_t)(next(&s) % BN_CHAIN_MAX_WINDOW);
+      const uint32_t steps = 1 + (uint32_t)(next(&s) % CHAIN_STEPS);
+
+      /*  x, x^3, ..., x^(2^w - 1) */
+      pw[0] = ra;
+      ok = mulmod(&x2, &ra, &ra, &rc);
+      for (k = 1; ok && k < 1u << (win - 1); ++k) ok = mulmod(&pw[k], &pw[k - 1], &x2, &rc);
+
+      /*  a load, then squarings two times in three */
+      chain[0] = (unsigned char)win;
+      for (k = 1; ok && k <= steps; ++k) {
+        const uint32_t j = (uint32_t)(next(&s) % (1u << (win - 1)));
+        if (k > 1 && next(&s) % 3) {
+          chain[k] = 0;
+          ok = mulmod(&acc, &acc, &acc, &rc);
+        } else {
+          chain[k] = (unsigned char)(2 * j + 1);
+          if (k == 1) acc = pw[j];
+          else ok = mulmod(&acc, &acc, &pw[j], &rc);
+        }
+      }
+      if (!ok) {
+        fail(c, op, "bignum_div/bignum_mod", &ra, NULL);
+        break;
+      }
+      ref_to_bn(&q, &ra);
+      bignum_mont_exp_chain(&m, &q, chain, (uint16_t)(steps + 1), &b);
+      ok = same(&b, &acc) || fail(c, op, "chain mod n", &ra, NULL);
+      hash_bn(&h, &b);
+    }
+    break;
+  }
+  }
+  w->ns[op] += now_ns() - t0;
+  ++w->ops[op];
+  fnv(&h, &op, sizeof op);
+  w->digest += h;
+  return ok;
+}
+
+static void* work(void* arg)
+{
+  struct worker* w = arg;
+  uint64_t c;
+
+  if (!arena_init(NULL, (BN_MOD_TEMPS(BN_ARRAY_SIZE) + 8) * ARENA_ROUND(sizeof(struct bn)))) return NULL;
+  bignum_pool_init(BN_MOD_TEMPS(BN_ARRAY_SIZE) + 8);
+  for (c = w->first; c < w->count; c += w->step) run_case(w, c);
+  arena_release();
+  return NULL;
+}
+
+#ifdef RANDOMIZED_MAIN
+int main(int argc, char** argv)
+{
+  static struct worker workers[MAX_THREADS];
+  const uint64_t cases = argc > 1 ? strtoull(argv[1], NULL, 0) : 1000000;
+  uint32_t threads = argc > 2 ? (uint32_t)atoi(argv[2]) : 4;
+  const uint64_t seed = argc > 3 ? strtoull(argv[3], NULL, 0) : 1;
+  uint64_t digest = 0, total_ops = 0, start;
+  uint32_t i, op;
+
+  if (threads < 1) threads = 1;
+  if (threads > MAX_THREADS) threads = MAX_THREADS;
+
+  /*  case c runs on thread c % threads: the same cases whatever the count */
+  start = now_ns();
+  for (i = 0; i < threads; ++i) {
+    workers[i].first = i;
+    workers[i].step = threads;
+    workers[i].count = cases;
+    workers[i].seed = seed;
+    require (pthread_create(&workers[i].thread, NULL, work, &workers[i]) == 0, "pthread_create failed");
+  }
+  for (i = 0; i < threads; ++i) pthread_join(workers[i].thread, NULL);
+  const double wall = (double)(now_ns() - start) / 1e9;
+
+  printf("WORD_SIZE %u, BN_MAX_BITS %u, %u threads, seed %llu\n", WORD_SIZE, BN_MAX_BITS, threads,
+         (unsigned long long)seed);
+  printf("%-14s %10s %14s\n", "op", "cases", "ops/s/thread");
+  for (op = 0; op < NOPS; ++op) {
+    uint64_t n = 0, ns = 0;
+    for (i = 0; i < threads; ++i) {
+      n += workers[i].ops[op];
+      ns += workers[i].ns[op];
+    }
+    total_ops += n;
+    printf("%-14s %10llu %14.0f\n", op_names[op], (unsigned long long)n, ns ? 1e9 * (double)n / (double)ns : 0.0);
+  }
+  for (i = 0; i < threads; ++i) digest += workers[i].digest;
+  printf("%llu cases in %.2f s, %.0f cases/s\n", (unsigned long long)total_ops, wall, (double)total_ops / wall);
+  printf("digest %016llx\n", (unsigned long long)digest);
+  if (total_ops != cases) {
+    printf("%llu cases did not run\n", (unsigned long long)(cases - total_ops));
+    return 1;
+  }
+  if (failures) {
+    printf("%llu FAILED\n", (unsigned long long)failures);
+    return 1;
+  }
+  printf("OK\n");
+  return 0;
+}
+#endif
@@ -0,0 +1,116 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "drbg.h"
+#include "fixture.h"
+#include "pkcs_oaep.h"
+#include "rsa.h"
+#include "sha256.h"
+#include "util.h"
+
+/*  Runs the pipeline with -DSTAGE_TIMERS (`make stages`): THREADS threads
+    OAEP-encode while the main thread encrypts and decrypts, a second wave
+    takes over their histograms, then the merged histograms are checked
+    against the number of calls and dumped.
+
+      stage_timers [JSON]                                                  */
+
+#ifndef STAGE_TIMERS
+  #error "stage_timers needs -DSTAGE_TIMERS"
+#endif
+
+#define THREADS 4
+#define ENCODES 2000
+#define ROUNDS 20
+#define OVERHEAD_REPS 1000000
+
+static struct oaep_ctx o;
+
+static void* encoder(void* arg)
+{
+  unsigned char em[256], msg[32] = { 0 };
+  uint32_t i;
+
+  drbg_seed((const unsigned char*)arg, (uint32_t)strlen(arg));
+  for (i = 0; i < ENCODES; ++i) {
+    msg[0] = (unsigned char)i;
+    require (pkcs_oaep_encode(&o, msg, sizeof msg, em) == 0, "encode failed");
+  }
+  return NULL;
+}
+
+#ifdef STAGE_TIMERS_MAIN
+int main(int argc, char** argv)
+{
+  static char names[THREADS][8];
+  static struct stage_hist h[STAGE_COUNT];
+  static unsigned char msg[32], cipher[256], out[256];
+  pthread_t threads[THREADS];
+  struct rsa_key_view v;
+  struct rsa_pub pub;
+  struct rsa_priv priv;
+  struct key_file f;
+  uint64_t start;
+  uint32_t i, entries;
+  FILE* json = stdout;
+
+  if (argc > 1 && !(json = fopen(argv[1], "w"))) return 1;
+  if (!fixture_init(RSA_POOL_BYTES(2048, WORD_SIZE) + RSA_PUB_BYTES(2048, WORD_SIZE) +
+                    RSA_PRIV_BYTES(2048, WORD_SIZE) + OAEP_CTX_BYTES(2048), 2048))
+    return 1;
+  drbg_seed((const unsigned char*)"stage_timers", 12);
+
+  /*  what one sample costs: two clock reads and the histogram update */
+  start = stage_clock();
+  for (i = 0; i < OVERHEAD_REPS; ++i) {
+    STAGE_BEGIN(t0);
+    STAGE_END(bytes, t0);
+  }
+  fprintf(stderr, "%.1f ns per sample\n", (double)(stage_clock() - start) / stage_ticks_per_ns() / OVERHEAD_REPS);
+  stage_reset();
+
+  fixture_key("private.pem", &f, &v);
+  require (rsa_pub_from_view(&pub, &v) && rsa_priv_init(&priv, &v), "key setup failed");
+  require (oaep_ctx_init(&o, &hash_sha256, v.n.len, NULL, 0), "oaep_ctx_init failed");
+
+  for (i = 0; i < THREADS; ++i) {
+    snprintf(names[i], sizeof names[i], "enc%u", i);
+    require (pthread_create(&threads[i], NULL, encoder, names[i]) == 0, "pthread_create failed");
+  }
+  for (i = 0; i < ROUNDS; ++i) {
+    msg[0] = (unsigned char)i;
+    require (rsa_oaep_encrypt(&o, &pub, msg, sizeof msg, cipher) == 0, "rsa_oaep_encrypt failed");
+    require (rsa_decrypt_crt(&priv, cipher, v.n.len, out) == 0, "rsa_decrypt_crt failed");
+  }
+  for (i = 0; i < THREADS; ++i) pthread_join(threads[i], NULL);
+
+  /*  a second wave adopts the entries the first one left behind */
+  entries = stage_thread_entries();
+  for (i = 0; i < THREADS; ++i)
+    require (pthread_create(&threads[i], NULL, encoder, names[i]) == 0, "pthread_create failed");
+  for (i = 0; i < THREADS; ++i) pthread_join(threads[i], NULL);
+  require (stage_thread_entries() == entries, "exited threads' entries not reused");
+
+  /*  every call was counted once, whichever thread made it */
+  stage_merge(h);
+  require (h[STAGE_oaep_hash].count == 1, "label hash miscounted");
+  require (h[STAGE_seed].count == 2 * THREADS * ENCODES + ROUNDS, "seeds miscounted");
+  require (h[STAGE_mgf1].count == 2 * (2 * THREADS * ENCODES + ROUNDS), "mgf1 miscounted");
+  require (h[STAGE_bytes].count == 4 * ROUNDS, "conversions miscounted");
+  require (h[STAGE_exp].count == 2 * ROUNDS, "exponentiations miscounted");
+  for (i = 0; i < STAGE_COUNT; ++i) {
+    uint64_t n = 0;
+    for (uint32_t b = 0; b < STAGE_BUCKETS; ++b) n += h[i].buckets[b];
+    require (n == h[i].count && (!n || h[i].min <= h[i].max), "histogram inconsistent");
+  }
+  require (stage_dump_json(json), "dump failed");
+
+  key_file_close(&f);
+  arena_release();
+  if (json != stdout) fclose(json);
+  fprintf(stderr, "OK\n");
+  return 0;
+}
+#endif